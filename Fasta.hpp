@@ -6,847 +6,10362 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
 #include <fstream>
+#include <functional>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <ostream>
-#include <regex>
 #include <set>
+#include <shared_mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FASTA_HAS_POSIX 1
+#endif
+
+// Vector kernels are selected at runtime on x86 and are always available on AArch64.
+// Define FASTA_DISABLE_SIMD to build with the scalar kernels only.
+#if !defined( FASTA_DISABLE_SIMD ) && ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( __GNUC__ )
+#include <immintrin.h>
+#define FASTA_HAS_X86_KERNELS 1
+#define FASTA_TARGET( features ) __attribute__(( target( features ) ))
+#elif !defined( FASTA_DISABLE_SIMD ) && defined( __aarch64__ ) && defined( __ARM_NEON )
+#include <arm_neon.h>
+#define FASTA_HAS_NEON_KERNELS 1
+#endif
+
+// 128-bit k-mers, for k up to 64, require a compiler providing unsigned __int128.
+#if defined( __SIZEOF_INT128__ )
+#define FASTA_HAS_INT128 1
+#endif
+
+// Compressed input requires zlib. Define FASTA_ENABLE_ZLIB and link with -lz to read gzip and BGZF
+// files; without it, compressed input is detected and rejected with ENOTSUP.
+#if defined( FASTA_ENABLE_ZLIB )
+#include <zlib.h>
+#define FASTA_HAS_ZLIB 1
+#endif
+
 /**
  * Notes:
  *   - Requires C++14 minimum
  *
  * Todo:
  *   - Add support for bare sequence files.
- *   - Set IUB/IUPC amino/nucleid acid codes.
- *   - Add detection if neither mode is set for the acid codes.
  *   - Fill in 'Any' between end of sequence and offset for mutable access.
  *   - Add `operator[]( string )` to FastaFile to access the vector of FastaSequence
  *   - If the identifier changes for a sequence in the file, then we need that change reflected.
  */
 
 /**
- * This class contains a single sequence and its associated identifier.
- * When assigning the identifier, control characters will be removed.
- * The sequence will be normalized by removing control characters and any
- * non-(amino/nucleic) characters.
+ * This class holds the byte kernels used on the hot paths of parsing and formatting.
+ * Each kernel has a scalar implementation and, where the platform supports it, vector
+ * implementations; the best one for the running CPU is chosen on first use.
+ * Valid sequence characters are the ASCII letters, '-' and '*', independent of the locale.
  */
-class FastaSequence
+class FastaKernels
 {
-private:
-	std::string mIdentifier;  // The sequence identifier.
-	std::string mSequence;    // Sequence.
-
-	void _copyAssign(
-		const FastaSequence& other )
+public:
+	/**
+	 * Instruction set used by the kernels.
+	 */
+	enum class Level
 	{
-		mIdentifier = other.mIdentifier;
-		mSequence = other.mSequence;
-	}
+		Scalar,
+		Sse2,
+		Ssse3,
+		Avx2,
+		Neon
+	};
 
-	void _moveAssign(
-		FastaSequence&& other )
+private:
+	// For each 8 bit mask of bytes to keep, the shuffle moving those bytes to the front
+	// of an 8 byte group (unused lanes are 0x80, which shuffles in zero) and their count.
+	struct CompactionTable
 	{
-		mIdentifier = std::move( other.mIdentifier );
-		mSequence = std::move( other.mSequence );
-	}
+		uint64_t shuffles[ 256 ];
+		uint8_t counts[ 256 ];
 
-	// Remove any control characters
-	void _normalizeIdentifier()
-	{
-		// Remove all non-print characters
-		mIdentifier.erase(
-			std::remove_if(
-				mIdentifier.begin(), mIdentifier.end(),
-				[ & ]( const unsigned char character )
-				{
-					return not std::isprint( character );
-				} ),
-			mIdentifier.end() );
+		CompactionTable()
+		{
+			for ( unsigned mask( 0 ); mask < 256; ++mask )
+			{
+				uint8_t shuffle[ 8 ];
+				uint8_t count( 0 );
 
-		// Remove the leading '>' if present
-		mIdentifier = mIdentifier.substr( '>' == mIdentifier[ 0 ] );
+				std::memset( shuffle, 0x80, sizeof( shuffle ) );
 
-		// Remove any leading whitespace
-		std::regex_replace( mIdentifier, std::regex( "^\\s+" ), std::string( "" ) );
+				for ( uint8_t bit( 0 ); bit < 8; ++bit )
+				{
+					if ( mask & ( 1u << bit ) )
+					{
+						shuffle[ count++ ] = bit;
+					}
+				}
 
-		// Remove any trailing whitespace
-		std::regex_replace( mIdentifier, std::regex( "\\s+$" ), std::string( "" ) );
-	}
+				std::memcpy( &shuffles[ mask ], shuffle, sizeof( shuffle ) );
+				counts[ mask ] = count;
+			}
+		}
+	};
 
-	// Returns true for valid sequence characters.
-	bool _isValidSequenceCharacter(
-		unsigned char character )
+	static const CompactionTable& _compactionTable()
 	{
-		return std::isalpha( character ) or ( '-' == character ) or ( '*' == character );
+		static const CompactionTable compactionTable;
+		return compactionTable;
 	}
 
-	// Remove control characters and
-	// any non-(amino/nucleic) characters.
-	void _normalizeSequence()
+	static Level _detectLevel()
 	{
-		mSequence.erase(
-			std::remove_if(
-				mSequence.begin(), mSequence.end(),
-				[ & ]( const unsigned char character )
-				{
-					return not _isValidSequenceCharacter( character );
-				} ),
-			mSequence.end() );
-	}
+#if defined( FASTA_HAS_X86_KERNELS )
+		__builtin_cpu_init();
 
-public:
-	/**
-	 * Default constructor.
-	 * @param identifier The header/sequence identifier to associate with the sequence. [default: ""]
-	 * @param sequence The genomic sequence. [default: ""]
-	 */
-	FastaSequence(
-		const std::string& identifier = std::string(),
-		const std::string& sequence = std::string() )
-	{
-		mIdentifier = identifier;
-		mSequence = sequence;
+		if ( __builtin_cpu_supports( "avx2" ) )
+		{
+			return Level::Avx2;
+		}
 
-		_normalizeIdentifier();
-		_normalizeSequence();
-	}
+		if ( __builtin_cpu_supports( "ssse3" ) )
+		{
+			return Level::Ssse3;
+		}
 
-	/**
-	 * Move constructor.
-	 * @param other R-Value to the FastaSequence to move to this instance.
-	 */
-	FastaSequence(
-		FastaSequence&& other )
-	{
-		_moveAssign( std::move( other ) );
+		if ( __builtin_cpu_supports( "sse2" ) )
+		{
+			return Level::Sse2;
+		}
+#elif defined( FASTA_HAS_NEON_KERNELS )
+		return Level::Neon;
+#endif
+
+		return Level::Scalar;
 	}
 
-	/**
-	 * Copy constructor.
-	 * @param other Const reference to the FastaSequence to copy to this instance.
-	 */
-	FastaSequence(
-		const FastaSequence& other )
+	static size_t _findInvalidScalar(
+		const char* data,
+		size_t length )
 	{
-		_copyAssign( other );
+		size_t offset( 0 );
+
+		while ( ( offset < length ) and isValidSequenceCharacter( data[ offset ] ) )
+		{
+			++offset;
+		}
+
+		return offset;
 	}
 
-	/**
-	 * Append a character to the sequence count times.
-	 * If the character to append is not a valid sequence character,
-	 * then nothing will be appended to the sequence.
-	 * @param character The character to append.
-	 * @param count The number of times to append the character. [default: 1]
-	 */
-	void append(
-		char character,
-		size_t count = 1 )
+	static size_t _compactScalar(
+		char* data,
+		size_t length )
 	{
-		if ( ( 0 < count ) and _isValidSequenceCharacter( character ) )
+		size_t kept( 0 );
+
+		for ( size_t offset( 0 ); offset < length; ++offset )
 		{
-			mSequence.append( count, character );
+			const char character = data[ offset ];
+			data[ kept ] = character;
+			kept += isValidSequenceCharacter( character );
 		}
+
+		return kept;
 	}
 
-	/**
-	 * Append characters from a c-string up to count characters
-	 * or up to the null character of the string, which ever comes first.
-	 * @param sequence The c-string to append characters from.
-	 * @param count The max number of characters to append. [default: -1]
-	 */
-	void append(
-		const char* sequence,
-		size_t count = -1 )
+	// The IUPAC complement of every character, keeping its case; other characters are their own complement.
+	// The vector kernels look the complement of a letter up by the low 5 bits of the letter.
+	struct ComplementTable
 	{
-		if ( ( 0 < count ) and ( nullptr != sequence ) )
+		char complement[ 256 ];
+		uint8_t lowLetters[ 16 ];  // Low 5 bits of the complement of the letters 0x00 to 0x0F.
+		uint8_t highLetters[ 16 ]; // Low 5 bits of the complement of the letters 0x10 to 0x1F.
+
+		ComplementTable()
 		{
-			size_t length = strlen( sequence );
-			count = ( count < length ) ? count : length;
-			mSequence.append( sequence, count );
+			const char* const bases = "ACGTURYSWKMBVDHN";
+			const char* const complements = "TGCAAYRSWMKVBHDN";
+
+			for ( unsigned character( 0 ); character < 256; ++character )
+			{
+				complement[ character ] = static_cast< char >( character );
+			}
+
+			for ( size_t base( 0 ); '\0' != bases[ base ]; ++base )
+			{
+				complement[ static_cast< uint8_t >( bases[ base ] ) ] = complements[ base ];
+				complement[ static_cast< uint8_t >( bases[ base ] | 0x20 ) ] = static_cast< char >( complements[ base ] | 0x20 );
+			}
+
+			for ( unsigned index( 0 ); index < 16; ++index )
+			{
+				lowLetters[ index ] = static_cast< uint8_t >( complement[ 0x40 | index ] & 0x1F );
+				highLetters[ index ] = static_cast< uint8_t >( complement[ 0x50 | index ] & 0x1F );
+			}
 		}
-	}
+	};
 
-	/**
-	 * Append characters from a std::string up to count characters.
-	 * @param sequence The std::string to append characters from.
-	 * @param count The max number of characters to append. [default: -1]
-	 */
-	void append(
-		const std::string& sequence,
-		size_t count = -1 )
+	static const ComplementTable& _complementTable()
 	{
-		this->append( sequence.c_str(), count );
+		static const ComplementTable complementTable;
+		return complementTable;
 	}
 
-	/**
-	 * Get the identifier for the sequence.
-	 * @return A const reference to the sequence identifier.
-	 */
-	const std::string& identifier() const
+	// Reverse complement [left, right) in place, swapping characters from both ends.
+	static void _reverseComplementScalar(
+		char* left,
+		char* right )
 	{
-		return mIdentifier;
+		const char* complement = _complementTable().complement;
+
+		while ( left < right )
+		{
+			const char character = complement[ static_cast< uint8_t >( *--right ) ];
+			*right = complement[ static_cast< uint8_t >( *left ) ];
+			*left++ = character;
+		}
 	}
 
-	/**
-	 * Get the length of the sequence.
-	 * @return The length of the sequence is returned.
-	 */
-	size_t length() const
+	// The characters of each packed byte: four 2-bit codes or two 4-bit codes, lowest bits first.
+	struct DecodingTable
 	{
-		return mSequence.length();
-	}
+		char twoBit[ 256 ][ 4 ];
+		char fourBit[ 256 ][ 2 ];
 
-	/**
-	 * The lexicographical ordering of sequences is first by the identifier, then the sequence.
-	 * @param rhs The right-hand side of the comparison.
-	 * @return True is returned if this instance goes before the RHS.
-	 */
-	bool operator<(
-		const FastaSequence& rhs ) const noexcept
+		DecodingTable()
+		{
+			for ( unsigned byte( 0 ); byte < 256; ++byte )
+			{
+				for ( unsigned lane( 0 ); lane < 4; ++lane )
+				{
+					twoBit[ byte ][ lane ] = twoBitCharacters()[ ( byte >> ( 2 * lane ) ) & 0x3 ];
+				}
+
+				fourBit[ byte ][ 0 ] = fourBitCharacters()[ byte & 0xF ];
+				fourBit[ byte ][ 1 ] = fourBitCharacters()[ byte >> 4 ];
+			}
+		}
+	};
+
+	static const DecodingTable& _decodingTable()
 	{
-		return ( mIdentifier == rhs.mIdentifier )
-			? mSequence < rhs.mSequence
-			: mIdentifier < rhs.mIdentifier;
+		static const DecodingTable decodingTable;
+		return decodingTable;
 	}
 
-	/**
-	 * The lexicographical ordering of sequences is first by the identifier, then the sequence.
-	 * @param rhs The right-hand side of the comparison.
-	 * @return True is returned if this instance goes before, or is equal to the RHS.
-	 */
-	bool operator<=(
-		const FastaSequence& rhs ) const noexcept
+	static void _decodeTwoBitScalar(
+		const uint8_t* bytes,
+		size_t byteCount,
+		char* destination )
 	{
-		return ( mIdentifier == rhs.mIdentifier )
-			? mSequence <= rhs.mSequence
-			: mIdentifier < rhs.mIdentifier;
+		const DecodingTable& table = _decodingTable();
+
+		for ( size_t offset( 0 ); offset < byteCount; ++offset )
+		{
+			std::memcpy( destination + 4 * offset, table.twoBit[ bytes[ offset ] ], 4 );
+		}
 	}
 
-	/**
-	 * The lexicographical ordering of sequences is first by the identifier, then the sequence.
-	 * @param rhs The right-hand side of the comparison.
-	 * @return True is returned if this instance goes after the RHS.
-	 */
-	bool operator>(
-		const FastaSequence& rhs ) const noexcept
+	static void _decodeFourBitScalar(
+		const uint8_t* bytes,
+		size_t byteCount,
+		char* destination )
 	{
-		return ( mIdentifier == rhs.mIdentifier )
-			? mSequence > rhs.mSequence
-			: mIdentifier > rhs.mIdentifier;
+		const DecodingTable& table = _decodingTable();
+
+		for ( size_t offset( 0 ); offset < byteCount; ++offset )
+		{
+			std::memcpy( destination + 2 * offset, table.fourBit[ bytes[ offset ] ], 2 );
+		}
 	}
 
-	/**
-	 * The lexicographical ordering of sequences is first by the identifier, then the sequence.
-	 * @param rhs The right-hand side of the comparison.
-	 * @return True is returned if this instance goes after, or is equal to the RHS.
-	 */
-	bool operator>=(
-		const FastaSequence& rhs ) const noexcept
+#if defined( FASTA_HAS_X86_KERNELS )
+	// Expand the 2-bit codes of 4 bytes into 16 characters. Each byte is split into its
+	// nibbles, every nibble is spread over the two lanes it encodes, and even and odd lanes
+	// are looked up from the low and high two bits of the nibble respectively.
+	FASTA_TARGET( "ssse3" )
+	static void _decodeTwoBitSsse3(
+		const uint8_t* bytes,
+		size_t byteCount,
+		char* destination )
 	{
-		return ( mIdentifier == rhs.mIdentifier )
-			? mSequence >= rhs.mSequence
-			: mIdentifier > rhs.mIdentifier;
+		const __m128i nibbleMask = _mm_set1_epi8( 0x0F );
+		const __m128i spread = _mm_setr_epi8( 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7 );
+		const __m128i evenLanes = _mm_set1_epi16( 0x00FF );
+		__m128i lowCodeTable, highCodeTable;
+		char lowCodes[ 16 ], highCodes[ 16 ];
+
+		for ( unsigned nibble( 0 ); nibble < 16; ++nibble )
+		{
+			lowCodes[ nibble ] = twoBitCharacters()[ nibble & 0x3 ];
+			highCodes[ nibble ] = twoBitCharacters()[ nibble >> 2 ];
+		}
+
+		lowCodeTable = _mm_loadu_si128( reinterpret_cast< const __m128i* >( lowCodes ) );
+		highCodeTable = _mm_loadu_si128( reinterpret_cast< const __m128i* >( highCodes ) );
+
+		size_t offset( 0 );
+
+		for ( ; offset + 4 <= byteCount; offset += 4 )
+		{
+			int32_t word;
+			std::memcpy( &word, bytes + offset, 4 );
+
+			const __m128i packed = _mm_cvtsi32_si128( word );
+			const __m128i nibbles = _mm_unpacklo_epi8(
+				_mm_and_si128( packed, nibbleMask ),
+				_mm_and_si128( _mm_srli_epi16( packed, 4 ), nibbleMask ) );
+			const __m128i codes = _mm_shuffle_epi8( nibbles, spread );
+			const __m128i characters = _mm_or_si128(
+				_mm_and_si128( evenLanes, _mm_shuffle_epi8( lowCodeTable, codes ) ),
+				_mm_andnot_si128( evenLanes, _mm_shuffle_epi8( highCodeTable, codes ) ) );
+
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( destination + 4 * offset ), characters );
+		}
+
+		_decodeTwoBitScalar( bytes + offset, byteCount - offset, destination + 4 * offset );
 	}
 
-	/**
-	 * Check for equality of both the identifier
-	 * and the sequence; returning true if both are equal.
-	 * @param other Const reference to the FastaSequence to compare against for equality.
-	 * @return True is returned if both the identifier and the sequence are equal.
-	 */
-	bool operator==(
-		const FastaSequence& other ) const
+	// Expand the 4-bit codes of 8 bytes into 16 characters.
+	FASTA_TARGET( "ssse3" )
+	static void _decodeFourBitSsse3(
+		const uint8_t* bytes,
+		size_t byteCount,
+		char* destination )
 	{
-		return ( mIdentifier == other.mIdentifier ) and ( mSequence == other.mSequence );
+		const __m128i nibbleMask = _mm_set1_epi8( 0x0F );
+		const __m128i codeTable = _mm_loadu_si128( reinterpret_cast< const __m128i* >( fourBitCharacters() ) );
+		size_t offset( 0 );
+
+		for ( ; offset + 8 <= byteCount; offset += 8 )
+		{
+			const __m128i packed = _mm_loadl_epi64( reinterpret_cast< const __m128i* >( bytes + offset ) );
+			const __m128i nibbles = _mm_unpacklo_epi8(
+				_mm_and_si128( packed, nibbleMask ),
+				_mm_and_si128( _mm_srli_epi16( packed, 4 ), nibbleMask ) );
+
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( destination + 2 * offset ),
+				_mm_shuffle_epi8( codeTable, nibbles ) );
+		}
+
+		_decodeFourBitScalar( bytes + offset, byteCount - offset, destination + 2 * offset );
 	}
 
-	/**
-	 * Check for inequality of either the identifier
-	 * or the sequence; returning true if either are not equal.
-	 * @param other Const reference to the FastaSequence to compare against for inequality.
-	 * @return True is returned if either the identifier or the sequence are not equal.
-	 */
-	bool operator!=(
-		const FastaSequence& other ) const
+	// 0xFF in each lane holding a valid sequence character.
+	FASTA_TARGET( "sse2" )
+	static __m128i _validLanes(
+		__m128i bytes )
 	{
-		return not this->operator==( other );
+		const __m128i letterOffset = _mm_sub_epi8( _mm_or_si128( bytes, _mm_set1_epi8( 0x20 ) ), _mm_set1_epi8( 'a' ) );
+		const __m128i isLetter = _mm_cmpeq_epi8( _mm_min_epu8( letterOffset, _mm_set1_epi8( 25 ) ), letterOffset );
+		const __m128i isGap = _mm_cmpeq_epi8( bytes, _mm_set1_epi8( '-' ) );
+		const __m128i isStop = _mm_cmpeq_epi8( bytes, _mm_set1_epi8( '*' ) );
+
+		return _mm_or_si128( isLetter, _mm_or_si128( isGap, isStop ) );
 	}
 
-	/**
-	 * Assign both the identifier and the sequence.
-	 * @param identifierAndSequence Const pair for both the identifier and the sequence.
-	 * @return Reference to this FastaSequence instance.
-	 */
-	FastaSequence& operator=(
-		const std::pair< std::string, std::string >& identifierAndSequence )
+	// Store the valid bytes of a 16 byte group at output, advancing output past them.
+	FASTA_TARGET( "ssse3" )
+	static void _compact16(
+		__m128i bytes,
+		unsigned mask,
+		char*& output )
 	{
-		mIdentifier = identifierAndSequence.first;
-		mSequence = identifierAndSequence.second;
+		const CompactionTable& table = _compactionTable();
+		const unsigned lowMask = mask & 0xFF;
+		const unsigned highMask = mask >> 8;
+		const __m128i lowShuffle = _mm_loadl_epi64( reinterpret_cast< const __m128i* >( &table.shuffles[ lowMask ] ) );
+		const __m128i highShuffle = _mm_add_epi8(
+			_mm_loadl_epi64( reinterpret_cast< const __m128i* >( &table.shuffles[ highMask ] ) ),
+			_mm_set1_epi8( 8 ) );
 
-		_normalizeIdentifier();
-		_normalizeSequence();
+		_mm_storel_epi64( reinterpret_cast< __m128i* >( output ), _mm_shuffle_epi8( bytes, lowShuffle ) );
+		output += table.counts[ lowMask ];
+		_mm_storel_epi64( reinterpret_cast< __m128i* >( output ), _mm_shuffle_epi8( bytes, highShuffle ) );
+		output += table.counts[ highMask ];
 	}
 
-	/**
-	 * Copy assignment operator.
-	 * @param other Const reference to the FastaSequence to copy to this instance.
-	 * @return Reference to this FastaSequence instance.
-	 */
-	FastaSequence& operator=(
-		const FastaSequence& other )
+	FASTA_TARGET( "sse2" )
+	static size_t _findInvalidSse2(
+		const char* data,
+		size_t length )
 	{
-		if ( this != &other )
+		size_t offset( 0 );
+
+		for ( ; offset + 16 <= length; offset += 16 )
 		{
-			_copyAssign( other );
+			const __m128i bytes = _mm_loadu_si128( reinterpret_cast< const __m128i* >( data + offset ) );
+			const unsigned invalid = ~static_cast< unsigned >( _mm_movemask_epi8( _validLanes( bytes ) ) ) & 0xFFFF;
+
+			if ( 0 != invalid )
+			{
+				return offset + __builtin_ctz( invalid );
+			}
 		}
 
-		return *this;
+		return offset + _findInvalidScalar( data + offset, length - offset );
 	}
 
-	/**
-	 * Move assignment operator.
-	 * @param other R-Value to the FastaSequence to move to this instance.
-	 * @return Reference to this FastaSequence instance.
-	 */
-	FastaSequence& operator=(
-		FastaSequence&& other )
+	FASTA_TARGET( "avx2" )
+	static size_t _findInvalidAvx2(
+		const char* data,
+		size_t length )
 	{
-		if ( this != &other )
+		size_t offset( 0 );
+
+		for ( ; offset + 32 <= length; offset += 32 )
 		{
-			_moveAssign( std::move( other ) );
-		}
+			const __m128i low = _mm_loadu_si128( reinterpret_cast< const __m128i* >( data + offset ) );
+			const __m128i high = _mm_loadu_si128( reinterpret_cast< const __m128i* >( data + offset + 16 ) );
+			const uint32_t invalid = ~( static_cast< uint32_t >( _mm_movemask_epi8( _validLanes( low ) ) )
+				| ( static_cast< uint32_t >( _mm_movemask_epi8( _validLanes( high ) ) ) << 16 ) );
+
+			if ( 0 != invalid )
+			{
+				return offset + __builtin_ctz( invalid );
+			}
+		}
+
+		return offset + _findInvalidSse2( data + offset, length - offset );
+	}
+
+	FASTA_TARGET( "ssse3" )
+	static size_t _compactSsse3(
+		char* data,
+		size_t length )
+	{
+		char* output = data;
+		size_t offset( 0 );
+
+		for ( ; offset + 16 <= length; offset += 16 )
+		{
+			const __m128i bytes = _mm_loadu_si128( reinterpret_cast< const __m128i* >( data + offset ) );
+			const unsigned mask = static_cast< unsigned >( _mm_movemask_epi8( _validLanes( bytes ) ) );
+
+			if ( 0xFFFF == mask )
+			{
+				_mm_storeu_si128( reinterpret_cast< __m128i* >( output ), bytes );
+				output += 16;
+			}
+			else
+			{
+				_compact16( bytes, mask, output );
+			}
+		}
+
+		const size_t kept = output - data;
+		std::memmove( output, data + offset, length - offset );
+
+		return kept + _compactScalar( output, length - offset );
+	}
+
+	FASTA_TARGET( "avx2" )
+	static size_t _compactAvx2(
+		char* data,
+		size_t length )
+	{
+		char* output = data;
+		size_t offset( 0 );
+
+		for ( ; offset + 32 <= length; offset += 32 )
+		{
+			const __m256i bytes = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( data + offset ) );
+			const __m256i letterOffset = _mm256_sub_epi8( _mm256_or_si256( bytes, _mm256_set1_epi8( 0x20 ) ), _mm256_set1_epi8( 'a' ) );
+			const __m256i isValid = _mm256_or_si256(
+				_mm256_cmpeq_epi8( _mm256_min_epu8( letterOffset, _mm256_set1_epi8( 25 ) ), letterOffset ),
+				_mm256_or_si256(
+					_mm256_cmpeq_epi8( bytes, _mm256_set1_epi8( '-' ) ),
+					_mm256_cmpeq_epi8( bytes, _mm256_set1_epi8( '*' ) ) ) );
+			const uint32_t mask = static_cast< uint32_t >( _mm256_movemask_epi8( isValid ) );
+
+			if ( 0xFFFFFFFFu == mask )
+			{
+				_mm256_storeu_si256( reinterpret_cast< __m256i* >( output ), bytes );
+				output += 32;
+			}
+			else
+			{
+				_compact16( _mm256_castsi256_si128( bytes ), mask & 0xFFFF, output );
+				_compact16( _mm256_extracti128_si256( bytes, 1 ), mask >> 16, output );
+			}
+		}
+
+		const size_t kept = output - data;
+		std::memmove( output, data + offset, length - offset );
+
+		return kept + _compactSsse3( output, length - offset );
+	}
+
+	// Complement the letters of 16 bytes and reverse their order. Each letter keeps its case
+	// bits and takes the low 5 bits of its complement from one of two 16 entry tables.
+	FASTA_TARGET( "ssse3" )
+	static __m128i _reverseComplement16(
+		__m128i bytes,
+		__m128i lowTable,
+		__m128i highTable )
+	{
+		const __m128i reverse = _mm_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 );
+		const __m128i letterOffset = _mm_sub_epi8( _mm_or_si128( bytes, _mm_set1_epi8( 0x20 ) ), _mm_set1_epi8( 'a' ) );
+		const __m128i isLetter = _mm_cmpeq_epi8( _mm_min_epu8( letterOffset, _mm_set1_epi8( 25 ) ), letterOffset );
+		const __m128i index = _mm_and_si128( bytes, _mm_set1_epi8( 0x0F ) );
+		const __m128i isHigh = _mm_cmpeq_epi8( _mm_and_si128( bytes, _mm_set1_epi8( 0x10 ) ), _mm_set1_epi8( 0x10 ) );
+		const __m128i low5 = _mm_or_si128(
+			_mm_andnot_si128( isHigh, _mm_shuffle_epi8( lowTable, index ) ),
+			_mm_and_si128( isHigh, _mm_shuffle_epi8( highTable, index ) ) );
+		const __m128i complement = _mm_or_si128( _mm_and_si128( bytes, _mm_set1_epi8( static_cast< char >( 0xE0 ) ) ), low5 );
+		const __m128i result = _mm_or_si128( _mm_and_si128( isLetter, complement ), _mm_andnot_si128( isLetter, bytes ) );
+
+		return _mm_shuffle_epi8( result, reverse );
+	}
+
+	FASTA_TARGET( "ssse3" )
+	static void _reverseComplementSsse3(
+		char* data,
+		size_t length )
+	{
+		const ComplementTable& table = _complementTable();
+		const __m128i lowTable = _mm_loadu_si128( reinterpret_cast< const __m128i* >( table.lowLetters ) );
+		const __m128i highTable = _mm_loadu_si128( reinterpret_cast< const __m128i* >( table.highLetters ) );
+		char* left = data;
+		char* right = data + length;
+
+		for ( ; right - left >= 32; left += 16, right -= 16 )
+		{
+			const __m128i front = _mm_loadu_si128( reinterpret_cast< const __m128i* >( left ) );
+			const __m128i back = _mm_loadu_si128( reinterpret_cast< const __m128i* >( right - 16 ) );
+
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( left ), _reverseComplement16( back, lowTable, highTable ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( right - 16 ), _reverseComplement16( front, lowTable, highTable ) );
+		}
+
+		_reverseComplementScalar( left, right );
+	}
+#endif
+
+#if defined( FASTA_HAS_NEON_KERNELS )
+	static uint8x16_t _validLanes(
+		uint8x16_t bytes )
+	{
+		const uint8x16_t letterOffset = vsubq_u8( vorrq_u8( bytes, vdupq_n_u8( 0x20 ) ), vdupq_n_u8( 'a' ) );
+
+		return vorrq_u8( vcltq_u8( letterOffset, vdupq_n_u8( 26 ) ),
+			vorrq_u8( vceqq_u8( bytes, vdupq_n_u8( '-' ) ), vceqq_u8( bytes, vdupq_n_u8( '*' ) ) ) );
+	}
+
+	static size_t _findInvalidNeon(
+		const char* data,
+		size_t length )
+	{
+		size_t offset( 0 );
+
+		for ( ; offset + 16 <= length; offset += 16 )
+		{
+			const uint8x16_t bytes = vld1q_u8( reinterpret_cast< const uint8_t* >( data + offset ) );
+
+			if ( 0xFF != vminvq_u8( _validLanes( bytes ) ) )
+			{
+				break;
+			}
+		}
+
+		return offset + _findInvalidScalar( data + offset, length - offset );
+	}
+
+	static size_t _compactNeon(
+		char* data,
+		size_t length )
+	{
+		static const uint8_t laneBits[ 8 ] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+		const CompactionTable& table = _compactionTable();
+		const uint8x8_t bits = vld1_u8( laneBits );
+		char* output = data;
+		size_t offset( 0 );
+
+		for ( ; offset + 16 <= length; offset += 16 )
+		{
+			const uint8x16_t bytes = vld1q_u8( reinterpret_cast< const uint8_t* >( data + offset ) );
+			const uint8x16_t isValid = _validLanes( bytes );
+
+			if ( 0xFF == vminvq_u8( isValid ) )
+			{
+				vst1q_u8( reinterpret_cast< uint8_t* >( output ), bytes );
+				output += 16;
+				continue;
+			}
+
+			const unsigned lowMask = vaddv_u8( vand_u8( vget_low_u8( isValid ), bits ) );
+			const unsigned highMask = vaddv_u8( vand_u8( vget_high_u8( isValid ), bits ) );
+
+			vst1_u8( reinterpret_cast< uint8_t* >( output ),
+				vtbl1_u8( vget_low_u8( bytes ), vcreate_u8( table.shuffles[ lowMask ] ) ) );
+			output += table.counts[ lowMask ];
+			vst1_u8( reinterpret_cast< uint8_t* >( output ),
+				vtbl1_u8( vget_high_u8( bytes ), vcreate_u8( table.shuffles[ highMask ] ) ) );
+			output += table.counts[ highMask ];
+		}
+
+		const size_t kept = output - data;
+		std::memmove( output, data + offset, length - offset );
+
+		return kept + _compactScalar( output, length - offset );
+	}
+
+	static uint8x16_t _reverseComplement16(
+		uint8x16_t bytes,
+		uint8x16_t lowTable,
+		uint8x16_t highTable )
+	{
+		const uint8x16_t letterOffset = vsubq_u8( vorrq_u8( bytes, vdupq_n_u8( 0x20 ) ), vdupq_n_u8( 'a' ) );
+		const uint8x16_t isLetter = vcltq_u8( letterOffset, vdupq_n_u8( 26 ) );
+		const uint8x16_t index = vandq_u8( bytes, vdupq_n_u8( 0x0F ) );
+		const uint8x16_t isHigh = vtstq_u8( bytes, vdupq_n_u8( 0x10 ) );
+		const uint8x16_t low5 = vbslq_u8( isHigh, vqtbl1q_u8( highTable, index ), vqtbl1q_u8( lowTable, index ) );
+		const uint8x16_t complement = vorrq_u8( vandq_u8( bytes, vdupq_n_u8( 0xE0 ) ), low5 );
+		const uint8x16_t result = vrev64q_u8( vbslq_u8( isLetter, complement, bytes ) );
+
+		return vextq_u8( result, result, 8 );
+	}
+
+	static void _reverseComplementNeon(
+		char* data,
+		size_t length )
+	{
+		const ComplementTable& table = _complementTable();
+		const uint8x16_t lowTable = vld1q_u8( table.lowLetters );
+		const uint8x16_t highTable = vld1q_u8( table.highLetters );
+		char* left = data;
+		char* right = data + length;
+
+		for ( ; right - left >= 32; left += 16, right -= 16 )
+		{
+			const uint8x16_t front = vld1q_u8( reinterpret_cast< const uint8_t* >( left ) );
+			const uint8x16_t back = vld1q_u8( reinterpret_cast< const uint8_t* >( right - 16 ) );
+
+			vst1q_u8( reinterpret_cast< uint8_t* >( left ), _reverseComplement16( back, lowTable, highTable ) );
+			vst1q_u8( reinterpret_cast< uint8_t* >( right - 16 ), _reverseComplement16( front, lowTable, highTable ) );
+		}
+
+		_reverseComplementScalar( left, right );
+	}
+
+	static void _decodeTwoBitNeon(
+		const uint8_t* bytes,
+		size_t byteCount,
+		char* destination )
+	{
+		static const uint8_t spreadLanes[ 16 ] = { 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7 };
+		static const uint8_t evenLanes[ 16 ] = { 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0 };
+		uint8_t lowCodes[ 16 ], highCodes[ 16 ];
+
+		for ( unsigned nibble( 0 ); nibble < 16; ++nibble )
+		{
+			lowCodes[ nibble ] = twoBitCharacters()[ nibble & 0x3 ];
+			highCodes[ nibble ] = twoBitCharacters()[ nibble >> 2 ];
+		}
+
+		const uint8x16_t lowCodeTable = vld1q_u8( lowCodes );
+		const uint8x16_t highCodeTable = vld1q_u8( highCodes );
+		const uint8x16_t spread = vld1q_u8( spreadLanes );
+		const uint8x16_t isEvenLane = vld1q_u8( evenLanes );
+		size_t offset( 0 );
+
+		for ( ; offset + 4 <= byteCount; offset += 4 )
+		{
+			uint32_t word;
+			std::memcpy( &word, bytes + offset, 4 );
+
+			const uint8x8_t packed = vreinterpret_u8_u32( vdup_n_u32( word ) );
+			const uint8x8x2_t nibbles = vzip_u8( vand_u8( packed, vdup_n_u8( 0x0F ) ), vshr_n_u8( packed, 4 ) );
+			const uint8x16_t codes = vqtbl1q_u8( vcombine_u8( nibbles.val[ 0 ], nibbles.val[ 1 ] ), spread );
+
+			vst1q_u8( reinterpret_cast< uint8_t* >( destination + 4 * offset ),
+				vbslq_u8( isEvenLane, vqtbl1q_u8( lowCodeTable, codes ), vqtbl1q_u8( highCodeTable, codes ) ) );
+		}
+
+		_decodeTwoBitScalar( bytes + offset, byteCount - offset, destination + 4 * offset );
+	}
+
+	static void _decodeFourBitNeon(
+		const uint8_t* bytes,
+		size_t byteCount,
+		char* destination )
+	{
+		const uint8x16_t codeTable = vld1q_u8( reinterpret_cast< const uint8_t* >( fourBitCharacters() ) );
+		size_t offset( 0 );
+
+		for ( ; offset + 8 <= byteCount; offset += 8 )
+		{
+			const uint8x8_t packed = vld1_u8( bytes + offset );
+			const uint8x8x2_t nibbles = vzip_u8( vand_u8( packed, vdup_n_u8( 0x0F ) ), vshr_n_u8( packed, 4 ) );
+
+			vst1q_u8( reinterpret_cast< uint8_t* >( destination + 2 * offset ),
+				vqtbl1q_u8( codeTable, vcombine_u8( nibbles.val[ 0 ], nibbles.val[ 1 ] ) ) );
+		}
+
+		_decodeFourBitScalar( bytes + offset, byteCount - offset, destination + 2 * offset );
+	}
+#endif
+
+public:
+	/**
+	 * Get the instruction set selected for the running CPU.
+	 * @return The level of the kernels in use is returned.
+	 */
+	static Level level()
+	{
+		static const Level selectedLevel = _detectLevel();
+		return selectedLevel;
+	}
+
+	/**
+	 * Remove every byte that is not a valid sequence character, in a single pass.
+	 * @param data Pointer to the bytes to compact in place.
+	 * @param length The number of bytes.
+	 * @return The number of valid sequence characters kept at the front of data is returned.
+	 */
+	static size_t compactSequence(
+		char* data,
+		size_t length )
+	{
+		switch ( level() )
+		{
+#if defined( FASTA_HAS_X86_KERNELS )
+		case Level::Avx2:
+			return _compactAvx2( data, length );
+
+		case Level::Ssse3:
+			return _compactSsse3( data, length );
+#elif defined( FASTA_HAS_NEON_KERNELS )
+		case Level::Neon:
+			return _compactNeon( data, length );
+#endif
+
+		default:
+			return _compactScalar( data, length );
+		}
+	}
+
+	/**
+	 * Decode 2-bit packed nucleotides, four per byte with the lowest bits first.
+	 * @param bytes Pointer to the packed bytes.
+	 * @param byteCount The number of packed bytes to decode.
+	 * @param destination Pointer to the buffer receiving 4 * byteCount characters.
+	 */
+	static void decodeTwoBit(
+		const uint8_t* bytes,
+		size_t byteCount,
+		char* destination )
+	{
+		switch ( level() )
+		{
+#if defined( FASTA_HAS_X86_KERNELS )
+		case Level::Avx2:
+		case Level::Ssse3:
+			return _decodeTwoBitSsse3( bytes, byteCount, destination );
+#elif defined( FASTA_HAS_NEON_KERNELS )
+		case Level::Neon:
+			return _decodeTwoBitNeon( bytes, byteCount, destination );
+#endif
+
+		default:
+			return _decodeTwoBitScalar( bytes, byteCount, destination );
+		}
+	}
+
+	/**
+	 * Decode 4-bit packed IUPAC nucleotides, two per byte with the lowest bits first.
+	 * @param bytes Pointer to the packed bytes.
+	 * @param byteCount The number of packed bytes to decode.
+	 * @param destination Pointer to the buffer receiving 2 * byteCount characters.
+	 */
+	static void decodeFourBit(
+		const uint8_t* bytes,
+		size_t byteCount,
+		char* destination )
+	{
+		switch ( level() )
+		{
+#if defined( FASTA_HAS_X86_KERNELS )
+		case Level::Avx2:
+		case Level::Ssse3:
+			return _decodeFourBitSsse3( bytes, byteCount, destination );
+#elif defined( FASTA_HAS_NEON_KERNELS )
+		case Level::Neon:
+			return _decodeFourBitNeon( bytes, byteCount, destination );
+#endif
+
+		default:
+			return _decodeFourBitScalar( bytes, byteCount, destination );
+		}
+	}
+
+	/**
+	 * Find the first byte that is not a valid sequence character.
+	 * @param data Pointer to the bytes to scan.
+	 * @param length The number of bytes.
+	 * @return The offset of the first invalid byte, or length if every byte is valid, is returned.
+	 */
+	static size_t findInvalidSequenceCharacter(
+		const char* data,
+		size_t length )
+	{
+		switch ( level() )
+		{
+#if defined( FASTA_HAS_X86_KERNELS )
+		case Level::Avx2:
+			return _findInvalidAvx2( data, length );
+
+		case Level::Ssse3:
+		case Level::Sse2:
+			return _findInvalidSse2( data, length );
+#elif defined( FASTA_HAS_NEON_KERNELS )
+		case Level::Neon:
+			return _findInvalidNeon( data, length );
+#endif
+
+		default:
+			return _findInvalidScalar( data, length );
+		}
+	}
+
+	/**
+	 * Add the number of occurrences of every byte to a histogram. Four interleaved tables of
+	 * 32-bit counters keep successive increments of the same byte from waiting on each other.
+	 * @param data Pointer to the bytes to count.
+	 * @param length The number of bytes.
+	 * @param counts Pointer to the 256 counts to add to, indexed by byte.
+	 */
+	static void histogram(
+		const char* data,
+		size_t length,
+		uint64_t* counts )
+	{
+		const uint8_t* bytes = reinterpret_cast< const uint8_t* >( data );
+
+		// Short inputs are counted directly rather than clearing the tables.
+		if ( length < 1024 )
+		{
+			for ( size_t offset( 0 ); offset < length; ++offset )
+			{
+				++counts[ bytes[ offset ] ];
+			}
+
+			return;
+		}
+
+		uint32_t tables[ 4 ][ 256 ];
+
+		while ( 0 < length )
+		{
+			// Blocks are short enough that no 32-bit counter can overflow.
+			const size_t blockLength = std::min( length, static_cast< size_t >( 1 ) << 30 );
+			size_t offset( 0 );
+
+			std::memset( tables, 0, sizeof( tables ) );
+
+			for ( ; offset + 8 <= blockLength; offset += 8 )
+			{
+				uint64_t word;
+				std::memcpy( &word, bytes + offset, sizeof( word ) );
+
+				++tables[ 0 ][ word & 0xFF ];
+				++tables[ 1 ][ ( word >> 8 ) & 0xFF ];
+				++tables[ 2 ][ ( word >> 16 ) & 0xFF ];
+				++tables[ 3 ][ ( word >> 24 ) & 0xFF ];
+				++tables[ 0 ][ ( word >> 32 ) & 0xFF ];
+				++tables[ 1 ][ ( word >> 40 ) & 0xFF ];
+				++tables[ 2 ][ ( word >> 48 ) & 0xFF ];
+				++tables[ 3 ][ word >> 56 ];
+			}
+
+			for ( ; offset < blockLength; ++offset )
+			{
+				++tables[ 0 ][ bytes[ offset ] ];
+			}
+
+			for ( unsigned byte( 0 ); byte < 256; ++byte )
+			{
+				counts[ byte ] += static_cast< uint64_t >( tables[ 0 ][ byte ] ) + tables[ 1 ][ byte ] + tables[ 2 ][ byte ] + tables[ 3 ][ byte ];
+			}
+
+			bytes += blockLength;
+			length -= blockLength;
+		}
+	}
+
+	/**
+	 * Get the IUPAC complement of a character, keeping its case. U complements to A, and
+	 * characters that are not nucleotide codes are their own complement.
+	 * @param character The character to complement.
+	 * @return The complement of the character is returned.
+	 */
+	static char complement(
+		char character )
+	{
+		return _complementTable().complement[ static_cast< uint8_t >( character ) ];
+	}
+
+	/**
+	 * Reverse complement characters in place; see complement.
+	 * @param data Pointer to the characters to reverse complement.
+	 * @param length The number of characters.
+	 */
+	static void reverseComplement(
+		char* data,
+		size_t length )
+	{
+		switch ( level() )
+		{
+#if defined( FASTA_HAS_X86_KERNELS )
+		case Level::Avx2:
+		case Level::Ssse3:
+			return _reverseComplementSsse3( data, length );
+#elif defined( FASTA_HAS_NEON_KERNELS )
+		case Level::Neon:
+			return _reverseComplementNeon( data, length );
+#endif
+
+		default:
+			return _reverseComplementScalar( data, data + length );
+		}
+	}
+
+	/**
+	 * Get the characters of the 4-bit nucleotide codes. Bits 0 through 3 of a code stand for
+	 * A, C, G and T, so each IUPAC ambiguity code is the union of its bases; zero is a gap.
+	 * @return The 16 characters indexed by code.
+	 */
+	static const char* fourBitCharacters()
+	{
+		return "-ACMGRSVTWYHKDBN";
+	}
+
+	/**
+	 * Get the characters of the 2-bit nucleotide codes.
+	 * @return The 4 characters indexed by code.
+	 */
+	static const char* twoBitCharacters()
+	{
+		return "ACGT";
+	}
+
+	/**
+	 * Check for a valid sequence character: an ASCII letter, '-' or '*'.
+	 * @param character The character to check.
+	 * @return True is returned for valid sequence characters.
+	 */
+	static constexpr bool isValidSequenceCharacter(
+		char character )
+	{
+		const unsigned char byte = static_cast< unsigned char >( character );
+
+		return ( static_cast< unsigned char >( ( byte | 0x20 ) - 'a' ) < 26 ) or ( '-' == byte ) or ( '*' == byte );
+	}
+};
+
+/**
+ * This class defines the alphabets a sequence may be restricted to. Each alphabet is backed
+ * by 256 entry classification and case folding tables built at compile time, so validation
+ * is a single table lookup per byte with no locale calls. The unrestricted alphabet, which
+ * the protein alphabet equals, uses the vector kernels of FastaKernels.
+ */
+class FastaAlphabet
+{
+public:
+	/**
+	 * Alphabet of a sequence. Every alphabet accepts either case, and the gap '-'.
+	 */
+	enum class Type
+	{
+		Any,             // The ASCII letters, '-' and '*'.
+		Dna,             // A, C, G, T and N.
+		Rna,             // A, C, G, U and N.
+		IupacNucleotide, // The IUPAC nucleotide codes: A, C, G, T, U, R, Y, S, W, K, M, B, D, H, V and N.
+		Protein          // The IUPAC amino acid codes, which are every ASCII letter, and the stop '*'.
+	};
+
+	/**
+	 * Number of bytes of input that detect is meant to sample.
+	 */
+	static const size_t DetectionLength = 4096;
+
+private:
+	// Classification and case folding of every byte for one alphabet.
+	struct Table
+	{
+		bool isValid[ 256 ];
+		char folded[ 256 ];
+
+		constexpr Table(
+			const char* members ) :
+			isValid(),
+			folded()
+		{
+			for ( unsigned byte( 0 ); byte < 256; ++byte )
+			{
+				folded[ byte ] = static_cast< char >( ( ( 'a' <= byte ) and ( byte <= 'z' ) ) ? byte - 0x20 : byte );
+			}
+
+			for ( ; '\0' != *members; ++members )
+			{
+				const unsigned byte = static_cast< unsigned char >( *members );
+
+				isValid[ byte ] = true;
+
+				if ( ( 'A' <= byte ) and ( byte <= 'Z' ) )
+				{
+					isValid[ byte + 0x20 ] = true;
+				}
+			}
+		}
+	};
+
+	static const Table& _table(
+		Type alphabet )
+	{
+		static constexpr Table any( "ABCDEFGHIJKLMNOPQRSTUVWXYZ-*" );
+		static constexpr Table dna( "ACGTN-" );
+		static constexpr Table rna( "ACGUN-" );
+		static constexpr Table iupacNucleotide( "ACGTURYSWKMBDHVN-" );
+
+		switch ( alphabet )
+		{
+		case Type::Dna:
+			return dna;
+
+		case Type::Rna:
+			return rna;
+
+		case Type::IupacNucleotide:
+			return iupacNucleotide;
+
+		default:
+			return any;
+		}
+	}
+
+	// True if the alphabet accepts the same characters as FastaKernels.
+	static bool _isUnrestricted(
+		Type alphabet )
+	{
+		return ( Type::Any == alphabet ) or ( Type::Protein == alphabet );
+	}
+
+public:
+	/**
+	 * Remove every byte that is not a character of the alphabet, in a single branch-free pass.
+	 * @param alphabet The alphabet to keep the characters of.
+	 * @param data Pointer to the bytes to compact in place.
+	 * @param length The number of bytes.
+	 * @return The number of characters kept at the front of data is returned.
+	 */
+	static size_t compact(
+		Type alphabet,
+		char* data,
+		size_t length )
+	{
+		if ( _isUnrestricted( alphabet ) )
+		{
+			return FastaKernels::compactSequence( data, length );
+		}
+
+		const bool* isValid = _table( alphabet ).isValid;
+		size_t kept( 0 );
+
+		for ( size_t offset( 0 ); offset < length; ++offset )
+		{
+			const char character = data[ offset ];
+			data[ kept ] = character;
+			kept += isValid[ static_cast< unsigned char >( character ) ];
+		}
+
+		return kept;
+	}
+
+	/**
+	 * Detect the alphabet of a sample of FastA input, such as its first DetectionLength bytes.
+	 * Header lines are skipped. Nucleotide input is detected as IupacNucleotide and anything
+	 * else as Protein, the widest alphabet of each kind, so that characters past the sample
+	 * are not removed because the sample happened not to hold them.
+	 * @param data Pointer to the sample.
+	 * @param length The number of bytes in the sample.
+	 * @return The alphabet detected is returned; Any is returned if the sample holds no sequence characters.
+	 */
+	static Type detect(
+		const char* data,
+		size_t length )
+	{
+		const Table& nucleotides = _table( Type::IupacNucleotide );
+		const Table& unambiguous = _table( Type::Dna );
+		size_t letterCount( 0 ), unambiguousCount( 0 );
+		bool isNucleotide( true ), isAtLineStart( true ), isInHeader( false );
+
+		for ( size_t offset( 0 ); offset < length; ++offset )
+		{
+			const unsigned char byte = static_cast< unsigned char >( data[ offset ] );
+
+			isInHeader = ( isAtLineStart and ( '>' == byte ) ) or ( isInHeader and ( '\n' != byte ) );
+			isAtLineStart = ( '\n' == byte );
+
+			if ( isInHeader or not _table( Type::Any ).isValid[ byte ] or ( '-' == byte ) )
+			{
+				continue;
+			}
+
+			++letterCount;
+			unambiguousCount += unambiguous.isValid[ byte ] or ( 'U' == unambiguous.folded[ byte ] );
+			isNucleotide = isNucleotide and nucleotides.isValid[ byte ];
+		}
+
+		if ( 0 == letterCount )
+		{
+			return Type::Any;
+		}
+
+		// Nucleotides are mostly A, C, G, T, U or N, which a protein made only of IUPAC nucleotide letters rarely is.
+		return ( isNucleotide and ( 10 * unambiguousCount >= 9 * letterCount ) ) ? Type::IupacNucleotide : Type::Protein;
+	}
+
+	/**
+	 * Find the first byte that is not a character of the alphabet.
+	 * @param alphabet The alphabet to check against.
+	 * @param data Pointer to the bytes to scan.
+	 * @param length The number of bytes.
+	 * @return The offset of the first invalid byte, or length if every byte is valid, is returned.
+	 */
+	static size_t findInvalid(
+		Type alphabet,
+		const char* data,
+		size_t length )
+	{
+		if ( _isUnrestricted( alphabet ) )
+		{
+			return FastaKernels::findInvalidSequenceCharacter( data, length );
+		}
+
+		const bool* isValid = _table( alphabet ).isValid;
+		size_t offset( 0 );
+
+		while ( ( offset < length ) and isValid[ static_cast< unsigned char >( data[ offset ] ) ] )
+		{
+			++offset;
+		}
+
+		return offset;
+	}
+
+	/**
+	 * Fold a character to upper case, leaving anything but the ASCII lower case letters as is.
+	 * @param character The character to fold.
+	 * @return The folded character is returned.
+	 */
+	static char fold(
+		char character )
+	{
+		return _table( Type::Any ).folded[ static_cast< unsigned char >( character ) ];
+	}
+
+	/**
+	 * Check for a character of the alphabet.
+	 * @param alphabet The alphabet to check against.
+	 * @param character The character to check.
+	 * @return True is returned if the character belongs to the alphabet.
+	 */
+	static bool isValid(
+		Type alphabet,
+		char character )
+	{
+		return _table( alphabet ).isValid[ static_cast< unsigned char >( character ) ];
+	}
+};
+
+/**
+ * This class holds a genetic code for translating nucleotides to amino acids. Codons are
+ * looked up by the 4-bit IUPAC codes of their bases, so a codon holding ambiguity codes
+ * translates to the amino acid shared by every codon it may stand for, or to 'X' if they
+ * differ. A codon of gaps translates to a gap, and any other codon holding a gap to 'X'.
+ */
+class FastaCodonTable
+{
+private:
+	char mAminoAcids[ 16 * 16 * 16 ]; // Amino acid of every codon, indexed by the 4-bit codes of its bases.
+
+	// 4-bit code of every character: bits 0 through 3 stand for A, C, G and T. U is T and any
+	// character that is not a nucleotide code is N.
+	struct CodeTable
+	{
+		uint8_t codes[ 256 ];
+
+		CodeTable()
+		{
+			std::memset( codes, 0xF, sizeof( codes ) );
+
+			for ( uint8_t code( 0 ); code < 16; ++code )
+			{
+				const char character = FastaKernels::fourBitCharacters()[ code ];
+				codes[ static_cast< uint8_t >( character ) ] = code;
+				codes[ static_cast< uint8_t >( character | 0x20 ) ] = code;
+			}
+
+			codes[ static_cast< uint8_t >( 'U' ) ] = codes[ static_cast< uint8_t >( 'T' ) ];
+			codes[ static_cast< uint8_t >( 'u' ) ] = codes[ static_cast< uint8_t >( 'T' ) ];
+		}
+	};
+
+	static const CodeTable& _codeTable()
+	{
+		static const CodeTable codeTable;
+		return codeTable;
+	}
+
+public:
+	/**
+	 * Constructor.
+	 * @param aminoAcids The 64 amino acids of the codons, in the order of the NCBI genetic code
+	 *                   tables: the bases of each codon run through T, C, A and G, first base slowest.
+	 * @throw std::invalid_argument is thrown if {@param aminoAcids} does not hold 64 characters.
+	 */
+	explicit FastaCodonTable(
+		const std::string& aminoAcids )
+	{
+		// Position of the bases A, C, G and T in the NCBI order.
+		static const unsigned ncbiOrder[ 4 ] = { 2, 1, 3, 0 };
+
+		if ( 64 != aminoAcids.length() )
+		{
+			throw std::invalid_argument( "FastaCodonTable::FastaCodonTable: 64 amino acids are required" );
+		}
+
+		for ( unsigned codon( 0 ); codon < 16 * 16 * 16; ++codon )
+		{
+			const unsigned codes[ 3 ] = { codon >> 8, ( codon >> 4 ) & 0xF, codon & 0xF };
+			char aminoAcid( '\0' );
+
+			if ( 0 == codon )
+			{
+				aminoAcid = '-';
+			}
+			else if ( ( 0 == codes[ 0 ] ) or ( 0 == codes[ 1 ] ) or ( 0 == codes[ 2 ] ) )
+			{
+				aminoAcid = 'X';
+			}
+
+			for ( unsigned first( 0 ); ( first < 4 ) and ( 'X' != aminoAcid ) and ( '-' != aminoAcid ); ++first )
+			{
+				for ( unsigned second( 0 ); ( second < 4 ) and ( 'X' != aminoAcid ); ++second )
+				{
+					for ( unsigned third( 0 ); ( third < 4 ) and ( 'X' != aminoAcid ); ++third )
+					{
+						if ( ( codes[ 0 ] & ( 1u << first ) ) and ( codes[ 1 ] & ( 1u << second ) ) and ( codes[ 2 ] & ( 1u << third ) ) )
+						{
+							const char candidate = aminoAcids[ 16 * ncbiOrder[ first ] + 4 * ncbiOrder[ second ] + ncbiOrder[ third ] ];
+							aminoAcid = ( ( '\0' == aminoAcid ) or ( candidate == aminoAcid ) ) ? candidate : 'X';
+						}
+					}
+				}
+			}
+
+			mAminoAcids[ codon ] = aminoAcid;
+		}
+	}
+
+	/**
+	 * Get one of the NCBI genetic codes.
+	 * @param id The NCBI translation table number: 1 to 6, 9 or 11.
+	 * @return Const reference to the genetic code is returned.
+	 * @throw std::invalid_argument is thrown if the table is not one of those provided.
+	 */
+	static const FastaCodonTable& ncbi(
+		unsigned id )
+	{
+		static const FastaCodonTable standard( "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG" );
+		static const FastaCodonTable vertebrateMitochondrial( "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSS**VVVVAAAADDEEGGGG" );
+		static const FastaCodonTable yeastMitochondrial( "FFLLSSSSYY**CCWWTTTTPPPPHHQQRRRRIIMMTTTTNNKKSSRRVVVVAAAADDEEGGGG" );
+		static const FastaCodonTable moldMitochondrial( "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG" );
+		static const FastaCodonTable invertebrateMitochondrial( "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSSSVVVVAAAADDEEGGGG" );
+		static const FastaCodonTable ciliateNuclear( "FFLLSSSSYYQQCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG" );
+		static const FastaCodonTable echinodermMitochondrial( "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG" );
+
+		switch ( id )
+		{
+		case 1:
+		case 11: // Bacterial, archaeal and plant plastid; it differs from the standard code in its start codons only.
+			return standard;
+
+		case 2:
+			return vertebrateMitochondrial;
+
+		case 3:
+			return yeastMitochondrial;
+
+		case 4:
+			return moldMitochondrial;
+
+		case 5:
+			return invertebrateMitochondrial;
+
+		case 6:
+			return ciliateNuclear;
+
+		case 9:
+			return echinodermMitochondrial;
+
+		default:
+			throw std::invalid_argument( "FastaCodonTable::ncbi: unsupported translation table" );
+		}
+	}
+
+	/**
+	 * Get the standard genetic code, NCBI translation table 1.
+	 * @return Const reference to the standard genetic code is returned.
+	 */
+	static const FastaCodonTable& standard()
+	{
+		return ncbi( 1 );
+	}
+
+	/**
+	 * Translate the codons of a run of nucleotides; a trailing partial codon is ignored.
+	 * @param nucleotides Pointer to the nucleotides.
+	 * @param length The number of nucleotides.
+	 * @param aminoAcids Pointer to the buffer receiving length / 3 amino acids.
+	 */
+	void translate(
+		const char* nucleotides,
+		size_t length,
+		char* aminoAcids ) const
+	{
+		const uint8_t* codes = _codeTable().codes;
+
+		for ( const char* const end = nucleotides + length - length % 3; nucleotides < end; nucleotides += 3 )
+		{
+			*aminoAcids++ = mAminoAcids[ ( codes[ static_cast< uint8_t >( nucleotides[ 0 ] ) ] << 8 )
+				| ( codes[ static_cast< uint8_t >( nucleotides[ 1 ] ) ] << 4 )
+				| codes[ static_cast< uint8_t >( nucleotides[ 2 ] ) ] ];
+		}
+	}
+};
+
+/**
+ * Non-owning, read-only view of a contiguous run of characters, such as the ID token of an
+ * identifier. The viewed characters must outlive the view.
+ */
+class FastaStringView
+{
+private:
+	const char* mData; // First viewed character.
+	size_t mLength;    // Number of viewed characters.
+
+public:
+	using const_iterator = const char*;
+
+	/**
+	 * Default constructor to an empty view.
+	 */
+	FastaStringView()
+	{
+		mData = nullptr;
+		mLength = 0;
+	}
+
+	/**
+	 * Constructor.
+	 * @param data Pointer to the first character to view.
+	 * @param length The number of characters to view.
+	 */
+	FastaStringView(
+		const char* data,
+		size_t length )
+	{
+		mData = data;
+		mLength = length;
+	}
+
+	/**
+	 * Constructor viewing a null terminated c-string.
+	 * @param string Pointer to the c-string to view.
+	 */
+	FastaStringView(
+		const char* string )
+	{
+		mData = string;
+		mLength = ( nullptr == string ) ? 0 : std::strlen( string );
+	}
+
+	/**
+	 * Constructor viewing a whole std::string.
+	 * @param string Const reference to the string to view.
+	 */
+	FastaStringView(
+		const std::string& string )
+	{
+		mData = string.data();
+		mLength = string.length();
+	}
+
+	/**
+	 * Get a const_iterator to the first character.
+	 * @return A pointer to the first character is returned.
+	 */
+	const_iterator begin() const
+	{
+		return mData;
+	}
+
+	/**
+	 * Three-way lexicographical comparison, in the manner of std::string::compare.
+	 * @param other The view to compare against.
+	 * @return A negative value, zero or a positive value is returned if this view
+	 *         goes before, is equal to, or goes after the other.
+	 */
+	int compare(
+		FastaStringView other ) const
+	{
+		const int result = ( 0 == std::min( mLength, other.mLength ) )
+			? 0
+			: std::memcmp( mData, other.mData, std::min( mLength, other.mLength ) );
+
+		return ( 0 != result ) ? result : ( ( mLength == other.mLength ) ? 0 : ( ( mLength < other.mLength ) ? -1 : 1 ) );
+	}
+
+	/**
+	 * Get the first viewed character.
+	 * @return A pointer to the first character is returned.
+	 */
+	const char* data() const
+	{
+		return mData;
+	}
+
+	/**
+	 * Check if the view is empty.
+	 * @return True is returned if no characters are viewed.
+	 */
+	bool empty() const
+	{
+		return 0 == mLength;
+	}
+
+	/**
+	 * Get a const_iterator to the end of the view.
+	 * @return A pointer one past the last character is returned.
+	 */
+	const_iterator end() const
+	{
+		return mData + mLength;
+	}
+
+	/**
+	 * Hash the viewed characters, a word at a time. The value is not stable across platforms.
+	 * @return The hash of the view is returned.
+	 */
+	size_t hash() const
+	{
+		uint64_t hash = 0x9E3779B97F4A7C15ull ^ mLength;
+
+		for ( size_t offset( 0 ); offset < mLength; offset += 8 )
+		{
+			uint64_t word( 0 );
+
+			std::memcpy( &word, mData + offset, std::min( mLength - offset, static_cast< size_t >( 8 ) ) );
+			hash = ( hash ^ word ) * 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 32;
+		}
+
+		hash = ( hash ^ ( hash >> 29 ) ) * 0xC4CEB9FE1A85EC53ull;
+
+		return static_cast< size_t >( hash ^ ( hash >> 32 ) );
+	}
+
+	/**
+	 * Get the number of viewed characters.
+	 * @return The length of the view is returned.
+	 */
+	size_t length() const
+	{
+		return mLength;
+	}
+
+	/**
+	 * Copy the viewed characters into a std::string.
+	 * @return A std::string holding the viewed characters is returned.
+	 */
+	explicit operator std::string() const
+	{
+		return std::string( mData, mLength );
+	}
+
+	bool operator==(
+		FastaStringView other ) const
+	{
+		return ( mLength == other.mLength ) and ( 0 == compare( other ) );
+	}
+
+	bool operator!=(
+		FastaStringView other ) const
+	{
+		return not this->operator==( other );
+	}
+
+	bool operator<(
+		FastaStringView other ) const
+	{
+		return 0 > compare( other );
+	}
+
+	/**
+	 * Character access.
+	 * @param index Offset from the beginning of the view.
+	 * @return The character at the given offset.
+	 */
+	char operator[](
+		size_t index ) const
+	{
+		return mData[ index ];
+	}
+
+	/**
+	 * Get the number of viewed characters.
+	 * @return The length of the view is returned.
+	 */
+	size_t size() const
+	{
+		return mLength;
+	}
+
+	/**
+	 * Get a view of part of the viewed characters, in the manner of std::string::substr but
+	 * without copying them.
+	 * @param start Offset of the first character to view.
+	 * @param length The max number of characters to view. [default: the rest of the view]
+	 * @return The view of the characters is returned.
+	 * @throw std::out_of_range is thrown if start is greater than the length of the view.
+	 */
+	FastaStringView view(
+		size_t start,
+		size_t length = std::string::npos ) const
+	{
+		if ( start > mLength )
+		{
+			throw std::out_of_range( "FastaStringView::view: start is out of range" );
+		}
+
+		return FastaStringView( mData + start, std::min( length, mLength - start ) );
+	}
+};
+
+namespace std
+{
+/**
+ * Hash of a FastaStringView, so that views can key unordered containers; see FastaStringView::hash.
+ */
+template <>
+struct hash< FastaStringView >
+{
+	size_t operator()(
+		FastaStringView view ) const
+	{
+		return view.hash();
+	}
+};
+}
+
+/**
+ * This class stores a nucleotide sequence packed into 2 bits per base. Runs of N are kept in a
+ * side list, as are runs of soft-masked (lowercase) bases, so packing is lossless. Should an
+ * IUPAC ambiguity code other than N or a gap be appended, the encoding widens to 4 bits per base.
+ * Any other character, such as those of proteins, cannot be packed.
+ */
+class FastaPackedSequence
+{
+public:
+	/**
+	 * Number of bits per packed base.
+	 */
+	enum class Encoding
+	{
+		TwoBit,
+		FourBit
+	};
+
+	/**
+	 * A run of bases [begin, begin + length).
+	 */
+	struct Run
+	{
+		size_t begin;
+		size_t length;
+	};
+
+private:
+	friend class FastaFile;
+
+	// Per character codes used while packing.
+	struct EncodingTable
+	{
+		uint8_t twoBit[ 256 ];   // 2-bit code, or 0xFF if the character needs 4 bits.
+		uint8_t fourBit[ 256 ];  // 4-bit code, or 0xFF if the character cannot be packed.
+		bool isLowerCase[ 256 ]; // True for lowercase letters.
+
+		EncodingTable()
+		{
+			std::memset( twoBit, 0xFF, sizeof( twoBit ) );
+			std::memset( fourBit, 0xFF, sizeof( fourBit ) );
+
+			for ( unsigned character( 0 ); character < 256; ++character )
+			{
+				isLowerCase[ character ] = ( 'a' <= character ) and ( character <= 'z' );
+			}
+
+			for ( uint8_t code( 0 ); code < 4; ++code )
+			{
+				const char character = FastaKernels::twoBitCharacters()[ code ];
+				twoBit[ static_cast< uint8_t >( character ) ] = code;
+				twoBit[ static_cast< uint8_t >( character | 0x20 ) ] = code;
+			}
+
+			for ( uint8_t code( 0 ); code < 16; ++code )
+			{
+				const char character = FastaKernels::fourBitCharacters()[ code ];
+				fourBit[ static_cast< uint8_t >( character ) ] = code;
+				fourBit[ static_cast< uint8_t >( character | 0x20 ) ] = code;
+			}
+		}
+	};
+
+	Encoding mEncoding;               // Bits per packed base.
+	size_t mLength;                   // Number of bases.
+	std::vector< uint8_t > mBytes;    // Packed bases, lowest bits first.
+	std::vector< Run > mNRuns;        // Runs of N; only used by the 2-bit encoding.
+	std::vector< Run > mLowerCaseRuns; // Runs of soft-masked bases.
+
+	static const EncodingTable& _encodingTable()
+	{
+		static const EncodingTable encodingTable;
+		return encodingTable;
+	}
+
+	static void _extendRun(
+		std::vector< Run >& runs,
+		size_t position )
+	{
+		if ( ( not runs.empty() ) and ( runs.back().begin + runs.back().length == position ) )
+		{
+			++runs.back().length;
+		}
+		else
+		{
+			runs.push_back( Run{ position, 1 } );
+		}
+	}
+
+	// Invoke function( begin, end ) for the part of each run overlapping [position, position + count).
+	template < typename Function >
+	static void _forEachOverlap(
+		const std::vector< Run >& runs,
+		size_t position,
+		size_t count,
+		Function function )
+	{
+		auto run = std::lower_bound( runs.begin(), runs.end(), position,
+			[]( const Run& candidate, size_t value )
+			{
+				return candidate.begin + candidate.length <= value;
+			} );
+
+		for ( ; ( runs.end() != run ) and ( run->begin < position + count ); ++run )
+		{
+			function( std::max( run->begin, position ), std::min( run->begin + run->length, position + count ) );
+		}
+	}
+
+	uint8_t _code(
+		size_t position ) const
+	{
+		return ( Encoding::TwoBit == mEncoding )
+			? ( mBytes[ position >> 2 ] >> ( 2 * ( position & 0x3 ) ) ) & 0x3
+			: ( mBytes[ position >> 1 ] >> ( 4 * ( position & 0x1 ) ) ) & 0xF;
+	}
+
+	// Re-encode the 2-bit bases as 4-bit codes, folding the runs of N into the codes.
+	void _widen()
+	{
+		std::vector< uint8_t > bytes( ( mLength + 1 ) / 2, 0 );
+
+		for ( size_t position( 0 ); position < mLength; ++position )
+		{
+			bytes[ position >> 1 ] |= static_cast< uint8_t >( ( 1u << _code( position ) ) << ( 4 * ( position & 0x1 ) ) );
+		}
+
+		for ( const Run& run : mNRuns )
+		{
+			for ( size_t position( run.begin ); position < run.begin + run.length; ++position )
+			{
+				bytes[ position >> 1 ] |= static_cast< uint8_t >( 0xF << ( 4 * ( position & 0x1 ) ) );
+			}
+		}
+
+		mBytes = std::move( bytes );
+		mNRuns.clear();
+		mEncoding = Encoding::FourBit;
+	}
+
+public:
+	/**
+	 * Default constructor to an empty 2-bit sequence.
+	 */
+	FastaPackedSequence()
+	{
+		mEncoding = Encoding::TwoBit;
+		mLength = 0;
+	}
+
+	/**
+	 * Append bases to the packed sequence.
+	 * @param data Pointer to the characters to append.
+	 * @param length The number of characters to append.
+	 * @return True is returned upon success. False is returned if a character cannot be packed,
+	 *         in which case only the characters before it are appended.
+	 */
+	bool append(
+		const char* data,
+		size_t length )
+	{
+		const EncodingTable& table = _encodingTable();
+
+		for ( size_t offset( 0 ); offset < length; ++offset )
+		{
+			const uint8_t character = static_cast< uint8_t >( data[ offset ] );
+			uint8_t code = ( Encoding::TwoBit == mEncoding ) ? table.twoBit[ character ] : table.fourBit[ character ];
+
+			if ( 0xFF == code )
+			{
+				if ( 0xFF == table.fourBit[ character ] )
+				{
+					return false;
+				}
+
+				if ( 'N' == ( character & ~0x20 ) )
+				{
+					_extendRun( mNRuns, mLength );
+					code = 0;
+				}
+				else
+				{
+					_widen();
+					code = table.fourBit[ character ];
+				}
+			}
+
+			if ( table.isLowerCase[ character ] )
+			{
+				_extendRun( mLowerCaseRuns, mLength );
+			}
+
+			if ( Encoding::TwoBit == mEncoding )
+			{
+				if ( 0 == ( mLength & 0x3 ) )
+				{
+					mBytes.push_back( 0 );
+				}
+
+				mBytes.back() |= static_cast< uint8_t >( code << ( 2 * ( mLength & 0x3 ) ) );
+			}
+			else
+			{
+				if ( 0 == ( mLength & 0x1 ) )
+				{
+					mBytes.push_back( 0 );
+				}
+
+				mBytes.back() |= static_cast< uint8_t >( code << ( 4 * ( mLength & 0x1 ) ) );
+			}
+
+			++mLength;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Decode a substring of the sequence into a character buffer, in the manner of std::string::copy.
+	 * @param destination Pointer to the buffer to decode the characters to.
+	 * @param count The max number of characters to decode.
+	 * @param position Offset of the first character to decode. [default: 0]
+	 * @return The number of characters decoded is returned.
+	 * @throw std::out_of_range is thrown if the position is greater than the sequence length.
+	 */
+	size_t decode(
+		char* destination,
+		size_t count,
+		size_t position = 0 ) const
+	{
+		if ( position > mLength )
+		{
+			throw std::out_of_range( "FastaPackedSequence::decode: position is out of range" );
+		}
+
+		count = std::min( count, mLength - position );
+
+		const size_t basesPerByte = ( Encoding::TwoBit == mEncoding ) ? 4 : 2;
+		size_t decoded( 0 );
+
+		// Bases before the first whole byte, the whole bytes, then the bases after the last whole byte.
+		for ( ; ( decoded < count ) and ( 0 != ( ( position + decoded ) % basesPerByte ) ); ++decoded )
+		{
+			destination[ decoded ] = this->operator[]( position + decoded );
+		}
+
+		const size_t byteCount = ( count - decoded ) / basesPerByte;
+		const uint8_t* bytes = mBytes.data() + ( position + decoded ) / basesPerByte;
+
+		if ( Encoding::TwoBit == mEncoding )
+		{
+			FastaKernels::decodeTwoBit( bytes, byteCount, destination + decoded );
+		}
+		else
+		{
+			FastaKernels::decodeFourBit( bytes, byteCount, destination + decoded );
+		}
+
+		for ( decoded += byteCount * basesPerByte; decoded < count; ++decoded )
+		{
+			destination[ decoded ] = ( Encoding::TwoBit == mEncoding )
+				? FastaKernels::twoBitCharacters()[ _code( position + decoded ) ]
+				: FastaKernels::fourBitCharacters()[ _code( position + decoded ) ];
+		}
+
+		_forEachOverlap( mNRuns, position, count,
+			[ & ]( size_t begin, size_t end )
+			{
+				std::memset( destination + begin - position, 'N', end - begin );
+			} );
+
+		_forEachOverlap( mLowerCaseRuns, position, count,
+			[ & ]( size_t begin, size_t end )
+			{
+				for ( size_t offset( begin ); offset < end; ++offset )
+				{
+					destination[ offset - position ] |= 0x20;
+				}
+			} );
+
+		return count;
+	}
+
+	/**
+	 * Get the encoding of the packed bases.
+	 * @return The number of bits per packed base.
+	 */
+	Encoding encoding() const
+	{
+		return mEncoding;
+	}
+
+	/**
+	 * Get the length of the sequence.
+	 * @return The number of bases is returned.
+	 */
+	size_t length() const
+	{
+		return mLength;
+	}
+
+	/**
+	 * Get the runs of soft-masked (lowercase) bases.
+	 * @return Const reference to the runs in ascending order.
+	 */
+	const std::vector< Run >& lowerCaseRuns() const
+	{
+		return mLowerCaseRuns;
+	}
+
+	/**
+	 * Get the heap memory held by the packed sequence, including this instance.
+	 * @return The number of bytes is returned.
+	 */
+	size_t memoryUsage() const
+	{
+		return sizeof( *this ) + mBytes.capacity()
+			+ ( mNRuns.capacity() + mLowerCaseRuns.capacity() ) * sizeof( Run );
+	}
+
+	/**
+	 * Get the runs of N bases. These are only kept by the 2-bit encoding.
+	 * @return Const reference to the runs in ascending order.
+	 */
+	const std::vector< Run >& nRuns() const
+	{
+		return mNRuns;
+	}
+
+	/**
+	 * Unchecked base access.
+	 * @param index Offset from the beginning of the sequence.
+	 * @return The base at the given offset.
+	 */
+	char operator[](
+		size_t index ) const
+	{
+		char character = ( Encoding::TwoBit == mEncoding )
+			? FastaKernels::twoBitCharacters()[ _code( index ) ]
+			: FastaKernels::fourBitCharacters()[ _code( index ) ];
+
+		_forEachOverlap( mNRuns, index, 1,
+			[ & ]( size_t, size_t )
+			{
+				character = 'N';
+			} );
+
+		_forEachOverlap( mLowerCaseRuns, index, 1,
+			[ & ]( size_t, size_t )
+			{
+				character |= 0x20;
+			} );
+
+		return character;
+	}
+
+	/**
+	 * Release any excess capacity held by the packed bases and runs.
+	 */
+	void shrinkToFit()
+	{
+		mBytes.shrink_to_fit();
+		mNRuns.shrink_to_fit();
+		mLowerCaseRuns.shrink_to_fit();
+	}
+};
+
+template < typename Word >
+class FastaKmerView;
+
+/**
+ * This class contains a single sequence and its associated identifier.
+ * When assigning the identifier, control characters will be removed.
+ * The sequence will be normalized by removing control characters and any
+ * non-(amino/nucleic) characters.
+ * Const members may be called from several threads at once. They never change
+ * where the sequence is stored: a sequence whose normalization is deferred is
+ * normalized once, by the first access, and the copy that sequence() or
+ * identifier() makes of a view or packed sequence is made once and kept
+ * alongside it; concurrent callers wait for either rather than see it half done.
+ */
+class FastaSequence
+{
+public:
+	/**
+	 * How a sequence is normalized when it is set or read.
+	 */
+	enum class Normalization
+	{
+		Eager,   // Invalid characters are removed as the sequence is set.
+		Lazy,    // The sequence is kept as given and normalized on its first access.
+		Trusted  // The sequence is trusted to be valid; only line terminators are removed.
+	};
+
+private:
+	friend class ConcurrentFastaFile;
+	friend class FastaFile;
+	friend class FastaIndex;
+	friend class FastaReader;
+	friend class FastaWriter;
+
+	// The identifier is either owned in mIdentifier or a read-only view of bytes owned
+	// elsewhere (e.g. an arena), copied into mIdentifier the first time it is requested.
+	// The view is kept until a non-const member releases it.
+	mutable std::string mIdentifier;                   // The sequence identifier.
+	std::shared_ptr< const char > mExternalIdentifier; // First byte of the external identifier.
+	size_t mExternalIdentifierLength;                  // Number of characters in the external identifier.
+
+	// The sequence is either owned by this instance in mSequence, a read-only view into
+	// bytes owned elsewhere (e.g. a memory mapped file), or packed. External bytes are laid
+	// out as fixed width lines; each line holds mExternalLineBases sequence characters and
+	// is mExternalLineWidth bytes long, including the line terminator. Views and packed
+	// sequences are copied into mSequence the first time a contiguous string is required,
+	// and kept alongside the copy until a mutable access releases them.
+	mutable std::string mSequence;                   // Sequence.
+	std::shared_ptr< const char > mExternalSequence; // First byte of the external sequence.
+	size_t mExternalLength;                          // Number of characters in the external sequence.
+	size_t mExternalLineBases;                       // Sequence characters per external line.
+	size_t mExternalLineWidth;                       // Bytes per external line.
+	std::shared_ptr< const FastaPackedSequence > mPackedSequence; // Packed sequence.
+	mutable std::atomic< unsigned char > mLazyState; // LazyState flags of the deferred work.
+	FastaAlphabet::Type mAlphabet;                   // Alphabet the sequence is normalized to.
+
+	// Work that const accessors defer to the first access. A const accessor finishing such
+	// work takes LazyBusy, so that concurrent readers wait rather than see it half done.
+	enum LazyState : unsigned char
+	{
+		LazyPending = 0x01,          // mSequence holds raw, unnormalized bytes.
+		LazySequenceCopied = 0x02,   // mSequence holds a copy of the view or packed sequence.
+		LazyIdentifierCopied = 0x04, // mIdentifier holds a copy of the external identifier.
+		LazyBusy = 0x80              // A thread is finishing the deferred work.
+	};
+
+	// Wait for and take LazyBusy, returning the flags held before.
+	unsigned char _lockLazyState() const
+	{
+		unsigned char state = mLazyState.load( std::memory_order_relaxed );
+
+		for ( ;; )
+		{
+			if ( LazyBusy & state )
+			{
+				std::this_thread::yield();
+				state = mLazyState.load( std::memory_order_relaxed );
+			}
+			else if ( mLazyState.compare_exchange_weak( state, state | LazyBusy, std::memory_order_acquire, std::memory_order_relaxed ) )
+			{
+				return state;
+			}
+		}
+	}
+
+	// Publish the flags and release LazyBusy.
+	void _unlockLazyState(
+		unsigned char state ) const
+	{
+		mLazyState.store( state & ~LazyBusy, std::memory_order_release );
+	}
+
+	// Set or clear flags from a non-const member, which is never called concurrently with others.
+	void _setLazyState(
+		unsigned char flags,
+		bool isSet )
+	{
+		const unsigned char state = mLazyState.load( std::memory_order_relaxed );
+		mLazyState.store( isSet ? ( state | flags ) : ( state & ~flags ), std::memory_order_relaxed );
+	}
+
+	void _copyAssign(
+		const FastaSequence& other )
+	{
+		const unsigned char state = other._lockLazyState();
+
+		mIdentifier = other.mIdentifier;
+		mExternalIdentifier = other.mExternalIdentifier;
+		mExternalIdentifierLength = other.mExternalIdentifierLength;
+		mSequence = other.mSequence;
+		mExternalSequence = other.mExternalSequence;
+		mExternalLength = other.mExternalLength;
+		mExternalLineBases = other.mExternalLineBases;
+		mExternalLineWidth = other.mExternalLineWidth;
+		mPackedSequence = other.mPackedSequence;
+		mLazyState.store( state, std::memory_order_relaxed );
+		mAlphabet = other.mAlphabet;
+		other._unlockLazyState( state );
+	}
+
+	void _moveAssign(
+		FastaSequence&& other ) noexcept
+	{
+		mIdentifier = std::move( other.mIdentifier );
+		mExternalIdentifier = std::move( other.mExternalIdentifier );
+		mExternalIdentifierLength = std::exchange( other.mExternalIdentifierLength, 0 );
+		mSequence = std::move( other.mSequence );
+		mExternalSequence = std::move( other.mExternalSequence );
+		mExternalLength = std::exchange( other.mExternalLength, 0 );
+		mExternalLineBases = std::exchange( other.mExternalLineBases, 0 );
+		mExternalLineWidth = std::exchange( other.mExternalLineWidth, 0 );
+		mPackedSequence = std::move( other.mPackedSequence );
+		mLazyState.store( other.mLazyState.exchange( 0, std::memory_order_relaxed ), std::memory_order_relaxed );
+		mAlphabet = std::exchange( other.mAlphabet, FastaAlphabet::Type::Any );
+	}
+
+	// Character at the given offset of the external sequence.
+	const char& _externalAt(
+		size_t index ) const
+	{
+		return mExternalSequence.get()[ index
+			+ ( index / mExternalLineBases ) * ( mExternalLineWidth - mExternalLineBases ) ];
+	}
+
+	// View of the identifier wherever it is stored.
+	FastaStringView _identifierView() const
+	{
+		return mExternalIdentifier
+			? FastaStringView( mExternalIdentifier.get(), mExternalIdentifierLength )
+			: FastaStringView( mIdentifier );
+	}
+
+	// True if the sequence is not held in mSequence.
+	bool _isExternal() const
+	{
+		return mExternalSequence or mPackedSequence;
+	}
+
+	// Copy the external or packed sequence into mSequence, once, keeping it where it is.
+	// Concurrent callers wait until the one copying has published the copy.
+	void _copyExternal() const
+	{
+		if ( not _isExternal() )
+		{
+			_normalizePending();
+		}
+		else if ( not ( LazySequenceCopied & mLazyState.load( std::memory_order_acquire ) ) )
+		{
+			const unsigned char state = _lockLazyState();
+
+			if ( not ( LazySequenceCopied & state ) )
+			{
+				const size_t length = this->length();
+				mSequence.resize( length );
+				this->copy( &mSequence[ 0 ], length );
+			}
+
+			_unlockLazyState( state | LazySequenceCopied );
+		}
+	}
+
+	// Copy the external identifier into mIdentifier, once, keeping it where it is.
+	void _copyExternalIdentifier() const
+	{
+		if ( mExternalIdentifier and not ( LazyIdentifierCopied & mLazyState.load( std::memory_order_acquire ) ) )
+		{
+			const unsigned char state = _lockLazyState();
+
+			if ( not ( LazyIdentifierCopied & state ) )
+			{
+				mIdentifier.assign( mExternalIdentifier.get(), mExternalIdentifierLength );
+			}
+
+			_unlockLazyState( state | LazyIdentifierCopied );
+		}
+	}
+
+	// Copy the external or packed sequence into mSequence and release it.
+	void _materialize()
+	{
+		_copyExternal();
+		_releaseExternal();
+	}
+
+	// Copy the external identifier into mIdentifier and release it.
+	void _materializeIdentifier()
+	{
+		_copyExternalIdentifier();
+		_releaseExternalIdentifier();
+	}
+
+	// Drop the view of the external identifier, and any copy flag of it.
+	void _releaseExternalIdentifier()
+	{
+		mExternalIdentifier.reset();
+		mExternalIdentifierLength = 0;
+		_setLazyState( LazyIdentifierCopied, false );
+	}
+
+	// Drop the view of the external sequence, or the packed sequence, and any copy flag of it.
+	void _releaseExternal()
+	{
+		_setLazyState( LazySequenceCopied, false );
+		mPackedSequence.reset();
+		mExternalSequence.reset();
+		mExternalLength = 0;
+		mExternalLineBases = 0;
+		mExternalLineWidth = 0;
+	}
+
+	// Make the identifier a view of already normalized external bytes.
+	void _setExternalIdentifier(
+		std::shared_ptr< const char > data,
+		size_t length )
+	{
+		mIdentifier.clear();
+		_releaseExternalIdentifier();
+
+		if ( 0 < length )
+		{
+			mExternalIdentifier = std::move( data );
+			mExternalIdentifierLength = length;
+		}
+	}
+
+	// Make the sequence a view of already normalized external bytes.
+	void _setExternalSequence(
+		std::shared_ptr< const char > data,
+		size_t length,
+		size_t lineBases,
+		size_t lineWidth )
+	{
+		mSequence.clear();
+		_setLazyState( LazyPending, false );
+		_releaseExternal();
+
+		if ( 0 < length )
+		{
+			mExternalSequence = std::move( data );
+			mExternalLength = length;
+			mExternalLineBases = lineBases;
+			mExternalLineWidth = lineWidth;
+		}
+	}
+
+	// Move an owned sequence into a buffer that this sequence views, so that others can share it.
+	void _makeShareable()
+	{
+		_normalizePending();
+
+		if ( not _isExternal() and not mSequence.empty() )
+		{
+			const size_t length = mSequence.length();
+			std::shared_ptr< std::string > bytes = std::make_shared< std::string >( std::move( mSequence ) );
+
+			_setExternalSequence( std::shared_ptr< const char >( bytes, bytes->data() ), length, length, length );
+		}
+	}
+
+	// Share the view or packed sequence of the other, releasing the sequence held by this one.
+	void _shareSequence(
+		const FastaSequence& other )
+	{
+		std::string().swap( mSequence );
+		_setLazyState( LazyPending | LazySequenceCopied, false );
+		mExternalSequence = other.mExternalSequence;
+		mExternalLength = other.mExternalLength;
+		mExternalLineBases = other.mExternalLineBases;
+		mExternalLineWidth = other.mExternalLineWidth;
+		mPackedSequence = other.mPackedSequence;
+	}
+
+	// Heap bytes held by the string, none if its characters fit in the string itself.
+	static size_t _heapBytes(
+		const std::string& string )
+	{
+		return ( string.capacity() > std::string().capacity() ) ? string.capacity() + 1 : 0;
+	}
+
+	// Heap bytes held by the identifier and sequence strings, and their unused capacity,
+	// read while no const accessor is copying a view into them.
+	void _heapUsage(
+		size_t& identifierBytes,
+		size_t& sequenceBytes,
+		size_t& slackBytes ) const
+	{
+		const unsigned char state = _lockLazyState();
+
+		identifierBytes = _heapBytes( mIdentifier );
+		sequenceBytes = _heapBytes( mSequence );
+		slackBytes = ( ( 0 < identifierBytes ) ? mIdentifier.capacity() - mIdentifier.length() : 0 )
+			+ ( ( 0 < sequenceBytes ) ? mSequence.capacity() - mSequence.length() : 0 );
+
+		_unlockLazyState( state );
+	}
+
+	// Three-way lexicographical comparison of the sequences.
+	int _compareSequence(
+		const FastaSequence& other ) const
+	{
+		_normalizePending();
+		other._normalizePending();
+
+		if ( not _isExternal() and not other._isExternal() )
+		{
+			return mSequence.compare( other.mSequence );
+		}
+
+		const size_t length = this->length();
+		const size_t otherLength = other.length();
+
+		for ( size_t index( 0 ); ( index < length ) and ( index < otherLength ); ++index )
+		{
+			const unsigned char character = _at( index );
+			const unsigned char otherCharacter = other._at( index );
+
+			if ( character != otherCharacter )
+			{
+				return ( character < otherCharacter ) ? -1 : 1;
+			}
+		}
+
+		return ( length == otherLength ) ? 0 : ( ( length < otherLength ) ? -1 : 1 );
+	}
+
+	// Unchecked character access regardless of where the sequence is stored.
+	char _at(
+		size_t index ) const
+	{
+		return mPackedSequence
+			? mPackedSequence->operator[]( index )
+			: ( mExternalSequence ? _externalAt( index ) : mSequence[ index ] );
+	}
+
+	// Remove any control characters, the leading '>' if present and any surrounding
+	// whitespace, in place. Tabs are kept as spaces so the identifier tokens stay apart.
+	void _normalizeIdentifier()
+	{
+		size_t kept( 0 );
+
+		_releaseExternalIdentifier();
+
+		for ( const char character : mIdentifier )
+		{
+			const unsigned char byte = static_cast< unsigned char >( ( '\t' == character ) ? ' ' : character );
+			mIdentifier[ kept ] = static_cast< char >( byte );
+			kept += ( 0x20 <= byte ) and ( byte < 0x7F );
+		}
+
+		size_t begin( ( 0 < kept ) and ( '>' == mIdentifier[ 0 ] ) );
+
+		while ( ( begin < kept ) and ( ' ' == mIdentifier[ begin ] ) )
+		{
+			++begin;
+		}
+
+		while ( ( kept > begin ) and ( ' ' == mIdentifier[ kept - 1 ] ) )
+		{
+			--kept;
+		}
+
+		mIdentifier.erase( kept );
+		mIdentifier.erase( 0, begin );
+	}
+
+	// Remove control characters and any characters outside the alphabet from mSequence.
+	// An already clean sequence is only scanned, not rewritten.
+	void _compactSequence() const
+	{
+		const size_t firstInvalid = FastaAlphabet::findInvalid( mAlphabet, mSequence.data(), mSequence.length() );
+
+		if ( firstInvalid < mSequence.length() )
+		{
+			mSequence.resize( firstInvalid
+				+ FastaAlphabet::compact( mAlphabet, &mSequence[ firstInvalid ], mSequence.length() - firstInvalid ) );
+		}
+	}
+
+	// Normalize the sequence if its normalization was deferred. Concurrent callers wait
+	// until the one normalizing has published the compacted sequence.
+	void _normalizePending() const
+	{
+		if ( LazyPending & mLazyState.load( std::memory_order_acquire ) )
+		{
+			const unsigned char state = _lockLazyState();
+
+			if ( LazyPending & state )
+			{
+				_compactSequence();
+			}
+
+			_unlockLazyState( state & ~LazyPending );
+		}
+	}
+
+	// Normalize the sequence held in mSequence now.
+	void _normalizeSequence()
+	{
+		_releaseExternal();
+		_setLazyState( LazyPending, false );
+		_compactSequence();
+	}
+
+	// Normalize the sequence held in mSequence as given: now, on first access, or by only removing line terminators.
+	void _normalizeSequence(
+		Normalization normalization )
+	{
+		if ( Normalization::Eager == normalization )
+		{
+			_normalizeSequence();
+			return;
+		}
+
+		_releaseExternal();
+		_setLazyState( LazyPending, ( Normalization::Lazy == normalization ) and not mSequence.empty() );
+
+		if ( Normalization::Trusted == normalization )
+		{
+			_removeLineTerminators();
+		}
+	}
+
+	// Remove the line feeds, and any carriage returns preceding them, from mSequence.
+	void _removeLineTerminators()
+	{
+		char* const data = &mSequence[ 0 ];
+		const char* const end = data + mSequence.length();
+		const char* line = data;
+		char* kept = data;
+
+		while ( line < end )
+		{
+			const char* newline = static_cast< const char* >( std::memchr( line, '\n', end - line ) );
+			const char* lineEnd = ( nullptr == newline ) ? end : newline;
+			const char* contentEnd = ( ( nullptr != newline ) and ( line < lineEnd ) and ( '\r' == lineEnd[ -1 ] ) ) ? lineEnd - 1 : lineEnd;
+
+			if ( kept != line )
+			{
+				std::memmove( kept, line, contentEnd - line );
+			}
+
+			kept += contentEnd - line;
+			line = ( nullptr == newline ) ? end : newline + 1;
+		}
+
+		mSequence.resize( kept - data );
+	}
+
+public:
+	/**
+	 * Default constructor.
+	 * @param identifier The header/sequence identifier to associate with the sequence. [default: ""]
+	 * @param sequence The genomic sequence. [default: ""]
+	 */
+	FastaSequence(
+		const std::string& identifier = std::string(),
+		const std::string& sequence = std::string() )
+	{
+		mIdentifier = identifier;
+		mExternalIdentifierLength = 0;
+		mSequence = sequence;
+		mExternalLength = 0;
+		mExternalLineBases = 0;
+		mExternalLineWidth = 0;
+		mLazyState.store( 0, std::memory_order_relaxed );
+		mAlphabet = FastaAlphabet::Type::Any;
+
+		_normalizeIdentifier();
+		_normalizeSequence();
+	}
+
+	/**
+	 * Constructor taking over the buffers of the given strings, which are normalized in place.
+	 * @param identifier R-Value to the header/sequence identifier to associate with the sequence.
+	 * @param sequence R-Value to the genomic sequence.
+	 */
+	FastaSequence(
+		std::string&& identifier,
+		std::string&& sequence )
+	{
+		mIdentifier = std::move( identifier );
+		mExternalIdentifierLength = 0;
+		mSequence = std::move( sequence );
+		mExternalLength = 0;
+		mExternalLineBases = 0;
+		mExternalLineWidth = 0;
+		mLazyState.store( 0, std::memory_order_relaxed );
+		mAlphabet = FastaAlphabet::Type::Any;
+
+		_normalizeIdentifier();
+		_normalizeSequence();
+	}
+
+	/**
+	 * Move constructor. It does not throw, so containers of FastaSequence move rather than
+	 * copy their elements when they grow.
+	 * @param other R-Value to the FastaSequence to move to this instance.
+	 */
+	FastaSequence(
+		FastaSequence&& other ) noexcept
+	{
+		mLazyState.store( 0, std::memory_order_relaxed );
+		mAlphabet = FastaAlphabet::Type::Any;
+		_moveAssign( std::move( other ) );
+	}
+
+	/**
+	 * Copy constructor.
+	 * @param other Const reference to the FastaSequence to copy to this instance.
+	 */
+	FastaSequence(
+		const FastaSequence& other )
+	{
+		_copyAssign( other );
+	}
+
+	/**
+	 * Get the alphabet the sequence is normalized to.
+	 * @return The alphabet of the sequence is returned. [default: Any]
+	 */
+	FastaAlphabet::Type alphabet() const
+	{
+		return mAlphabet;
+	}
+
+	/**
+	 * Append a character to the sequence count times.
+	 * If the character to append is not a character of the alphabet,
+	 * then nothing will be appended to the sequence.
+	 * @param character The character to append.
+	 * @param count The number of times to append the character. [default: 1]
+	 */
+	void append(
+		char character,
+		size_t count = 1 )
+	{
+		if ( ( 0 < count ) and FastaAlphabet::isValid( mAlphabet, character ) )
+		{
+			_materialize();
+			mSequence.append( count, character );
+		}
+	}
+
+	/**
+	 * Append characters from a c-string up to count characters
+	 * or up to the null character of the string, which ever comes first.
+	 * @param sequence The c-string to append characters from.
+	 * @param count The max number of characters to append. [default: -1]
+	 */
+	void append(
+		const char* sequence,
+		size_t count = -1 )
+	{
+		if ( ( 0 < count ) and ( nullptr != sequence ) )
+		{
+			size_t length = strlen( sequence );
+			count = ( count < length ) ? count : length;
+			_materialize();
+			mSequence.append( sequence, count );
+		}
+	}
+
+	/**
+	 * Append characters from a std::string up to count characters.
+	 * @param sequence The std::string to append characters from.
+	 * @param count The max number of characters to append. [default: -1]
+	 */
+	void append(
+		const std::string& sequence,
+		size_t count = -1 )
+	{
+		this->append( sequence.c_str(), count );
+	}
+
+	/**
+	 * Copy a substring of the sequence into a character buffer, in the manner of std::string::copy.
+	 * No null character is appended, and the sequence is not materialized if it is a view or packed.
+	 * @param destination Pointer to the buffer to copy the characters to.
+	 * @param count The max number of characters to copy.
+	 * @param position Offset of the first character to copy. [default: 0]
+	 * @return The number of characters copied is returned.
+	 * @throw std::out_of_range is thrown if the position is greater than the sequence length.
+	 */
+	size_t copy(
+		char* destination,
+		size_t count,
+		size_t position = 0 ) const
+	{
+		if ( mPackedSequence )
+		{
+			return mPackedSequence->decode( destination, count, position );
+		}
+
+		if ( not mExternalSequence )
+		{
+			_normalizePending();
+			return mSequence.copy( destination, count, position );
+		}
+
+		if ( position > mExternalLength )
+		{
+			throw std::out_of_range( "FastaSequence::copy: position is out of range" );
+		}
+
+		count = std::min( count, mExternalLength - position );
+
+		for ( size_t copied( 0 ); copied < count; )
+		{
+			const size_t column = ( position + copied ) % mExternalLineBases;
+			const size_t segment = std::min( count - copied, mExternalLineBases - column );
+			std::memcpy( destination + copied, &_externalAt( position + copied ), segment );
+			copied += segment;
+		}
+
+		return count;
+	}
+
+	/**
+	 * Get the description of the sequence: the identifier following the first space.
+	 * @return A view of the description within the identifier, empty if there is none.
+	 */
+	FastaStringView description() const
+	{
+		const FastaStringView identifier = _identifierView();
+		const char* space = std::find( identifier.begin(), identifier.end(), ' ' );
+
+		if ( identifier.end() == space )
+		{
+			return FastaStringView();
+		}
+
+		const char* begin = std::find_if( space, identifier.end(),
+			[]( const char character )
+			{
+				return ' ' != character;
+			} );
+
+		return FastaStringView( begin, identifier.end() - begin );
+	}
+
+	/**
+	 * Get the ID token of the sequence: the identifier up to the first space.
+	 * This is the name used for the sequence by .fai indexes.
+	 * @return A view of the ID token within the identifier.
+	 */
+	FastaStringView id() const
+	{
+		const FastaStringView identifier = _identifierView();
+
+		return FastaStringView( identifier.data(), std::find( identifier.begin(), identifier.end(), ' ' ) - identifier.begin() );
+	}
+
+	/**
+	 * Get the identifier for the sequence.
+	 * @return A const reference to the sequence identifier.
+	 */
+	const std::string& identifier() const
+	{
+		_copyExternalIdentifier();
+		return mIdentifier;
+	}
+
+	/**
+	 * Check if the sequence has been normalized, or was trusted to be valid.
+	 * @return False is returned if the normalization of the sequence is deferred until its first access.
+	 */
+	bool isNormalized() const
+	{
+		return not ( LazyPending & mLazyState.load( std::memory_order_acquire ) );
+	}
+
+	/**
+	 * Check if the sequence is stored packed.
+	 * @return True is returned if the sequence is packed.
+	 */
+	bool isPacked() const
+	{
+		return static_cast< bool >( mPackedSequence );
+	}
+
+	/**
+	 * Get a view of the k-mers of the sequence; see FastaKmerView. The sequence must outlive the
+	 * view, and is read without being copied, whether it is owned, a view or packed.
+	 * @param k The number of bases in each k-mer, at most 32 for 64-bit words and 64 for 128-bit words.
+	 * @param canonical Flag whether each k-mer or its reverse complement, whichever is smaller, is yielded. [default: true]
+	 * @return The view of the k-mers of the sequence is returned.
+	 * @throw std::out_of_range is thrown if k is zero or too large for the word.
+	 */
+	template < typename Word = uint64_t >
+	FastaKmerView< Word > kmers(
+		size_t k,
+		bool canonical = true ) const
+	{
+		return FastaKmerView< Word >( *this, k, canonical );
+	}
+
+	/**
+	 * Get the length of the sequence.
+	 * @return The length of the sequence is returned.
+	 */
+	size_t length() const
+	{
+		_normalizePending();
+
+		return mPackedSequence
+			? mPackedSequence->length()
+			: ( mExternalSequence ? mExternalLength : mSequence.length() );
+	}
+
+	/**
+	 * Get the heap memory held by the identifier and the sequence, not counting this instance.
+	 * A packed sequence is counted in full, though copies of the sequence share it; the bytes
+	 * viewed by a view, such as those of a memory mapped file or an arena, are not counted.
+	 * @return The number of bytes is returned.
+	 */
+	size_t memoryUsage() const
+	{
+		size_t identifierBytes, sequenceBytes, slackBytes;
+
+		_heapUsage( identifierBytes, sequenceBytes, slackBytes );
+
+		return identifierBytes + sequenceBytes + ( mPackedSequence ? mPackedSequence->memoryUsage() : 0 );
+	}
+
+	/**
+	 * The lexicographical ordering of sequences is first by the identifier, then the sequence.
+	 * @param rhs The right-hand side of the comparison.
+	 * @return True is returned if this instance goes before the RHS.
+	 */
+	bool operator<(
+		const FastaSequence& rhs ) const noexcept
+	{
+		return ( _identifierView() == rhs._identifierView() )
+			? _compareSequence( rhs ) < 0
+			: _identifierView() < rhs._identifierView();
+	}
+
+	/**
+	 * The lexicographical ordering of sequences is first by the identifier, then the sequence.
+	 * @param rhs The right-hand side of the comparison.
+	 * @return True is returned if this instance goes before, or is equal to the RHS.
+	 */
+	bool operator<=(
+		const FastaSequence& rhs ) const noexcept
+	{
+		return ( _identifierView() == rhs._identifierView() )
+			? _compareSequence( rhs ) <= 0
+			: _identifierView() < rhs._identifierView();
+	}
+
+	/**
+	 * The lexicographical ordering of sequences is first by the identifier, then the sequence.
+	 * @param rhs The right-hand side of the comparison.
+	 * @return True is returned if this instance goes after the RHS.
+	 */
+	bool operator>(
+		const FastaSequence& rhs ) const noexcept
+	{
+		return ( _identifierView() == rhs._identifierView() )
+			? _compareSequence( rhs ) > 0
+			: rhs._identifierView() < _identifierView();
+	}
+
+	/**
+	 * The lexicographical ordering of sequences is first by the identifier, then the sequence.
+	 * @param rhs The right-hand side of the comparison.
+	 * @return True is returned if this instance goes after, or is equal to the RHS.
+	 */
+	bool operator>=(
+		const FastaSequence& rhs ) const noexcept
+	{
+		return ( _identifierView() == rhs._identifierView() )
+			? _compareSequence( rhs ) >= 0
+			: rhs._identifierView() < _identifierView();
+	}
+
+	/**
+	 * Check for equality of both the identifier
+	 * and the sequence; returning true if both are equal.
+	 * @param other Const reference to the FastaSequence to compare against for equality.
+	 * @return True is returned if both the identifier and the sequence are equal.
+	 */
+	bool operator==(
+		const FastaSequence& other ) const
+	{
+		return ( _identifierView() == other._identifierView() )
+			and ( length() == other.length() )
+			and ( 0 == _compareSequence( other ) );
+	}
+
+	/**
+	 * Check for inequality of either the identifier
+	 * or the sequence; returning true if either are not equal.
+	 * @param other Const reference to the FastaSequence to compare against for inequality.
+	 * @return True is returned if either the identifier or the sequence are not equal.
+	 */
+	bool operator!=(
+		const FastaSequence& other ) const
+	{
+		return not this->operator==( other );
+	}
+
+	/**
+	 * Assign both the identifier and the sequence.
+	 * @param identifierAndSequence Const pair for both the identifier and the sequence.
+	 * @return Reference to this FastaSequence instance.
+	 */
+	FastaSequence& operator=(
+		const std::pair< std::string, std::string >& identifierAndSequence )
+	{
+		mIdentifier = identifierAndSequence.first;
+		mSequence = identifierAndSequence.second;
+
+		_normalizeIdentifier();
+		_normalizeSequence();
+
+		return *this;
+	}
+
+	/**
+	 * Copy assignment operator.
+	 * @param other Const reference to the FastaSequence to copy to this instance.
+	 * @return Reference to this FastaSequence instance.
+	 */
+	FastaSequence& operator=(
+		const FastaSequence& other )
+	{
+		if ( this != &other )
+		{
+			_copyAssign( other );
+		}
+
+		return *this;
+	}
+
+	/**
+	 * Move assignment operator.
+	 * @param other R-Value to the FastaSequence to move to this instance.
+	 * @return Reference to this FastaSequence instance.
+	 */
+	FastaSequence& operator=(
+		FastaSequence&& other ) noexcept
+	{
+		if ( this != &other )
+		{
+			_moveAssign( std::move( other ) );
+		}
+
+		return *this;
+	}
+
+	/**
+	 * Sequence string element access.
+	 * @param index Offset from the beginning of the sequence string.
+	 * @return Reference to the character at the given offset.
+	 */
+	char& operator[](
+		size_t index )
+	{
+		_materialize();
+		return mSequence[ index ];
+	}
+
+	/**
+	 * Const sequence string element access. The character is returned by value
+	 * so that packed sequences need not be unpacked.
+	 * @param index Offset from the beginning of the sequence string.
+	 * @return The character at the given offset.
+	 * @throw std::out_of_range is thrown if the index is greater than the sequence length.
+	 */
+	char operator[](
+		size_t index ) const
+	{
+		if ( _isExternal() )
+		{
+			if ( index >= this->length() )
+			{
+				throw std::out_of_range( "FastaSequence::operator[]: index is out of range" );
+			}
+
+			return _at( index );
+		}
+
+		_normalizePending();
+		return mSequence.at( index );
+	}
+
+	/**
+	 * Normalize the sequence now if its normalization was deferred, so later accesses do not pay for it.
+	 */
+	void normalize()
+	{
+		_normalizePending();
+	}
+
+	/**
+	 * Pack the sequence into 2 (or 4) bits per base; see FastaPackedSequence. The identifier,
+	 * length(), operator[] and copy() are unaffected. Mutable access unpacks the sequence.
+	 * @return True is returned if the sequence is packed. False is returned, and the sequence
+	 *         is left as is, if it holds characters that cannot be packed, such as amino acids.
+	 */
+	bool pack()
+	{
+		if ( mPackedSequence )
+		{
+			return true;
+		}
+
+		auto packedSequence = std::make_shared< FastaPackedSequence >();
+		const size_t length = this->length();
+
+		if ( mExternalSequence )
+		{
+			char buffer[ 4096 ];
+
+			for ( size_t position( 0 ); position < length; position += sizeof( buffer ) )
+			{
+				if ( not packedSequence->append( buffer, this->copy( buffer, sizeof( buffer ), position ) ) )
+				{
+					return false;
+				}
+			}
+		}
+		else if ( not packedSequence->append( mSequence.data(), length ) )
+		{
+			return false;
+		}
+
+		packedSequence->shrinkToFit();
+		_releaseExternal();
+		mSequence.clear();
+		mSequence.shrink_to_fit();
+		mPackedSequence = std::move( packedSequence );
+
+		return true;
+	}
+
+	/**
+	 * Reverse complement the sequence in place, keeping the case of each base; see
+	 * FastaKernels::complement. A view or packed sequence is copied into this instance first.
+	 */
+	void reverseComplement()
+	{
+		_materialize();
+
+		if ( not mSequence.empty() )
+		{
+			FastaKernels::reverseComplement( &mSequence[ 0 ], mSequence.length() );
+		}
+	}
+
+	/**
+	 * Write the reverse complement of the sequence into a buffer, leaving the sequence as is.
+	 * @param destination Pointer to the buffer receiving length() characters.
+	 */
+	void reverseComplement(
+		char* destination ) const
+	{
+		const size_t length = this->copy( destination, this->length() );
+
+		FastaKernels::reverseComplement( destination, length );
+	}
+
+	/**
+	 * Get the sequence. If the sequence is a view into a mapped file or
+	 * is packed, then it is copied into this instance on the first call;
+	 * the view or packed sequence is kept until the sequence is mutated.
+	 * @return A const reference to the sequence.
+	 */
+	const std::string& sequence() const
+	{
+		_copyExternal();
+		return mSequence;
+	}
+
+	/**
+	 * Set the alphabet of the sequence, removing any characters outside of it. Sequences accept
+	 * every ASCII letter, '-' and '*' unless restricted; the protein alphabet accepts the same.
+	 * The alphabet is kept by later calls to setSequence.
+	 * @param alphabet The alphabet to restrict the sequence to.
+	 */
+	void setAlphabet(
+		FastaAlphabet::Type alphabet )
+	{
+		if ( ( FastaAlphabet::Type::Any == alphabet ) or ( FastaAlphabet::Type::Protein == alphabet ) )
+		{
+			mAlphabet = alphabet;
+			return;
+		}
+
+		_materialize();
+		mAlphabet = alphabet;
+		_compactSequence();
+	}
+
+	/**
+	 * Set the identifier and normalize.
+	 * @param identifier Const reference to the identifier to assign to this object.
+	 */
+	void setIdentifier(
+		const std::string& identifier )
+	{
+		mIdentifier = identifier;
+		_normalizeIdentifier();
+	}
+
+	/**
+	 * Set the sequence and normalize.
+	 * @param sequence Const reference to the sequence to assign to this object.
+	 */
+	void setSequence(
+		const std::string& sequence )
+	{
+		mSequence = sequence;
+		_normalizeSequence();
+	}
+
+	/**
+	 * Set the sequence, normalizing it as given. A lazily normalized sequence keeps the given
+	 * bytes until its length or characters are first accessed; a trusted sequence must hold only
+	 * valid characters, apart from line terminators, which are removed.
+	 * @param sequence The sequence to assign to this object.
+	 * @param normalization How the sequence is normalized.
+	 */
+	void setSequence(
+		std::string sequence,
+		Normalization normalization )
+	{
+		mSequence = std::move( sequence );
+		_normalizeSequence( normalization );
+	}
+
+	/**
+	 * Release any excess capacity held by the identifier and the sequence, such as that left by append.
+	 */
+	void shrinkToFit()
+	{
+		mIdentifier.shrink_to_fit();
+		mSequence.shrink_to_fit();
+	}
+
+	/**
+	 * Translate the sequence into a protein with the same identifier. A trailing partial codon
+	 * is ignored; see FastaCodonTable for how ambiguous codons are translated.
+	 * @param frame The reading frame: 1, 2 or 3 translate from the first, second or third base,
+	 *              and -1, -2 or -3 do the same on the reverse complement. [default: 1]
+	 * @param codonTable Const reference to the genetic code. [default: FastaCodonTable::standard()]
+	 * @return The protein sequence is returned.
+	 * @throw std::out_of_range is thrown if the frame is not one of the above.
+	 */
+	FastaSequence translate(
+		int frame = 1,
+		const FastaCodonTable& codonTable = FastaCodonTable::standard() ) const
+	{
+		if ( ( 0 == frame ) or ( frame < -3 ) or ( 3 < frame ) )
+		{
+			throw std::out_of_range( "FastaSequence::translate: frame is out of range" );
+		}
+
+		const FastaStringView identifier = _identifierView();
+		const size_t offset = static_cast< size_t >( std::abs( frame ) - 1 );
+		const size_t length = this->length();
+		FastaSequence protein;
+		std::string strand;
+		const char* nucleotides = mSequence.data();
+
+		if ( frame < 0 )
+		{
+			strand.resize( length );
+			this->reverseComplement( &strand[ 0 ] );
+			nucleotides = strand.data();
+		}
+		else if ( _isExternal() )
+		{
+			strand.resize( length );
+			this->copy( &strand[ 0 ], length );
+			nucleotides = strand.data();
+		}
+
+		protein.mIdentifier.assign( identifier.data(), identifier.length() );
+		protein.mAlphabet = FastaAlphabet::Type::Protein;
+
+		if ( offset < length )
+		{
+			protein.mSequence.resize( ( length - offset ) / 3 );
+			codonTable.translate( nucleotides + offset, length - offset, &protein.mSequence[ 0 ] );
+		}
+
+		return protein;
+	}
+
+	/**
+	 * Unpack a packed sequence, or copy a view of an external sequence, into this instance.
+	 */
+	void unpack()
+	{
+		_materialize();
+	}
+
+	/**
+	 * Get a view of part of the sequence without copying it, in the manner of std::string::substr.
+	 * The view holds no reference to the sequence: it is valid until the sequence is mutated or
+	 * destroyed. Owned sequences are viewed in place, as are views of external bytes, such as
+	 * those of mapFile, as long as the bases viewed lie on a single line. Otherwise, and for
+	 * packed sequences, the sequence is copied first, as by sequence(), so that the view is
+	 * contiguous.
+	 * @param start Offset of the first base to view.
+	 * @param length The max number of bases to view. [default: the rest of the sequence]
+	 * @return The view of the bases is returned.
+	 * @throw std::out_of_range is thrown if start is greater than the sequence length.
+	 */
+	FastaStringView view(
+		size_t start,
+		size_t length = std::string::npos ) const
+	{
+		if ( start > this->length() )
+		{
+			throw std::out_of_range( "FastaSequence::view: start is out of range" );
+		}
+
+		length = std::min( length, this->length() - start );
+
+		if ( mExternalSequence and ( ( 0 == length ) or ( start / mExternalLineBases == ( start + length - 1 ) / mExternalLineBases ) ) )
+		{
+			return FastaStringView( ( 0 == length ) ? mExternalSequence.get() : &_externalAt( start ), length );
+		}
+
+		_copyExternal();
+
+		return FastaStringView( mSequence.data() + start, length );
+	}
+};
+
+#if defined( FASTA_HAS_INT128 )
+/**
+ * A 128-bit word holding a 2-bit encoded k-mer, for k up to 64.
+ */
+__extension__ typedef unsigned __int128 FastaKmer128;
+#endif
+
+/**
+ * This class is a view of the k-mers of a FastaSequence, encoded 2 bits per base as A = 0,
+ * C = 1, G = 2 and T = 3 with the first base in the highest bits. U is read as T, and either
+ * case is accepted. The k-mers are computed by a rolling update as the sequence is read in
+ * chunks, and windows holding any other character, such as N, are skipped. The Word is
+ * uint64_t for k up to 32, or FastaKmer128 for k up to 64.
+ */
+template < typename Word >
+class FastaKmerView
+{
+private:
+	// 2-bit code of every character, or 0xFF for characters that are not A, C, G, T or U.
+	struct CodeTable
+	{
+		uint8_t codes[ 256 ];
+
+		CodeTable()
+		{
+			std::memset( codes, 0xFF, sizeof( codes ) );
+
+			for ( uint8_t code( 0 ); code < 4; ++code )
+			{
+				const char character = FastaKernels::twoBitCharacters()[ code ];
+				codes[ static_cast< uint8_t >( character ) ] = code;
+				codes[ static_cast< uint8_t >( character | 0x20 ) ] = code;
+			}
+
+			codes[ static_cast< uint8_t >( 'U' ) ] = 3;
+			codes[ static_cast< uint8_t >( 'u' ) ] = 3;
+		}
+	};
+
+	static const CodeTable& _codeTable()
+	{
+		static const CodeTable codeTable;
+		return codeTable;
+	}
+
+	const FastaSequence* mSequence; // Sequence viewed.
+	size_t mK;                      // Bases per k-mer.
+	bool mIsCanonical;              // True if canonical k-mers are yielded.
+
+public:
+	/**
+	 * Class for iterating over the k-mers of the sequence in a single pass.
+	 */
+	class iterator
+	{
+	private:
+		friend class FastaKmerView;
+
+		const FastaSequence* mSequence; // Sequence read, or nullptr at the end.
+		size_t mK;
+		bool mIsCanonical;
+		Word mMask;                     // Low 2k bits set.
+		size_t mLength;                 // Length of the sequence.
+		size_t mPosition;               // Offset of the next base to read.
+		size_t mValidBases;             // Number of valid bases ending at mPosition, up to k.
+		Word mForward;                  // The last k bases read.
+		Word mReverse;                  // Reverse complement of the last k bases read.
+		Word mKmer;                     // The current k-mer.
+		size_t mBufferBegin;            // Offset in the sequence of the first buffered base.
+		size_t mBufferEnd;              // Offset in the sequence one past the last buffered base.
+		char mBuffer[ 256 ];            // Chunk of the sequence being read.
+
+		iterator(
+			const FastaSequence* sequence,
+			size_t k,
+			bool canonical )
+		{
+			mSequence = sequence;
+			mK = k;
+			mIsCanonical = canonical;
+			mMask = ( 8 * sizeof( Word ) == 2 * k ) ? ~static_cast< Word >( 0 ) : ( static_cast< Word >( 1 ) << ( 2 * k ) ) - 1;
+			mLength = ( nullptr == sequence ) ? 0 : sequence->length();
+			mPosition = 0;
+			mValidBases = 0;
+			mForward = 0;
+			mReverse = 0;
+			mKmer = 0;
+			mBufferBegin = 0;
+			mBufferEnd = 0;
+
+			if ( nullptr != mSequence )
+			{
+				_advance();
+			}
+		}
+
+		// Read bases up to the end of the next window of k valid bases.
+		void _advance()
+		{
+			const uint8_t* codes = _codeTable().codes;
+			const unsigned reverseShift = static_cast< unsigned >( 2 * ( mK - 1 ) );
+
+			for ( ; mPosition < mLength; )
+			{
+				if ( mPosition == mBufferEnd )
+				{
+					mBufferBegin = mPosition;
+					mBufferEnd = mPosition + mSequence->copy( mBuffer, sizeof( mBuffer ), mPosition );
+				}
+
+				const uint8_t code = codes[ static_cast< uint8_t >( mBuffer[ mPosition++ - mBufferBegin ] ) ];
+
+				if ( 0xFF == code )
+				{
+					mValidBases = 0;
+					continue;
+				}
+
+				mForward = ( ( mForward << 2 ) | code ) & mMask;
+				mReverse = ( mReverse >> 2 ) | ( static_cast< Word >( 3 - code ) << reverseShift );
+				mValidBases += ( mValidBases < mK );
+
+				if ( mValidBases == mK )
+				{
+					mKmer = ( mIsCanonical and ( mReverse < mForward ) ) ? mReverse : mForward;
+					return;
+				}
+			}
+
+			mSequence = nullptr;
+		}
+
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = Word;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Word*;
+		using reference = const Word&;
+
+		/**
+		 * Default constructor, for the end of the k-mers.
+		 */
+		iterator() :
+			iterator( nullptr, 1, true )
+		{
+		}
+
+		/**
+		 * Get the offset in the sequence of the first base of the current k-mer.
+		 * @return The position of the current k-mer is returned.
+		 */
+		size_t position() const
+		{
+			return mPosition - mK;
+		}
+
+		bool operator==(
+			const iterator& other ) const
+		{
+			return ( mSequence == other.mSequence ) and ( ( nullptr == mSequence ) or ( mPosition == other.mPosition ) );
+		}
+
+		bool operator!=(
+			const iterator& other ) const
+		{
+			return not this->operator==( other );
+		}
+
+		const Word& operator*() const
+		{
+			return mKmer;
+		}
+
+		iterator& operator++()
+		{
+			_advance();
+			return *this;
+		}
+
+		iterator operator++( int )
+		{
+			iterator current( *this );
+			_advance();
+			return current;
+		}
+	};
+
+	/**
+	 * Constructor.
+	 * @param sequence Const reference to the sequence to view; it must outlive the view.
+	 * @param k The number of bases in each k-mer.
+	 * @param canonical Flag whether each k-mer or its reverse complement, whichever is smaller, is yielded. [default: true]
+	 * @throw std::out_of_range is thrown if k is zero or more than four times the size of the Word.
+	 */
+	FastaKmerView(
+		const FastaSequence& sequence,
+		size_t k,
+		bool canonical = true )
+	{
+		if ( ( 0 == k ) or ( 4 * sizeof( Word ) < k ) )
+		{
+			throw std::out_of_range( "FastaKmerView::FastaKmerView: k is out of range" );
+		}
+
+		mSequence = &sequence;
+		mK = k;
+		mIsCanonical = canonical;
+	}
+
+	/**
+	 * Get an iterator to the first k-mer.
+	 * @return An iterator to the first k-mer is returned.
+	 */
+	iterator begin() const
+	{
+		return iterator( mSequence, mK, mIsCanonical );
+	}
+
+	/**
+	 * Decode a k-mer into its bases.
+	 * @param kmer The 2-bit encoded k-mer.
+	 * @param k The number of bases in the k-mer.
+	 * @return The bases of the k-mer are returned.
+	 */
+	static std::string decode(
+		Word kmer,
+		size_t k )
+	{
+		std::string bases( k, 'A' );
+
+		for ( size_t base( k ); 0 < base; --base, kmer >>= 2 )
+		{
+			bases[ base - 1 ] = FastaKernels::twoBitCharacters()[ static_cast< unsigned >( kmer & 0x3 ) ];
+		}
+
+		return bases;
+	}
+
+	/**
+	 * Get an iterator to the end of the k-mers.
+	 * @return An iterator to the end of the k-mers is returned.
+	 */
+	iterator end() const
+	{
+		return iterator();
+	}
+
+	/**
+	 * Check if the view yields canonical k-mers.
+	 * @return True is returned if canonical k-mers are yielded.
+	 */
+	bool isCanonical() const
+	{
+		return mIsCanonical;
+	}
+
+	/**
+	 * Get the number of bases in each k-mer.
+	 * @return The k of the view is returned.
+	 */
+	size_t k() const
+	{
+		return mK;
+	}
+};
+
+/**
+ * This class counts k-mers in hash tables sharded by k-mer hash, so that several threads
+ * can count at once; each thread adds through an Inserter of its own, which hands its k-mers
+ * to each shard in batches under the lock of that shard. Each shard is an open addressing
+ * table. The Word is as for FastaKmerView.
+ */
+template < typename Word >
+class FastaKmerCounter
+{
+private:
+	// Slot of a shard table; a count of zero marks an empty slot.
+	struct Entry
+	{
+		Word kmer;
+		size_t count;
+	};
+
+	struct Shard
+	{
+		std::mutex mutex;
+		std::vector< Entry > entries; // Open addressing table; its size is a power of two.
+		size_t size;                  // Number of k-mers in the table.
+	};
+
+	size_t mK;
+	bool mIsCanonical;
+	std::vector< std::unique_ptr< Shard > > mShards; // The shards; their number is a power of two.
+
+	static uint64_t _hash(
+		uint64_t kmer )
+	{
+		kmer ^= kmer >> 33;
+		kmer *= 0xFF51AFD7ED558CCDull;
+		kmer ^= kmer >> 33;
+		kmer *= 0xC4CEB9FE1A85EC53ull;
+		kmer ^= kmer >> 33;
+
+		return kmer;
+	}
+
+#if defined( FASTA_HAS_INT128 )
+	static uint64_t _hash(
+		FastaKmer128 kmer )
+	{
+		return _hash( static_cast< uint64_t >( kmer ) ^ _hash( static_cast< uint64_t >( kmer >> 64 ) ) );
+	}
+#endif
+
+	// Shard of the hash; its high bits pick the shard, of which there are at most 2^16, and its low bits the slot.
+	size_t _shardIndex(
+		uint64_t hash ) const
+	{
+		return static_cast< size_t >( hash >> 40 ) & ( mShards.size() - 1 );
+	}
+
+	// Slot holding the k-mer in the table, or the empty slot where it belongs.
+	static size_t _findSlot(
+		const std::vector< Entry >& entries,
+		Word kmer,
+		uint64_t hash )
+	{
+		const size_t mask = entries.size() - 1;
+		size_t slot = static_cast< size_t >( hash ) & mask;
+
+		while ( ( 0 != entries[ slot ].count ) and ( kmer != entries[ slot ].kmer ) )
+		{
+			slot = ( slot + 1 ) & mask;
+		}
+
+		return slot;
+	}
+
+	// Add count occurrences of the k-mer to the shard, which must be locked.
+	static void _insert(
+		Shard& shard,
+		Word kmer,
+		size_t count )
+	{
+		if ( 2 * ( shard.size + 1 ) > shard.entries.size() )
+		{
+			std::vector< Entry > entries( std::max( 2 * shard.entries.size(), static_cast< size_t >( 1024 ) ), Entry{ 0, 0 } );
+
+			for ( const Entry& entry : shard.entries )
+			{
+				if ( 0 != entry.count )
+				{
+					entries[ _findSlot( entries, entry.kmer, _hash( entry.kmer ) ) ] = entry;
+				}
+			}
+
+			shard.entries.swap( entries );
+		}
+
+		Entry& entry = shard.entries[ _findSlot( shard.entries, kmer, _hash( kmer ) ) ];
+
+		shard.size += ( 0 == entry.count );
+		entry.kmer = kmer;
+		entry.count += count;
+	}
+
+public:
+	/**
+	 * This class adds k-mers to the counter in batches, one batch per shard, for a single thread.
+	 * The batches are flushed when full, by flush, and when the inserter is destroyed.
+	 */
+	class Inserter
+	{
+	private:
+		FastaKmerCounter* mCounter;
+		std::vector< std::vector< Word > > mBatches; // Pending k-mers of each shard.
+
+	public:
+		/**
+		 * Constructor.
+		 * @param counter Reference to the counter to add to; it must outlive the inserter.
+		 */
+		explicit Inserter(
+			FastaKmerCounter& counter )
+		{
+			mCounter = &counter;
+			mBatches.resize( counter.mShards.size() );
+		}
+
+		Inserter(
+			const Inserter& other ) = delete;
+
+		Inserter& operator=(
+			const Inserter& other ) = delete;
+
+		/**
+		 * Destructor. Flushes the pending k-mers.
+		 */
+		~Inserter()
+		{
+			this->flush();
+		}
+
+		/**
+		 * Add the k-mers of a sequence.
+		 * @param sequence Const reference to the sequence to count the k-mers of.
+		 */
+		void add(
+			const FastaSequence& sequence )
+		{
+			for ( const Word kmer : sequence.kmers< Word >( mCounter->mK, mCounter->mIsCanonical ) )
+			{
+				this->add( kmer );
+			}
+		}
+
+		/**
+		 * Add a single k-mer.
+		 * @param kmer The 2-bit encoded k-mer to count.
+		 */
+		void add(
+			Word kmer )
+		{
+			const size_t shardIndex = mCounter->_shardIndex( _hash( kmer ) );
+			std::vector< Word >& batch = mBatches[ shardIndex ];
+
+			batch.push_back( kmer );
+
+			if ( 1024 <= batch.size() )
+			{
+				_flushBatch( shardIndex );
+			}
+		}
+
+		/**
+		 * Add every pending k-mer to the counter.
+		 */
+		void flush()
+		{
+			for ( size_t shardIndex( 0 ); shardIndex < mBatches.size(); ++shardIndex )
+			{
+				_flushBatch( shardIndex );
+			}
+		}
+
+	private:
+		void _flushBatch(
+			size_t shardIndex )
+		{
+			std::vector< Word >& batch = mBatches[ shardIndex ];
+
+			if ( not batch.empty() )
+			{
+				Shard& shard = *mCounter->mShards[ shardIndex ];
+				std::lock_guard< std::mutex > lock( shard.mutex );
+
+				for ( const Word kmer : batch )
+				{
+					_insert( shard, kmer, 1 );
+				}
+
+				batch.clear();
+			}
+		}
+	};
+
+	/**
+	 * Constructor.
+	 * @param k The number of bases in each k-mer.
+	 * @param canonical Flag whether k-mers are counted together with their reverse complement. [default: true]
+	 * @param shardCount The number of shards, rounded up to a power of two of at most 65536. [default: 64]
+	 * @throw std::out_of_range is thrown if k is zero or more than four times the size of the Word.
+	 */
+	explicit FastaKmerCounter(
+		size_t k,
+		bool canonical = true,
+		size_t shardCount = 64 )
+	{
+		if ( ( 0 == k ) or ( 4 * sizeof( Word ) < k ) )
+		{
+			throw std::out_of_range( "FastaKmerCounter::FastaKmerCounter: k is out of range" );
+		}
+
+		mK = k;
+		mIsCanonical = canonical;
+
+		size_t roundedShardCount( 1 );
+
+		while ( roundedShardCount < shardCount and roundedShardCount < ( static_cast< size_t >( 1 ) << 16 ) )
+		{
+			roundedShardCount *= 2;
+		}
+
+		for ( size_t shard( 0 ); shard < roundedShardCount; ++shard )
+		{
+			mShards.emplace_back( new Shard );
+			mShards.back()->size = 0;
+		}
+	}
+
+	/**
+	 * Count the k-mers of a sequence. Several threads may add at once.
+	 * @param sequence Const reference to the sequence to count the k-mers of.
+	 */
+	void add(
+		const FastaSequence& sequence )
+	{
+		Inserter( *this ).add( sequence );
+	}
+
+	/**
+	 * Get the number of times a k-mer was counted. Not safe while k-mers are being added.
+	 * @param kmer The 2-bit encoded k-mer, canonical if the counter is.
+	 * @return The count of the k-mer is returned.
+	 */
+	size_t count(
+		Word kmer ) const
+	{
+		const uint64_t hash = _hash( kmer );
+		const Shard& shard = *mShards[ _shardIndex( hash ) ];
+
+		return shard.entries.empty() ? 0 : shard.entries[ _findSlot( shard.entries, kmer, hash ) ].count;
+	}
+
+	/**
+	 * Invoke function( kmer, count ) for every k-mer counted, in no particular order.
+	 * Not safe while k-mers are being added.
+	 * @param function The function to invoke.
+	 */
+	template < typename Function >
+	void forEach(
+		Function function ) const
+	{
+		for ( const auto& shard : mShards )
+		{
+			for ( const Entry& entry : shard->entries )
+			{
+				if ( 0 != entry.count )
+				{
+					function( entry.kmer, entry.count );
+				}
+			}
+		}
+	}
+
+	/**
+	 * Check if k-mers are counted together with their reverse complement.
+	 * @return True is returned if canonical k-mers are counted.
+	 */
+	bool isCanonical() const
+	{
+		return mIsCanonical;
+	}
+
+	/**
+	 * Get the number of bases in each k-mer.
+	 * @return The k of the counter is returned.
+	 */
+	size_t k() const
+	{
+		return mK;
+	}
+
+	/**
+	 * Get the number of distinct k-mers counted. Not safe while k-mers are being added.
+	 * @return The number of distinct k-mers is returned.
+	 */
+	size_t size() const
+	{
+		size_t size( 0 );
+
+		for ( const auto& shard : mShards )
+		{
+			size += shard->size;
+		}
+
+		return size;
+	}
+};
+
+/**
+ * Composition statistics of a single record; see FastaComposition.
+ */
+struct FastaRecordStatistics
+{
+	std::string identifier; // Normalized identifier of the record.
+	size_t length;          // Number of sequence characters.
+	size_t gcBases;         // G, C and S, in either case.
+	size_t atBases;         // A, T, U and W, in either case.
+	size_t nBases;          // N, in either case.
+	size_t softMaskedBases; // Lowercase letters.
+
+	/**
+	 * Get the GC content: the fraction of the bases of known strength that are G or C.
+	 * @return The GC content is returned; zero if there are no such bases.
+	 */
+	double gcContent() const
+	{
+		return ( 0 == gcBases + atBases ) ? 0 : static_cast< double >( gcBases ) / ( gcBases + atBases );
+	}
+
+	/**
+	 * Get the fraction of the sequence that is soft-masked, i.e. lowercase.
+	 * @return The soft-masked fraction is returned; zero for an empty sequence.
+	 */
+	double softMaskedFraction() const
+	{
+		return ( 0 == length ) ? 0 : static_cast< double >( softMaskedBases ) / length;
+	}
+};
+
+/**
+ * This class holds the histogram of the characters of one or more sequences, counted by
+ * FastaKernels::histogram. Bytes that are not sequence characters, such as the line
+ * terminators of sequences that are not normalized yet, are counted but left out of the
+ * statistics derived from the histogram.
+ */
+class FastaComposition
+{
+private:
+	friend class FastaStatistics;
+
+	// Classes of a byte, as flags; every combination is below ClassCount.
+	enum BaseClass : uint8_t
+	{
+		StrongBase = 0x1,        // G, C or S, in either case.
+		WeakBase = 0x2,          // A, T, U or W, in either case.
+		UnknownBase = 0x4,       // N, in either case.
+		SoftMaskedBase = 0x8,    // A lowercase letter.
+		SequenceCharacter = 0x10 // A sequence character; see FastaKernels::isValidSequenceCharacter.
+	};
+
+	static const size_t ClassCount = 32;
+
+	// Classes of every byte.
+	struct ClassTable
+	{
+		uint8_t classes[ 256 ];
+
+		constexpr ClassTable() :
+			classes()
+		{
+			const char* const members[] = { "GCS", "ATUW", "N" };
+			const uint8_t flags[] = { StrongBase, WeakBase, UnknownBase };
+
+			for ( unsigned byte( 0 ); byte < 256; ++byte )
+			{
+				classes[ byte ] = FastaKernels::isValidSequenceCharacter( static_cast< char >( byte ) ) ? SequenceCharacter : 0;
+			}
+
+			for ( unsigned byte( 'a' ); byte <= 'z'; ++byte )
+			{
+				classes[ byte ] |= SoftMaskedBase;
+			}
+
+			for ( size_t member( 0 ); member < 3; ++member )
+			{
+				for ( const char* character = members[ member ]; '\0' != *character; ++character )
+				{
+					classes[ static_cast< uint8_t >( *character ) ] |= flags[ member ];
+					classes[ static_cast< uint8_t >( *character | 0x20 ) ] |= flags[ member ];
+				}
+			}
+		}
+	};
+
+	static const ClassTable& _classTable()
+	{
+		static constexpr ClassTable table;
+
+		return table;
+	}
+
+	// Add count occurrences of bytes of the given classes to the statistics.
+	static void _tally(
+		FastaRecordStatistics& statistics,
+		uint8_t classes,
+		uint64_t count )
+	{
+		statistics.length += ( 0 != ( classes & SequenceCharacter ) ) ? count : 0;
+		statistics.gcBases += ( 0 != ( classes & StrongBase ) ) ? count : 0;
+		statistics.atBases += ( 0 != ( classes & WeakBase ) ) ? count : 0;
+		statistics.nBases += ( 0 != ( classes & UnknownBase ) ) ? count : 0;
+		statistics.softMaskedBases += ( 0 != ( classes & SoftMaskedBase ) ) ? count : 0;
+	}
+
+	// Statistics of the histogram so far.
+	FastaRecordStatistics _summary() const
+	{
+		FastaRecordStatistics summary = {};
+
+		for ( unsigned byte( 0 ); byte < 256; ++byte )
+		{
+			_tally( summary, _classTable().classes[ byte ], counts[ byte ] );
+		}
+
+		return summary;
+	}
+
+public:
+	uint64_t counts[ 256 ]; // Occurrences of every byte.
+
+	/**
+	 * Default constructor to an empty histogram.
+	 */
+	FastaComposition()
+	{
+		this->reset();
+	}
+
+	/**
+	 * Count the characters of a sequence.
+	 * @param data Pointer to the characters.
+	 * @param length The number of characters.
+	 */
+	void add(
+		const char* data,
+		size_t length )
+	{
+		FastaKernels::histogram( data, length, counts );
+	}
+
+	/**
+	 * Add the counts of another histogram.
+	 * @param other Const reference to the histogram to add.
+	 */
+	void add(
+		const FastaComposition& other )
+	{
+		for ( unsigned byte( 0 ); byte < 256; ++byte )
+		{
+			counts[ byte ] += other.counts[ byte ];
+		}
+	}
+
+	/**
+	 * Get the number of A, T, U and W, in either case.
+	 * @return The number of weak bases is returned.
+	 */
+	size_t atBases() const
+	{
+		return _summary().atBases;
+	}
+
+	/**
+	 * Get the number of occurrences of a character, in either case if it is a letter.
+	 * @param character The character to count.
+	 * @return The number of occurrences is returned.
+	 */
+	size_t count(
+		char character ) const
+	{
+		const uint8_t byte = static_cast< uint8_t >( character );
+
+		return ( static_cast< uint8_t >( ( byte | 0x20 ) - 'a' ) < 26 )
+			? counts[ byte & ~0x20 ] + counts[ byte | 0x20 ]
+			: counts[ byte ];
+	}
+
+	/**
+	 * Get the number of G, C and S, in either case.
+	 * @return The number of strong bases is returned.
+	 */
+	size_t gcBases() const
+	{
+		return _summary().gcBases;
+	}
+
+	/**
+	 * Get the GC content: the fraction of the bases of known strength that are G or C.
+	 * @return The GC content is returned; zero if there are no such bases.
+	 */
+	double gcContent() const
+	{
+		return _summary().gcContent();
+	}
+
+	/**
+	 * Get the number of sequence characters: the ASCII letters, '-' and '*'.
+	 * @return The number of sequence characters is returned.
+	 */
+	size_t length() const
+	{
+		return _summary().length;
+	}
+
+	/**
+	 * Get the number of N, in either case.
+	 * @return The number of unknown bases is returned.
+	 */
+	size_t nBases() const
+	{
+		return _summary().nBases;
+	}
+
+	/**
+	 * Clear the histogram.
+	 */
+	void reset()
+	{
+		std::memset( counts, 0, sizeof( counts ) );
+	}
+
+	/**
+	 * Get the number of lowercase letters.
+	 * @return The number of soft-masked bases is returned.
+	 */
+	size_t softMaskedBases() const
+	{
+		return _summary().softMaskedBases;
+	}
+
+	/**
+	 * Get the fraction of the sequence characters that are soft-masked, i.e. lowercase.
+	 * @return The soft-masked fraction is returned; zero if there are no sequence characters.
+	 */
+	double softMaskedFraction() const
+	{
+		return _summary().softMaskedFraction();
+	}
+};
+
+/**
+ * This class gathers statistics while a FastA file is read or written, and can report them
+ * periodically through a progress callback. Pass one to FastaFile::readFile or writeFile, or
+ * attach one to a FastaReader or FastaWriter. Times are in seconds; when several threads
+ * load a file, the time spent in each phase is summed across the threads.
+ */
+class FastaStatistics
+{
+private:
+	friend class FastaFile;
+	friend class FastaReader;
+	friend class FastaWriter;
+
+	double mStartTime;        // When gathering started.
+	double mLastProgressTime; // When progress was last reported.
+
+	// Count the characters of a record into composition and append its statistics to records.
+	// The statistics are tallied from the counts of the few classes of FastaComposition: short
+	// records are counted into both directly, as FastaKernels::histogram counts short inputs,
+	// and long ones into a histogram of their own, which is then folded into the classes.
+	static void _gatherComposition(
+		FastaComposition& composition,
+		std::vector< FastaRecordStatistics >& records,
+		FastaStringView identifier,
+		const char* data,
+		size_t length )
+	{
+		const uint8_t* const classes = FastaComposition::_classTable().classes;
+		uint64_t classCounts[ FastaComposition::ClassCount ] = {};
+		FastaRecordStatistics record = {};
+
+		if ( length < 1024 )
+		{
+			const uint8_t* bytes = reinterpret_cast< const uint8_t* >( data );
+
+			for ( size_t offset( 0 ); offset < length; ++offset )
+			{
+				++composition.counts[ bytes[ offset ] ];
+				++classCounts[ classes[ bytes[ offset ] ] ];
+			}
+		}
+		else
+		{
+			uint64_t counts[ 256 ] = {};
+
+			FastaKernels::histogram( data, length, counts );
+
+			for ( unsigned byte( 0 ); byte < 256; ++byte )
+			{
+				composition.counts[ byte ] += counts[ byte ];
+				classCounts[ classes[ byte ] ] += counts[ byte ];
+			}
+		}
+
+		for ( uint8_t byteClass( 0 ); byteClass < FastaComposition::ClassCount; ++byteClass )
+		{
+			FastaComposition::_tally( record, byteClass, classCounts[ byteClass ] );
+		}
+
+		record.identifier.assign( identifier.data(), identifier.length() );
+		records.push_back( std::move( record ) );
+	}
+
+	// Gather the composition of a record into these statistics, if it is gathered.
+	void _gatherComposition(
+		FastaStringView identifier,
+		const char* data,
+		size_t length )
+	{
+		if ( isCompositionGathered )
+		{
+			_gatherComposition( composition, recordStatistics, identifier, data, length );
+		}
+	}
+
+	// Compute the N50 and L50 from the lengths of the records.
+	void _n50(
+		size_t& n50,
+		size_t& l50 ) const
+	{
+		std::vector< size_t > lengths;
+		size_t total( 0 );
+
+		lengths.reserve( recordStatistics.size() );
+
+		for ( const auto& record : recordStatistics )
+		{
+			lengths.push_back( record.length );
+			total += record.length;
+		}
+
+		std::sort( lengths.begin(), lengths.end(), std::greater< size_t >() );
+
+		size_t sum( 0 );
+
+		n50 = 0;
+		l50 = 0;
+
+		while ( ( l50 < lengths.size() ) and ( 2 * sum < total ) )
+		{
+			n50 = lengths[ l50++ ];
+			sum += n50;
+		}
+	}
+
+	// Update the elapsed time and report progress if the interval has passed.
+	void _progress()
+	{
+		const double time = now();
+
+		elapsedSeconds = time - mStartTime;
+
+		if ( progress and ( time - mLastProgressTime >= progressInterval ) )
+		{
+			mLastProgressTime = time;
+			progress( *this );
+		}
+	}
+
+public:
+	size_t bytes;             // Bytes read from the input, or written to the output.
+	size_t records;           // Records parsed, or written.
+	size_t duplicatesDropped; // Records dropped because duplicate identifiers are not allowed.
+	size_t charactersRemoved; // Sequence characters removed by normalization, line terminators included.
+	double elapsedSeconds;    // Time since gathering started.
+	double ioSeconds;         // Time spent reading from the source or writing to the sink.
+	double normalizeSeconds;  // Time spent normalizing identifiers and sequences, and gathering their composition.
+	double insertSeconds;     // Time spent inserting records into the container.
+	double progressInterval;  // Least time between two progress reports.
+	std::function< void( const FastaStatistics& ) > progress; // Called with the statistics so far, if set.
+	bool isCompositionGathered; // Flag to gather the composition of the records read; off by default.
+	FastaComposition composition; // Characters of every record read, if gathered.
+	std::vector< FastaRecordStatistics > recordStatistics; // Statistics of every record read, in order, if gathered.
+
+	/**
+	 * Default constructor. Starts the clock with every count at zero and a progress interval of one second.
+	 */
+	FastaStatistics()
+	{
+		progressInterval = 1;
+		isCompositionGathered = false;
+		this->reset();
+	}
+
+	/**
+	 * Get the L50 of the records read: the fewest records whose lengths add up to at least half
+	 * of the total. The composition must be gathered.
+	 * @return The L50 is returned; zero if no records were read.
+	 */
+	size_t l50() const
+	{
+		size_t n50, l50;
+		_n50( n50, l50 );
+
+		return l50;
+	}
+
+	/**
+	 * Get the N50 of the records read: the length of the shortest of the longest records whose
+	 * lengths add up to at least half of the total. The composition must be gathered.
+	 * @return The N50 is returned; zero if no records were read.
+	 */
+	size_t n50() const
+	{
+		size_t n50, l50;
+		_n50( n50, l50 );
+
+		return n50;
+	}
+
+	/**
+	 * Get the time of the clock the statistics are measured with.
+	 * @return The time in seconds since an arbitrary epoch is returned.
+	 */
+	static double now()
+	{
+		return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+	}
+
+	/**
+	 * Reset every count to zero and restart the clock. The progress callback, the interval and
+	 * whether the composition is gathered are kept.
+	 */
+	void reset()
+	{
+		mStartTime = now();
+		mLastProgressTime = mStartTime;
+		bytes = 0;
+		records = 0;
+		duplicatesDropped = 0;
+		charactersRemoved = 0;
+		elapsedSeconds = 0;
+		ioSeconds = 0;
+		normalizeSeconds = 0;
+		insertSeconds = 0;
+		composition.reset();
+		recordStatistics.clear();
+	}
+};
+
+/**
+ * Interface to a sequential source of bytes for FastaReader.
+ */
+class FastaInputSource
+{
+public:
+	virtual ~FastaInputSource() = default;
+
+	/**
+	 * Read up to capacity bytes from the source.
+	 * @param destination Pointer to the buffer to read into.
+	 * @param capacity The max number of bytes to read.
+	 * @param bytesRead Reference to store the number of bytes read in; zero at the end of input.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	virtual int read(
+		char* destination,
+		size_t capacity,
+		size_t& bytesRead ) = 0;
+};
+
+/**
+ * FastaInputSource reading from a std::istream.
+ */
+class FastaStreamSource : public FastaInputSource
+{
+private:
+	std::istream& mInputStream; // The stream to read from.
+
+public:
+	/**
+	 * Constructor.
+	 * @param inputStream Reference to the stream to read from. It must outlive this instance.
+	 */
+	explicit FastaStreamSource(
+		std::istream& inputStream ) :
+		mInputStream( inputStream )
+	{
+	}
+
+	int read(
+		char* destination,
+		size_t capacity,
+		size_t& bytesRead ) override
+	{
+		mInputStream.read( destination, capacity );
+		bytesRead = static_cast< size_t >( mInputStream.gcount() );
+
+		return ( mInputStream.bad() ) ? EIO : 0;
+	}
+};
+
+#if defined( FASTA_HAS_POSIX )
+/**
+ * FastaInputSource reading from a file descriptor.
+ */
+class FastaFileDescriptorSource : public FastaInputSource
+{
+private:
+	int mFileDescriptor;     // The descriptor to read from.
+	bool mOwnsDescriptor;    // Flag to close the descriptor on destruction.
+
+public:
+	/**
+	 * Constructor.
+	 * @param fileDescriptor The descriptor to read from.
+	 * @param ownsDescriptor Flag to close the descriptor when this instance is destroyed. [default: false]
+	 */
+	explicit FastaFileDescriptorSource(
+		int fileDescriptor,
+		bool ownsDescriptor = false )
+	{
+		mFileDescriptor = fileDescriptor;
+		mOwnsDescriptor = ownsDescriptor;
+	}
+
+	FastaFileDescriptorSource(
+		const FastaFileDescriptorSource& other ) = delete;
+
+	FastaFileDescriptorSource& operator=(
+		const FastaFileDescriptorSource& other ) = delete;
+
+	~FastaFileDescriptorSource() override
+	{
+		if ( mOwnsDescriptor and ( -1 != mFileDescriptor ) )
+		{
+			::close( mFileDescriptor );
+		}
+	}
+
+	int read(
+		char* destination,
+		size_t capacity,
+		size_t& bytesRead ) override
+	{
+		ssize_t result;
+
+		do
+		{
+			result = ::read( mFileDescriptor, destination, capacity );
+		} while ( ( 0 > result ) and ( EINTR == errno ) );
+
+		bytesRead = ( 0 > result ) ? 0 : static_cast< size_t >( result );
+
+		return ( 0 > result ) ? errno : 0;
+	}
+};
+#endif
+
+/**
+ * This class detects gzip and BGZF compressed input and, when built with zlib, inflates
+ * BGZF blocks. BGZF files are gzip files made of independent members of at most 64KiB,
+ * each recording its compressed size in a "BC" extra subfield, which allows the blocks
+ * to be inflated in parallel and located through a .gzi index.
+ */
+class FastaCompression
+{
+public:
+	/**
+	 * Compression format of an input.
+	 */
+	enum class Format
+	{
+		None,
+		Gzip,
+		Bgzf
+	};
+
+	/**
+	 * Size of the BGZF header probe; enough for the extra fields written by common tools.
+	 */
+	static const size_t ProbeLength = 512;
+
+	/**
+	 * Get the size of the BGZF block starting at data.
+	 * @param data Pointer to the start of the block.
+	 * @param length The number of bytes available at data.
+	 * @return The size of the whole block in bytes is returned, or zero if data does not start
+	 *         with a BGZF header or the header is not fully available.
+	 */
+	static size_t bgzfBlockSize(
+		const char* data,
+		size_t length )
+	{
+		if ( ( 12 > length ) or ( 0x1F != static_cast< uint8_t >( data[ 0 ] ) ) or
+			( 0x8B != static_cast< uint8_t >( data[ 1 ] ) ) or ( 8 != data[ 2 ] ) or ( 0 == ( data[ 3 ] & 4 ) ) )
+		{
+			return 0;
+		}
+
+		const size_t extraEnd = 12 + readLittleEndian( data + 10, 2 );
+
+		if ( extraEnd > length )
+		{
+			return 0;
+		}
+
+		for ( size_t subfield( 12 ); subfield + 4 <= extraEnd; )
+		{
+			const size_t subfieldLength = readLittleEndian( data + subfield + 2, 2 );
+
+			if ( ( 'B' == data[ subfield ] ) and ( 'C' == data[ subfield + 1 ] ) and ( 2 == subfieldLength ) and
+				( subfield + 6 <= extraEnd ) )
+			{
+				return readLittleEndian( data + subfield + 4, 2 ) + 1;
+			}
+
+			subfield += 4 + subfieldLength;
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Detect the compression format from the first bytes of an input.
+	 * @param data Pointer to the first bytes of the input.
+	 * @param length The number of bytes available at data; ProbeLength bytes suffice.
+	 * @return The format of the input is returned.
+	 */
+	static Format detect(
+		const char* data,
+		size_t length )
+	{
+		if ( ( 2 > length ) or ( 0x1F != static_cast< uint8_t >( data[ 0 ] ) ) or
+			( 0x8B != static_cast< uint8_t >( data[ 1 ] ) ) )
+		{
+			return Format::None;
+		}
+
+		return ( 0 < bgzfBlockSize( data, length ) ) ? Format::Bgzf : Format::Gzip;
+	}
+
+	/**
+	 * Detect the compression format of a file from its first bytes.
+	 * @param filename The name of the file to inspect.
+	 * @return The format of the file is returned; Format::None if it cannot be read.
+	 */
+	static Format detectFile(
+		const std::string& filename )
+	{
+		std::ifstream inputFile( filename, std::ios::in | std::ios::binary );
+		char probe[ ProbeLength ];
+
+		inputFile.read( probe, sizeof( probe ) );
+
+		return detect( probe, static_cast< size_t >( inputFile.gcount() ) );
+	}
+
+	/**
+	 * Decode a little endian unsigned integer.
+	 * @param data Pointer to the encoded bytes.
+	 * @param byteCount The number of bytes to decode, up to eight.
+	 * @return The decoded value is returned.
+	 */
+	static uint64_t readLittleEndian(
+		const char* data,
+		size_t byteCount )
+	{
+		uint64_t value( 0 );
+
+		while ( 0 < byteCount-- )
+		{
+			value = ( value << 8 ) | static_cast< uint8_t >( data[ byteCount ] );
+		}
+
+		return value;
+	}
+
+#if defined( FASTA_HAS_ZLIB )
+	/**
+	 * Inflate a whole BGZF block, checking its length and CRC.
+	 * @param block Pointer to the start of the block.
+	 * @param blockSize The size of the block, as returned by bgzfBlockSize.
+	 * @param output Reference to the string to store the contents of the block in. Its capacity is reused.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         EIO is returned if the block is corrupt.
+	 */
+	static int inflateBgzfBlock(
+		const char* block,
+		size_t blockSize,
+		std::string& output )
+	{
+		const size_t payloadBegin = 12 + readLittleEndian( block + 10, 2 );
+
+		output.clear();
+
+		if ( payloadBegin + 8 > blockSize )
+		{
+			return EIO;
+		}
+
+		const size_t payloadEnd = blockSize - 8;
+		const uint32_t checksum = static_cast< uint32_t >( readLittleEndian( block + payloadEnd, 4 ) );
+		const size_t contentLength = readLittleEndian( block + payloadEnd + 4, 4 );
+		z_stream stream;
+
+		output.resize( contentLength );
+		std::memset( &stream, 0, sizeof( stream ) );
+
+		if ( Z_OK != inflateInit2( &stream, -15 ) )
+		{
+			return ENOMEM;
+		}
+
+		stream.next_in = reinterpret_cast< Bytef* >( const_cast< char* >( block + payloadBegin ) );
+		stream.avail_in = static_cast< uInt >( payloadEnd - payloadBegin );
+		stream.next_out = reinterpret_cast< Bytef* >( &output[ 0 ] );
+		stream.avail_out = static_cast< uInt >( contentLength );
+
+		const int result = inflate( &stream, Z_FINISH );
+		const size_t inflatedLength = stream.total_out;
+
+		inflateEnd( &stream );
+
+		if ( ( Z_STREAM_END != result ) or ( inflatedLength != contentLength ) or
+			( checksum != crc32( 0, reinterpret_cast< const Bytef* >( output.data() ), static_cast< uInt >( contentLength ) ) ) )
+		{
+			output.clear();
+			return EIO;
+		}
+
+		return 0;
+	}
+#endif
+};
+
+#if defined( FASTA_HAS_ZLIB )
+/**
+ * FastaInputSource inflating a gzip or zlib compressed FastaInputSource. Concatenated
+ * gzip members, as produced by BGZF and by appending gzip files, are read as one stream.
+ */
+class FastaGzipSource : public FastaInputSource
+{
+private:
+	std::unique_ptr< FastaInputSource > mInputSource; // The compressed source.
+	std::vector< char > mInput;  // Compressed input buffer.
+	z_stream mStream;            // Inflate state.
+	bool mIsInsideMember;        // True while a gzip member has been started but not finished.
+	bool mIsEndOfInput;          // True once the compressed source is exhausted.
+	int mErrorCode;              // First error encountered.
+
+public:
+	/**
+	 * Constructor.
+	 * @param inputSource The compressed source to read from; ownership is taken.
+	 * @param bufferSize Size of the compressed input buffer in bytes. [default: 256KiB]
+	 */
+	explicit FastaGzipSource(
+		std::unique_ptr< FastaInputSource > inputSource,
+		size_t bufferSize = 1 << 18 )
+	{
+		mInputSource = std::move( inputSource );
+		mInput.resize( std::max( bufferSize, static_cast< size_t >( 1 ) ) );
+		mIsInsideMember = false;
+		mIsEndOfInput = false;
+		mErrorCode = 0;
+		std::memset( &mStream, 0, sizeof( mStream ) );
+
+		if ( Z_OK != inflateInit2( &mStream, 15 + 32 ) )
+		{
+			mErrorCode = ENOMEM;
+		}
+	}
+
+	FastaGzipSource(
+		const FastaGzipSource& other ) = delete;
+
+	FastaGzipSource& operator=(
+		const FastaGzipSource& other ) = delete;
+
+	~FastaGzipSource() override
+	{
+		inflateEnd( &mStream );
+	}
+
+	int read(
+		char* destination,
+		size_t capacity,
+		size_t& bytesRead ) override
+	{
+		mStream.next_out = reinterpret_cast< Bytef* >( destination );
+		mStream.avail_out = static_cast< uInt >( std::min( capacity, static_cast< size_t >( 1 ) << 30 ) );
+
+		while ( ( 0 == mErrorCode ) and ( 0 < mStream.avail_out ) )
+		{
+			if ( ( 0 == mStream.avail_in ) and not mIsEndOfInput )
+			{
+				size_t inputLength( 0 );
+
+				mErrorCode = mInputSource->read( mInput.data(), mInput.size(), inputLength );
+				mIsEndOfInput = ( 0 == inputLength );
+				mStream.next_in = reinterpret_cast< Bytef* >( mInput.data() );
+				mStream.avail_in = static_cast< uInt >( inputLength );
+			}
+
+			if ( 0 == mStream.avail_in )
+			{
+				// A member cut short is a truncated file.
+				mErrorCode = ( mIsInsideMember and ( 0 == mErrorCode ) ) ? EIO : mErrorCode;
+				break;
+			}
+
+			mIsInsideMember = true;
+
+			const int result = inflate( &mStream, Z_NO_FLUSH );
+
+			if ( Z_STREAM_END == result )
+			{
+				mIsInsideMember = false;
+				inflateReset( &mStream );
+			}
+			else if ( ( Z_OK != result ) and ( Z_BUF_ERROR != result ) )
+			{
+				mErrorCode = ( Z_MEM_ERROR == result ) ? ENOMEM : EIO;
+			}
+		}
+
+		bytesRead = reinterpret_cast< char* >( mStream.next_out ) - destination;
+
+		return mErrorCode;
+	}
+};
+
+/**
+ * FastaInputSource inflating a BGZF compressed FastaInputSource across worker threads.
+ * Blocks are read ahead on the calling thread, inflated in parallel by the workers and
+ * handed out in file order, so decompression overlaps with parsing of the output.
+ */
+class FastaBgzfSource : public FastaInputSource
+{
+private:
+	// A block in flight. Owned by the workers between being read and being inflated.
+	struct Block
+	{
+		std::string compressed;   // The raw BGZF block.
+		std::string inflated;     // The contents of the block.
+		int errorCode;            // Result of inflating the block.
+		bool isInflated;          // True once a worker has inflated the block.
+	};
+
+	std::unique_ptr< FastaInputSource > mInputSource; // The compressed source.
+	std::vector< char > mInput;  // Compressed input buffer.
+	size_t mInputBegin;          // Offset of the first unconsumed byte of the input buffer.
+	size_t mInputEnd;            // Offset one past the last valid byte of the input buffer.
+	bool mIsEndOfInput;          // True once no more blocks will be read.
+	int mErrorCode;              // First error encountered reading blocks.
+	std::vector< Block > mBlocks; // Ring of blocks in flight.
+	size_t mBlocksRead;          // Number of blocks read from the source.
+	size_t mBlocksClaimed;       // Number of blocks claimed by a worker.
+	size_t mBlocksConsumed;      // Number of blocks fully handed out.
+	size_t mInflatedOffset;      // Offset of the next byte to hand out of the current block.
+	bool mIsStopping;            // True once the workers should exit.
+	std::mutex mMutex;           // Guards the block counters and flags.
+	std::condition_variable mBlockAvailable; // Signalled when a block is read or on stop.
+	std::condition_variable mBlockInflated;  // Signalled when a block has been inflated.
+	std::vector< std::thread > mThreads;     // The workers.
+
+	// Make at least count bytes available in the input buffer, unless the source ends first.
+	bool _ensureInput(
+		size_t count )
+	{
+		while ( ( mInputEnd - mInputBegin < count ) and ( 0 == mErrorCode ) )
+		{
+			if ( 0 < mInputBegin )
+			{
+				std::memmove( mInput.data(), mInput.data() + mInputBegin, mInputEnd - mInputBegin );
+				mInputEnd -= mInputBegin;
+				mInputBegin = 0;
+			}
+
+			size_t inputLength( 0 );
+
+			mErrorCode = mInputSource->read( mInput.data() + mInputEnd, mInput.size() - mInputEnd, inputLength );
+			mInputEnd += inputLength;
+
+			if ( 0 == inputLength )
+			{
+				break;
+			}
+		}
+
+		return mInputEnd - mInputBegin >= count;
+	}
+
+	// Read the next block from the source. Returns false at the end of input or on error.
+	bool _readBlock(
+		Block& block )
+	{
+		if ( not _ensureInput( 12 ) )
+		{
+			mErrorCode = ( ( 0 == mErrorCode ) and ( mInputBegin < mInputEnd ) ) ? EIO : mErrorCode;
+			return false;
+		}
+
+		const size_t headerLength = 12 + FastaCompression::readLittleEndian( mInput.data() + mInputBegin + 10, 2 );
+		const size_t blockSize = _ensureInput( headerLength ) ?
+			FastaCompression::bgzfBlockSize( mInput.data() + mInputBegin, mInputEnd - mInputBegin ) : 0;
+
+		if ( ( 0 == blockSize ) or not _ensureInput( blockSize ) )
+		{
+			mErrorCode = ( 0 == mErrorCode ) ? EIO : mErrorCode;
+			return false;
+		}
+
+		block.compressed.assign( mInput.data() + mInputBegin, blockSize );
+		mInputBegin += blockSize;
+
+		return true;
+	}
+
+	// Read ahead until every block of the ring is in flight.
+	void _readAhead()
+	{
+		while ( not mIsEndOfInput and ( mBlocksRead - mBlocksConsumed < mBlocks.size() ) )
+		{
+			Block& block = mBlocks[ mBlocksRead % mBlocks.size() ];
+
+			if ( not _readBlock( block ) )
+			{
+				mIsEndOfInput = true;
+				break;
+			}
+
+			std::lock_guard< std::mutex > lock( mMutex );
+			block.isInflated = false;
+			++mBlocksRead;
+			mBlockAvailable.notify_one();
+		}
+	}
+
+	void _work()
+	{
+		std::unique_lock< std::mutex > lock( mMutex );
+
+		while ( true )
+		{
+			mBlockAvailable.wait( lock,
+				[ this ]()
+				{
+					return mIsStopping or ( mBlocksClaimed < mBlocksRead );
+				} );
+
+			if ( mIsStopping )
+			{
+				return;
+			}
+
+			Block& block = mBlocks[ mBlocksClaimed++ % mBlocks.size() ];
+			int errorCode;
+
+			lock.unlock();
+
+			try
+			{
+				errorCode = FastaCompression::inflateBgzfBlock( block.compressed.data(), block.compressed.size(), block.inflated );
+			}
+			catch ( const std::bad_alloc& )
+			{
+				errorCode = ENOMEM;
+			}
+
+			lock.lock();
+			block.errorCode = errorCode;
+			block.isInflated = true;
+			mBlockInflated.notify_all();
+		}
+	}
+
+public:
+	/**
+	 * Constructor. Starts the worker threads.
+	 * @param inputSource The compressed source to read from; ownership is taken.
+	 * @param threadCount The number of worker threads; zero selects one per hardware thread. [default: 0]
+	 */
+	explicit FastaBgzfSource(
+		std::unique_ptr< FastaInputSource > inputSource,
+		size_t threadCount = 0 )
+	{
+		if ( 0 == threadCount )
+		{
+			threadCount = std::max( std::thread::hardware_concurrency(), 1u );
+		}
+
+		mInputSource = std::move( inputSource );
+		mInput.resize( 1 << 18 );
+		mInputBegin = 0;
+		mInputEnd = 0;
+		mIsEndOfInput = false;
+		mErrorCode = 0;
+		mBlocks.resize( threadCount * 4 );
+		mBlocksRead = 0;
+		mBlocksClaimed = 0;
+		mBlocksConsumed = 0;
+		mInflatedOffset = 0;
+		mIsStopping = false;
+
+		for ( size_t thread( 0 ); thread < threadCount; ++thread )
+		{
+			mThreads.emplace_back( &FastaBgzfSource::_work, this );
+		}
+	}
+
+	FastaBgzfSource(
+		const FastaBgzfSource& other ) = delete;
+
+	FastaBgzfSource& operator=(
+		const FastaBgzfSource& other ) = delete;
+
+	/**
+	 * Destructor. Stops the worker threads.
+	 */
+	~FastaBgzfSource() override
+	{
+		{
+			std::lock_guard< std::mutex > lock( mMutex );
+			mIsStopping = true;
+			mBlockAvailable.notify_all();
+		}
+
+		for ( auto& thread : mThreads )
+		{
+			thread.join();
+		}
+	}
+
+	int read(
+		char* destination,
+		size_t capacity,
+		size_t& bytesRead ) override
+	{
+		bytesRead = 0;
+
+		while ( bytesRead < capacity )
+		{
+			_readAhead();
+
+			if ( mBlocksConsumed == mBlocksRead )
+			{
+				return mErrorCode;
+			}
+
+			Block& block = mBlocks[ mBlocksConsumed % mBlocks.size() ];
+
+			{
+				std::unique_lock< std::mutex > lock( mMutex );
+				mBlockInflated.wait( lock,
+					[ &block ]()
+					{
+						return block.isInflated;
+					} );
+			}
+
+			if ( 0 != block.errorCode )
+			{
+				mErrorCode = block.errorCode;
+				mIsEndOfInput = true;
+				mBlocksConsumed = mBlocksRead;
+				return mErrorCode;
+			}
+
+			const size_t count = std::min( capacity - bytesRead, block.inflated.length() - mInflatedOffset );
+
+			std::memcpy( destination + bytesRead, block.inflated.data() + mInflatedOffset, count );
+			bytesRead += count;
+			mInflatedOffset += count;
+
+			if ( mInflatedOffset == block.inflated.length() )
+			{
+				mInflatedOffset = 0;
+				++mBlocksConsumed;
+			}
+		}
+
+		return 0;
+	}
+};
+#endif
+
+/**
+ * FastaInputSource reading another source ahead on a dedicated I/O thread, so that reading
+ * the next buffers overlaps with parsing the current one. The thread fills a ring of large
+ * page aligned buffers, double buffered by default, and blocks once every buffer is full
+ * until the reader hands one back. Data read before an error is delivered ahead of the error.
+ */
+class FastaReadAheadSource : public FastaInputSource
+{
+private:
+	// A buffer of the ring. Owned by the I/O thread until it is full, then by the reader.
+	struct Buffer
+	{
+		std::vector< char > storage; // Backing store, over-allocated so that data is page aligned.
+		char* data;                  // First byte of the buffer.
+		size_t length;               // Number of bytes read into the buffer.
+		int errorCode;               // Error reported by the source after the bytes read.
+	};
+
+	std::unique_ptr< FastaInputSource > mInputSource; // The source read ahead.
+	std::vector< Buffer > mBuffers; // Ring of buffers.
+	size_t mBufferSize;             // Capacity of each buffer.
+	size_t mBuffersFilled;          // Number of buffers filled by the I/O thread.
+	size_t mBuffersConsumed;        // Number of buffers fully handed out.
+	size_t mConsumedOffset;         // Offset of the next byte to hand out of the current buffer.
+	bool mIsEndOfInput;             // True once the I/O thread has filled its last buffer.
+	bool mIsStopping;               // True once the I/O thread should exit.
+	std::mutex mMutex;              // Guards the buffer counters and flags.
+	std::condition_variable mBufferFilled;   // Signalled when a buffer is filled.
+	std::condition_variable mBufferReleased; // Signalled when a buffer is handed back, or on stop.
+	std::thread mThread;            // The I/O thread.
+
+	void _work()
+	{
+		std::unique_lock< std::mutex > lock( mMutex );
+
+		while ( not mIsEndOfInput )
+		{
+			mBufferReleased.wait( lock,
+				[ this ]()
+				{
+					return mIsStopping or ( mBuffersFilled - mBuffersConsumed < mBuffers.size() );
+				} );
+
+			if ( mIsStopping )
+			{
+				return;
+			}
+
+			Buffer& buffer = mBuffers[ mBuffersFilled % mBuffers.size() ];
+			bool isEndOfInput = false;
+
+			lock.unlock();
+
+			// Fill the whole buffer, so that the reader is handed large spans.
+			buffer.length = 0;
+			buffer.errorCode = 0;
+
+			while ( ( buffer.length < mBufferSize ) and not isEndOfInput )
+			{
+				size_t bytesRead( 0 );
+
+				buffer.errorCode = mInputSource->read( buffer.data + buffer.length, mBufferSize - buffer.length, bytesRead );
+				buffer.length += bytesRead;
+				isEndOfInput = ( 0 != buffer.errorCode ) or ( 0 == bytesRead );
+			}
+
+			lock.lock();
+			mIsEndOfInput = isEndOfInput;
+			++mBuffersFilled;
+			mBufferFilled.notify_one();
+		}
+	}
+
+public:
+	/**
+	 * Constructor. Starts the I/O thread.
+	 * @param inputSource The source to read ahead; ownership is taken.
+	 * @param bufferSize Size of each buffer in bytes. [default: 4MiB]
+	 * @param bufferCount The number of buffers, at least two. [default: 2]
+	 */
+	explicit FastaReadAheadSource(
+		std::unique_ptr< FastaInputSource > inputSource,
+		size_t bufferSize = 1 << 22,
+		size_t bufferCount = 2 )
+	{
+		const size_t pageSize = 4096;
+
+		mInputSource = std::move( inputSource );
+		mBuffers.resize( std::max( bufferCount, static_cast< size_t >( 2 ) ) );
+		mBufferSize = std::max( bufferSize, pageSize );
+		mBuffersFilled = 0;
+		mBuffersConsumed = 0;
+		mConsumedOffset = 0;
+		mIsEndOfInput = false;
+		mIsStopping = false;
+
+		for ( auto& buffer : mBuffers )
+		{
+			buffer.storage.resize( mBufferSize + pageSize - 1 );
+			buffer.data = buffer.storage.data() + ( pageSize - reinterpret_cast< uintptr_t >( buffer.storage.data() ) % pageSize ) % pageSize;
+			buffer.length = 0;
+			buffer.errorCode = 0;
+		}
+
+		mThread = std::thread( &FastaReadAheadSource::_work, this );
+	}
+
+	FastaReadAheadSource(
+		const FastaReadAheadSource& other ) = delete;
+
+	FastaReadAheadSource& operator=(
+		const FastaReadAheadSource& other ) = delete;
+
+	/**
+	 * Destructor. Stops the I/O thread, after the read in progress if any.
+	 */
+	~FastaReadAheadSource() override
+	{
+		{
+			std::lock_guard< std::mutex > lock( mMutex );
+			mIsStopping = true;
+			mBufferReleased.notify_all();
+		}
+
+		mThread.join();
+	}
+
+	/**
+	 * Hand out the bytes read ahead, waiting for the I/O thread only if none are ready.
+	 */
+	int read(
+		char* destination,
+		size_t capacity,
+		size_t& bytesRead ) override
+	{
+		std::unique_lock< std::mutex > lock( mMutex );
+
+		bytesRead = 0;
+
+		while ( bytesRead < capacity )
+		{
+			if ( mBuffersConsumed == mBuffersFilled )
+			{
+				if ( ( 0 < bytesRead ) or mIsEndOfInput )
+				{
+					break;
+				}
+
+				mBufferFilled.wait( lock,
+					[ this ]()
+					{
+						return mBuffersConsumed < mBuffersFilled;
+					} );
+			}
+
+			Buffer& buffer = mBuffers[ mBuffersConsumed % mBuffers.size() ];
+			const size_t count = std::min( capacity - bytesRead, buffer.length - mConsumedOffset );
+
+			lock.unlock();
+			std::memcpy( destination + bytesRead, buffer.data + mConsumedOffset, count );
+			lock.lock();
+
+			bytesRead += count;
+			mConsumedOffset += count;
+
+			if ( mConsumedOffset < buffer.length )
+			{
+				break;
+			}
+
+			// The last buffer, holding the end of input or an error, is kept to be reported again.
+			if ( 0 != buffer.errorCode )
+			{
+				return ( 0 < bytesRead ) ? 0 : buffer.errorCode;
+			}
+
+			if ( mIsEndOfInput and ( mBuffersConsumed + 1 == mBuffersFilled ) )
+			{
+				break;
+			}
+
+			mConsumedOffset = 0;
+			++mBuffersConsumed;
+			mBufferReleased.notify_one();
+		}
+
+		return 0;
+	}
+};
+
+/**
+ * This class reads FastA records one at a time from a FastaInputSource, using constant memory
+ * regardless of the size of the input. Lines before the first header are skipped. Reading into
+ * the same FastaSequence repeatedly reuses its identifier and sequence buffers, so steady state
+ * parsing does not allocate.
+ */
+class FastaReader
+{
+private:
+	std::unique_ptr< FastaInputSource > mInputSource; // Where the bytes come from.
+	std::vector< char > mBuffer; // Read buffer.
+	size_t mBufferBegin;         // Offset of the first unconsumed byte of the buffer.
+	size_t mBufferEnd;           // Offset one past the last valid byte of the buffer.
+	bool mIsAtLineStart;         // True if the first unconsumed byte starts a line.
+	bool mIsEndOfInput;          // True once the source is exhausted.
+	int mErrorCode;              // First error reported by the source.
+	FastaSequence::Normalization mNormalization; // How the sequences read are normalized.
+	FastaAlphabet::Type mAlphabet; // Alphabet the sequences read are normalized to.
+	FastaStatistics* mStatistics; // Statistics to gather, or nullptr.
+
+	// Refill the buffer once it has been consumed. Returns false at the end of input or on error.
+	bool _fill()
+	{
+		if ( mBufferBegin < mBufferEnd )
+		{
+			return true;
+		}
+
+		mBufferBegin = 0;
+		mBufferEnd = 0;
+
+		if ( mIsEndOfInput or not mInputSource )
+		{
+			return false;
+		}
+
+		size_t bytesRead( 0 );
+		const double readStart = ( nullptr == mStatistics ) ? 0 : FastaStatistics::now();
+
+		mErrorCode = mInputSource->read( mBuffer.data(), mBuffer.size(), bytesRead );
+		mBufferEnd = bytesRead;
+		mIsEndOfInput = ( 0 != mErrorCode ) or ( 0 == bytesRead );
+
+		if ( nullptr != mStatistics )
+		{
+			mStatistics->ioSeconds += FastaStatistics::now() - readStart;
+			mStatistics->bytes += bytesRead;
+			mStatistics->_progress();
+		}
+
+		return 0 < bytesRead;
+	}
+
+	// Pointer to the next newline in the buffer, or nullptr.
+	const char* _findNewline(
+		size_t offset ) const
+	{
+		return static_cast< const char* >(
+			std::memchr( mBuffer.data() + offset, '\n', mBufferEnd - offset ) );
+	}
+
+public:
+	/**
+	 * Class for iterating over the records of a FastaReader in a single pass.
+	 */
+	class iterator
+	{
+	private:
+		friend class FastaReader;
+
+		FastaReader* mReader;    // Reader being iterated, or nullptr at the end.
+		FastaSequence mSequence; // The current record.
+
+		iterator(
+			FastaReader* reader )
+		{
+			mReader = reader;
+			this->operator++();
+		}
+
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using difference_type   = std::ptrdiff_t;
+		using value_type        = FastaSequence;
+		using pointer           = FastaSequence*;
+		using reference         = FastaSequence&;
+
+		/**
+		 * Default constructor to the end iterator.
+		 */
+		iterator()
+		{
+			mReader = nullptr;
+		}
+
+		/**
+		 * Compare iterators for equality.
+		 * @param other Const reference to the iterator to compare against for equality.
+		 * @return True is returned if both iterators refer to the same reader, or both are at the end.
+		 */
+		bool operator==(
+			const iterator& other ) const
+		{
+			return mReader == other.mReader;
+		}
+
+		/**
+		 * Compare iterators for inequality.
+		 * @param other Const reference to the iterator to compare against for inequality.
+		 * @return True is returned if this and other are not equal.
+		 */
+		bool operator!=(
+			const iterator& other ) const
+		{
+			return not this->operator==( other );
+		}
+
+		/**
+		 * Pointer access to the current record.
+		 * @return A pointer to the current FastaSequence.
+		 */
+		pointer operator->()
+		{
+			return &mSequence;
+		}
+
+		/**
+		 * Reference access to the current record. The record may be moved from.
+		 * @return A reference to the current FastaSequence.
+		 */
+		reference operator*()
+		{
+			return mSequence;
+		}
+
+		/**
+		 * Pre-increment operator. Reads the next record into the buffers of the current one.
+		 * @return Reference to this iterator instance is returned.
+		 */
+		iterator& operator++()
+		{
+			if ( ( nullptr != mReader ) and not mReader->read( mSequence ) )
+			{
+				mReader = nullptr;
+			}
+
+			return *this;
+		}
+	};
+
+	/**
+	 * Constructor.
+	 * @param inputSource The source to read from; ownership is taken. [default: nullptr]
+	 * @param bufferSize Size of the read buffer in bytes. [default: 1MiB]
+	 */
+	explicit FastaReader(
+		std::unique_ptr< FastaInputSource > inputSource = nullptr,
+		size_t bufferSize = 1 << 20 )
+	{
+		mInputSource = std::move( inputSource );
+		mBuffer.resize( std::max( bufferSize, static_cast< size_t >( 1 ) ) );
+		mBufferBegin = 0;
+		mBufferEnd = 0;
+		mIsAtLineStart = true;
+		mIsEndOfInput = false;
+		mErrorCode = 0;
+		mNormalization = FastaSequence::Normalization::Eager;
+		mAlphabet = FastaAlphabet::Type::Any;
+		mStatistics = nullptr;
+	}
+
+	/**
+	 * Constructor reading from a std::istream.
+	 * @param inputStream Reference to the stream to read from. It must outlive this instance.
+	 * @param bufferSize Size of the read buffer in bytes. [default: 1MiB]
+	 */
+	explicit FastaReader(
+		std::istream& inputStream,
+		size_t bufferSize = 1 << 20 ) :
+		FastaReader( std::unique_ptr< FastaInputSource >( new FastaStreamSource( inputStream ) ), bufferSize )
+	{
+	}
+
+#if defined( FASTA_HAS_POSIX )
+	/**
+	 * Constructor reading from a file descriptor. The descriptor is not closed by the reader.
+	 * @param fileDescriptor The descriptor to read from.
+	 * @param bufferSize Size of the read buffer in bytes. [default: 1MiB]
+	 */
+	explicit FastaReader(
+		int fileDescriptor,
+		size_t bufferSize = 1 << 20 ) :
+		FastaReader( std::unique_ptr< FastaInputSource >( new FastaFileDescriptorSource( fileDescriptor ) ), bufferSize )
+	{
+	}
+#endif
+
+	/**
+	 * Get an iterator to the next record of the input.
+	 * @return An iterator to the next record is returned.
+	 */
+	iterator begin()
+	{
+		return iterator( this );
+	}
+
+	/**
+	 * Get an iterator to the end of the input.
+	 * @return An iterator to the end of the input is returned.
+	 */
+	iterator end()
+	{
+		return iterator();
+	}
+
+	/**
+	 * Detect the alphabet of the input from the bytes buffered but not yet read, filling the
+	 * buffer first if it is empty; see FastaAlphabet::detect. No record is consumed. Compressed
+	 * input is detected from its inflated bytes.
+	 * @return The alphabet detected is returned.
+	 */
+	FastaAlphabet::Type detectAlphabet()
+	{
+		_fill();
+
+		return FastaAlphabet::detect( mBuffer.data() + mBufferBegin,
+			std::min( mBufferEnd - mBufferBegin, static_cast< size_t >( FastaAlphabet::DetectionLength ) ) );
+	}
+
+	/**
+	 * Get the first error reported while reading.
+	 * @return Zero is returned if no error has occurred, else an errno value is returned.
+	 */
+	int error() const
+	{
+		return mErrorCode;
+	}
+
+	/**
+	 * Open a file to read from, replacing the current source. Gzip and BGZF compressed
+	 * files are detected from their contents and inflated as they are read.
+	 * @param filename The name of the file to read.
+	 * @param threadCount The number of threads inflating BGZF blocks; zero selects one per hardware thread. [default: 1]
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         ENOTSUP is returned for compressed files if zlib support is not enabled.
+	 */
+	int open(
+		const std::string& filename,
+		size_t threadCount = 1 )
+	{
+		const FastaCompression::Format format = FastaCompression::detectFile( filename );
+		std::unique_ptr< FastaInputSource > inputSource;
+
+#if !defined( FASTA_HAS_ZLIB )
+		static_cast< void >( threadCount );
+
+		if ( FastaCompression::Format::None != format )
+		{
+			return ENOTSUP;
+		}
+#endif
+
+#if defined( FASTA_HAS_POSIX )
+		int fileDescriptor = ::open( filename.c_str(), O_RDONLY );
+
+		if ( -1 == fileDescriptor )
+		{
+			return errno;
+		}
+
+		inputSource.reset( new FastaFileDescriptorSource( fileDescriptor, true ) );
+#else
+		struct FileSource : public FastaInputSource
+		{
+			std::ifstream inputFile;
+			FastaStreamSource streamSource{ inputFile };
+
+			int read(
+				char* destination,
+				size_t capacity,
+				size_t& bytesRead ) override
+			{
+				return streamSource.read( destination, capacity, bytesRead );
+			}
+		};
+
+		std::unique_ptr< FileSource > fileSource( new FileSource );
+		fileSource->inputFile.open( filename, std::ios::in | std::ios::binary );
+
+		if ( not fileSource->inputFile )
+		{
+			return ENOENT;
+		}
+
+		inputSource = std::move( fileSource );
+#endif
+
+#if defined( FASTA_HAS_ZLIB )
+		if ( FastaCompression::Format::Bgzf == format )
+		{
+			inputSource.reset( new FastaBgzfSource( std::move( inputSource ), threadCount ) );
+		}
+		else if ( FastaCompression::Format::Gzip == format )
+		{
+			inputSource.reset( new FastaGzipSource( std::move( inputSource ) ) );
+		}
+#endif
+
+		this->reset( std::move( inputSource ) );
+
+		return 0;
+	}
+
+	/**
+	 * Read the next record. The identifier and sequence buffers of the given
+	 * sequence are reused, and the sequence is normalized as in FastaSequence.
+	 * @param sequence Reference to the FastaSequence to read the record into.
+	 * @return True is returned if a record was read; false at the end of input or on error.
+	 */
+	bool read(
+		FastaSequence& sequence )
+	{
+		// Skip to the next header.
+		while ( true )
+		{
+			if ( not _fill() )
+			{
+				return false;
+			}
+
+			if ( mIsAtLineStart and ( '>' == mBuffer[ mBufferBegin ] ) )
+			{
+				break;
+			}
+
+			const char* newline = _findNewline( mBufferBegin );
+			mIsAtLineStart = ( nullptr != newline );
+			mBufferBegin = ( nullptr == newline ) ? mBufferEnd : newline + 1 - mBuffer.data();
+		}
+
+		// Read the header line.
+		sequence.mIdentifier.clear();
+
+		while ( _fill() )
+		{
+			const char* newline = _findNewline( mBufferBegin );
+			const size_t lineEnd = ( nullptr == newline ) ? mBufferEnd : newline - mBuffer.data();
+
+			sequence.mIdentifier.append( mBuffer.data() + mBufferBegin, lineEnd - mBufferBegin );
+			mIsAtLineStart = ( nullptr != newline );
+			mBufferBegin = ( nullptr == newline ) ? mBufferEnd : lineEnd + 1;
+
+			if ( mIsAtLineStart )
+			{
+				break;
+			}
+		}
+
+		// Read the sequence lines up to the next header, appending whole
+		// spans of the buffer and normalizing the sequence once at the end.
+		sequence._releaseExternal();
+		sequence.mSequence.clear();
+
+		while ( _fill() and not ( mIsAtLineStart and ( '>' == mBuffer[ mBufferBegin ] ) ) )
+		{
+			size_t spanEnd = mBufferEnd;
+			bool isAtHeader = false;
+
+			for ( const char* newline = _findNewline( mBufferBegin ); nullptr != newline; )
+			{
+				const size_t nextLine = newline + 1 - mBuffer.data();
+
+				if ( ( nextLine < mBufferEnd ) and ( '>' == mBuffer[ nextLine ] ) )
+				{
+					spanEnd = nextLine;
+					isAtHeader = true;
+					break;
+				}
+
+				newline = ( nextLine < mBufferEnd ) ? _findNewline( nextLine ) : nullptr;
+			}
+
+			sequence.mSequence.append( mBuffer.data() + mBufferBegin, spanEnd - mBufferBegin );
+			mIsAtLineStart = isAtHeader or ( '\n' == mBuffer[ spanEnd - 1 ] );
+			mBufferBegin = spanEnd;
+		}
+
+		const double normalizeStart = ( nullptr == mStatistics ) ? 0 : FastaStatistics::now();
+		const size_t rawLength = sequence.mSequence.length();
+
+		sequence.mAlphabet = mAlphabet;
+		sequence._normalizeIdentifier();
+		sequence._normalizeSequence( mNormalization );
+
+		if ( nullptr != mStatistics )
+		{
+			mStatistics->_gatherComposition( sequence._identifierView(), sequence.mSequence.data(), sequence.mSequence.length() );
+			mStatistics->normalizeSeconds += FastaStatistics::now() - normalizeStart;
+			mStatistics->charactersRemoved += rawLength - sequence.mSequence.length();
+			++mStatistics->records;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Replace the source being read from, discarding any buffered input.
+	 * @param inputSource The source to read from; ownership is taken.
+	 */
+	void reset(
+		std::unique_ptr< FastaInputSource > inputSource )
+	{
+		mInputSource = std::move( inputSource );
+		mBufferBegin = 0;
+		mBufferEnd = 0;
+		mIsAtLineStart = true;
+		mIsEndOfInput = false;
+		mErrorCode = 0;
+	}
+
+	/**
+	 * Set the alphabet the sequences read from now on are normalized to.
+	 * @param alphabet The alphabet of the sequences. [default: Any]
+	 */
+	void setAlphabet(
+		FastaAlphabet::Type alphabet )
+	{
+		mAlphabet = alphabet;
+	}
+
+	/**
+	 * Set how the sequences read from now on are normalized. Identifiers are always normalized.
+	 * Lazily normalized characters are not counted by the statistics as removed.
+	 * @param normalization How the sequences are normalized. [default: Eager]
+	 */
+	void setNormalization(
+		FastaSequence::Normalization normalization )
+	{
+		mNormalization = normalization;
+	}
+
+	/**
+	 * Gather statistics of the records read from now on, and report progress through them.
+	 * @param statistics Pointer to the statistics to add to, which must outlive the reader, or nullptr to stop gathering.
+	 */
+	void setStatistics(
+		FastaStatistics* statistics )
+	{
+		mStatistics = statistics;
+	}
+
+	/**
+	 * Read the current source ahead on a dedicated I/O thread from now on; see FastaReadAheadSource.
+	 * Compressed sources are inflated on that thread too. Calling this without a source does nothing.
+	 * @param bufferSize Size of each read ahead buffer in bytes. [default: 4MiB]
+	 * @param bufferCount The number of read ahead buffers, at least two. [default: 2]
+	 */
+	void useReadAhead(
+		size_t bufferSize = 1 << 22,
+		size_t bufferCount = 2 )
+	{
+		if ( mInputSource )
+		{
+			mInputSource.reset( new FastaReadAheadSource( std::move( mInputSource ), bufferSize, bufferCount ) );
+		}
+	}
+};
+
+/**
+ * Interface to a sequential destination of bytes for FastaWriter.
+ */
+class FastaOutputSink
+{
+public:
+	virtual ~FastaOutputSink() = default;
+
+	/**
+	 * Get the alignment required of the address and length of every write but the last.
+	 * @return The alignment in bytes is returned; one if there is no requirement.
+	 */
+	virtual size_t alignment() const
+	{
+		return 1;
+	}
+
+	/**
+	 * Release the destination once every byte is written, such as by closing the file.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	virtual int close()
+	{
+		return 0;
+	}
+
+	/**
+	 * Write all of the given bytes to the sink.
+	 * @param data Pointer to the bytes to write.
+	 * @param length The number of bytes to write.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	virtual int write(
+		const char* data,
+		size_t length ) = 0;
+};
+
+/**
+ * FastaOutputSink writing to a std::ostream.
+ */
+class FastaStreamSink : public FastaOutputSink
+{
+private:
+	std::ostream& mOutputStream; // The stream to write to.
+
+public:
+	/**
+	 * Constructor.
+	 * @param outputStream Reference to the stream to write to. It must outlive this instance.
+	 */
+	explicit FastaStreamSink(
+		std::ostream& outputStream ) :
+		mOutputStream( outputStream )
+	{
+	}
+
+	int write(
+		const char* data,
+		size_t length ) override
+	{
+		mOutputStream.write( data, length );
+
+		return mOutputStream ? 0 : EIO;
+	}
+};
+
+#if defined( FASTA_HAS_POSIX )
+/**
+ * FastaOutputSink writing to a file descriptor. If the descriptor was opened with O_DIRECT,
+ * then writes must be aligned to mAlignment; O_DIRECT is dropped for a final unaligned write.
+ */
+class FastaFileDescriptorSink : public FastaOutputSink
+{
+private:
+	int mFileDescriptor;   // The descriptor to write to.
+	bool mOwnsDescriptor;  // Flag to close the descriptor on destruction.
+	size_t mAlignment;     // Alignment required by O_DIRECT, or one.
+
+public:
+	/**
+	 * Constructor.
+	 * @param fileDescriptor The descriptor to write to.
+	 * @param ownsDescriptor Flag to close the descriptor when this instance is destroyed. [default: false]
+	 * @param alignment Alignment required of writes, e.g. 4096 for O_DIRECT. [default: 1]
+	 */
+	explicit FastaFileDescriptorSink(
+		int fileDescriptor,
+		bool ownsDescriptor = false,
+		size_t alignment = 1 )
+	{
+		mFileDescriptor = fileDescriptor;
+		mOwnsDescriptor = ownsDescriptor;
+		mAlignment = std::max( alignment, static_cast< size_t >( 1 ) );
+	}
+
+	FastaFileDescriptorSink(
+		const FastaFileDescriptorSink& other ) = delete;
+
+	FastaFileDescriptorSink& operator=(
+		const FastaFileDescriptorSink& other ) = delete;
+
+	~FastaFileDescriptorSink() override
+	{
+		this->close();
+	}
+
+	size_t alignment() const override
+	{
+		return mAlignment;
+	}
+
+	int close() override
+	{
+		if ( mOwnsDescriptor and ( -1 != mFileDescriptor ) )
+		{
+			const int result = ::close( mFileDescriptor );
+
+			mFileDescriptor = -1;
+
+			if ( -1 == result )
+			{
+				return errno;
+			}
+		}
+
+		return 0;
+	}
+
+	int write(
+		const char* data,
+		size_t length ) override
+	{
+#if defined( O_DIRECT )
+		if ( ( 1 < mAlignment ) and ( 0 != ( length % mAlignment ) ) )
+		{
+			::fcntl( mFileDescriptor, F_SETFL, ::fcntl( mFileDescriptor, F_GETFL ) & ~O_DIRECT );
+			mAlignment = 1;
+		}
+#endif
+
+		while ( 0 < length )
+		{
+			const ssize_t result = ::write( mFileDescriptor, data, length );
+
+			if ( 0 > result )
+			{
+				if ( EINTR == errno )
+				{
+					continue;
+				}
+
+				return errno;
+			}
+
+			data += result;
+			length -= result;
+		}
+
+		return 0;
+	}
+};
+#endif
+
+/**
+ * This class writes FastA records through a large output buffer. Sequence lines are wrapped
+ * straight from the sequence storage into the buffer, so no per-line strings are created,
+ * and the buffer is only handed to the sink once full.
+ */
+class FastaWriter
+{
+private:
+	std::unique_ptr< FastaOutputSink > mOutputSink; // Where the bytes go.
+	std::unique_ptr< char[] > mStorage;             // Allocation holding the buffer.
+	char* mBuffer;           // Output buffer, aligned as the sink requires.
+	size_t mBufferSize;      // Capacity of the buffer.
+	size_t mBufferUsed;      // Number of bytes in the buffer.
+	size_t mLineLength;      // Sequence characters per line.
+	size_t mOffset;          // Number of bytes written, including those still buffered.
+	int mErrorCode;          // First error reported by the sink.
+	FastaStatistics* mStatistics; // Statistics to gather, or nullptr.
+
+	// (Re)allocate the buffer for the alignment of the current sink.
+	void _allocateBuffer(
+		size_t bufferSize )
+	{
+		const size_t alignment = mOutputSink ? mOutputSink->alignment() : 1;
+
+		mBufferSize = std::max( ( bufferSize / alignment ) * alignment, alignment );
+		mStorage.reset( new char[ mBufferSize + alignment ] );
+		mBuffer = mStorage.get();
+
+		if ( 1 < alignment )
+		{
+			const uintptr_t address = reinterpret_cast< uintptr_t >( mBuffer );
+			mBuffer += ( alignment - address % alignment ) % alignment;
+		}
+
+		mBufferUsed = 0;
+	}
+
+	// Hand the buffer to the sink. Unless final, only whole multiples of the alignment
+	// are written and the remainder is kept at the front of the buffer.
+	void _flushBuffer(
+		bool isFinal )
+	{
+		if ( not mOutputSink )
+		{
+			mErrorCode = ( 0 == mErrorCode ) ? EBADF : mErrorCode;
+			mBufferUsed = 0;
+			return;
+		}
+
+		const size_t alignment = mOutputSink->alignment();
+		const size_t length = isFinal ? mBufferUsed : ( mBufferUsed / alignment ) * alignment;
+
+		if ( ( 0 < length ) and ( 0 == mErrorCode ) )
+		{
+			const double writeStart = ( nullptr == mStatistics ) ? 0 : FastaStatistics::now();
+
+			mErrorCode = mOutputSink->write( mBuffer, length );
+
+			if ( nullptr != mStatistics )
+			{
+				mStatistics->ioSeconds += FastaStatistics::now() - writeStart;
+				mStatistics->bytes += length;
+				mStatistics->_progress();
+			}
+		}
+
+		std::memmove( mBuffer, mBuffer + length, mBufferUsed - length );
+		mBufferUsed -= length;
+	}
+
+	void _put(
+		char character )
+	{
+		if ( mBufferUsed == mBufferSize )
+		{
+			_flushBuffer( false );
+		}
+
+		mBuffer[ mBufferUsed++ ] = character;
+		++mOffset;
+	}
+
+	void _put(
+		const char* data,
+		size_t length )
+	{
+		while ( 0 < length )
+		{
+			if ( mBufferUsed == mBufferSize )
+			{
+				_flushBuffer( false );
+			}
+
+			const size_t count = std::min( length, mBufferSize - mBufferUsed );
+			std::memcpy( mBuffer + mBufferUsed, data, count );
+			mBufferUsed += count;
+			mOffset += count;
+			data += count;
+			length -= count;
+		}
+	}
+
+	// Copy count characters of the sequence starting at position into the buffer.
+	void _put(
+		const FastaSequence& sequence,
+		size_t position,
+		size_t count )
+	{
+		while ( 0 < count )
+		{
+			if ( mBufferUsed == mBufferSize )
+			{
+				_flushBuffer( false );
+			}
+
+			const size_t copied = sequence.copy( mBuffer + mBufferUsed, std::min( count, mBufferSize - mBufferUsed ), position );
+			mBufferUsed += copied;
+			mOffset += copied;
+			position += copied;
+			count -= copied;
+		}
+	}
+
+public:
+	/**
+	 * Constructor.
+	 * @param outputSink The sink to write to; ownership is taken. [default: nullptr]
+	 * @param lineLength Length of each sequence line. If {@param lineLength} is zero, then
+	 *                   each sequence will be on a single line. [default: 80]
+	 * @param bufferSize Size of the output buffer in bytes. [default: 4MiB]
+	 */
+	explicit FastaWriter(
+		std::unique_ptr< FastaOutputSink > outputSink = nullptr,
+		size_t lineLength = 80,
+		size_t bufferSize = 4 << 20 )
+	{
+		mOutputSink = std::move( outputSink );
+		mBuffer = nullptr;
+		mLineLength = ( 0 == lineLength ) ? static_cast< size_t >( -1 ) : lineLength;
+		mOffset = 0;
+		mErrorCode = 0;
+		mStatistics = nullptr;
+		_allocateBuffer( bufferSize );
+	}
+
+	/**
+	 * Constructor writing to a std::ostream.
+	 * @param outputStream Reference to the stream to write to. It must outlive this instance.
+	 * @param lineLength Length of each sequence line, or zero for single line sequences. [default: 80]
+	 * @param bufferSize Size of the output buffer in bytes. [default: 4MiB]
+	 */
+	explicit FastaWriter(
+		std::ostream& outputStream,
+		size_t lineLength = 80,
+		size_t bufferSize = 4 << 20 ) :
+		FastaWriter( std::unique_ptr< FastaOutputSink >( new FastaStreamSink( outputStream ) ), lineLength, bufferSize )
+	{
+	}
+
+	FastaWriter(
+		const FastaWriter& other ) = delete;
+
+	FastaWriter& operator=(
+		const FastaWriter& other ) = delete;
+
+	/**
+	 * Destructor. Flushes any buffered output.
+	 */
+	~FastaWriter()
+	{
+		this->close();
+	}
+
+	/**
+	 * Flush any buffered output and release the sink, closing the file if the writer opened it.
+	 * @return Zero is returned upon success, else the first errno value reported is returned.
+	 */
+	int close()
+	{
+		if ( mOutputSink )
+		{
+			_flushBuffer( true );
+
+			const int errorCode = mOutputSink->close();
+
+			mErrorCode = ( 0 == mErrorCode ) ? errorCode : mErrorCode;
+			mOutputSink.reset();
+		}
+
+		return mErrorCode;
+	}
+
+	/**
+	 * Get the first error reported while writing.
+	 * @return Zero is returned if no error has occurred, else an errno value is returned.
+	 */
+	int error() const
+	{
+		return mErrorCode;
+	}
+
+	/**
+	 * Write out everything buffered so far, apart from an unaligned remainder for O_DIRECT sinks.
+	 * @return Zero is returned upon success, else the first errno value reported is returned.
+	 */
+	int flush()
+	{
+		_flushBuffer( false );
+		return mErrorCode;
+	}
+
+	/**
+	 * Get the number of bytes written so far, including any still buffered.
+	 * @return The offset within the output of the next byte to be written is returned.
+	 */
+	size_t offset() const
+	{
+		return mOffset;
+	}
+
+	/**
+	 * Open a file to write to, replacing the current sink after flushing it.
+	 * @param filename The name of the file to write to; it is truncated.
+	 * @param directIo Flag to bypass the page cache with O_DIRECT where supported; the file
+	 *                 is opened normally if the platform or filesystem does not support it. [default: false]
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	int open(
+		const std::string& filename,
+		bool directIo = false )
+	{
+		this->close();
+		mErrorCode = 0;
+		mOffset = 0;
+
+#if defined( FASTA_HAS_POSIX )
+		const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+		size_t alignment( 1 );
+		int fileDescriptor( -1 );
+
+#if defined( O_DIRECT )
+		if ( directIo )
+		{
+			fileDescriptor = ::open( filename.c_str(), flags | O_DIRECT, 0666 );
+			alignment = 4096;
+		}
+#else
+		static_cast< void >( directIo );
+#endif
+
+		if ( -1 == fileDescriptor )
+		{
+			fileDescriptor = ::open( filename.c_str(), flags, 0666 );
+			alignment = 1;
+		}
+
+		if ( -1 == fileDescriptor )
+		{
+			return errno;
+		}
+
+		mOutputSink.reset( new FastaFileDescriptorSink( fileDescriptor, true, alignment ) );
+#else
+		static_cast< void >( directIo );
+
+		struct FileSink : public FastaOutputSink
+		{
+			std::ofstream outputFile;
+			FastaStreamSink streamSink{ outputFile };
+
+			int write(
+				const char* data,
+				size_t length ) override
+			{
+				return streamSink.write( data, length );
+			}
+
+			int close() override
+			{
+				outputFile.close();
+
+				return outputFile ? 0 : EIO;
+			}
+		};
+
+		std::unique_ptr< FileSink > fileSink( new FileSink );
+		fileSink->outputFile.open( filename, std::ios::out | std::ios::binary | std::ios::trunc );
+
+		if ( not fileSink->outputFile )
+		{
+			return ENOENT;
+		}
+
+		mOutputSink = std::move( fileSink );
+#endif
+
+		_allocateBuffer( mBufferSize );
+
+		return 0;
+	}
+
+	/**
+	 * Gather statistics of the records written from now on, and report progress through them.
+	 * Bytes are counted as they are handed to the sink.
+	 * @param statistics Pointer to the statistics to add to, which must outlive the writer, or nullptr to stop gathering.
+	 */
+	void setStatistics(
+		FastaStatistics* statistics )
+	{
+		mStatistics = statistics;
+	}
+
+	/**
+	 * Write a record: the header line followed by the sequence wrapped at the line length.
+	 * @param sequence Const reference to the sequence to write.
+	 * @return Zero is returned upon success, else the first errno value reported is returned.
+	 */
+	int write(
+		const FastaSequence& sequence )
+	{
+		const size_t length = sequence.length();
+		const FastaStringView identifier = sequence._identifierView();
+
+		_put( '>' );
+		_put( identifier.data(), identifier.length() );
+		_put( '\n' );
+
+		for ( size_t offset( 0 ); offset < length; offset += mLineLength )
+		{
+			_put( sequence, offset, std::min( mLineLength, length - offset ) );
+			_put( '\n' );
+		}
+
+		if ( nullptr != mStatistics )
+		{
+			++mStatistics->records;
+		}
+
+		return mErrorCode;
+	}
+};
+
+/**
+ * This class maps a file into memory for read-only access. On platforms
+ * without mmap, the file is read into a heap buffer instead.
+ */
+class FastaMappedFile
+{
+private:
+	const char* mData;          // First byte of the file contents.
+	size_t mSize;               // Size of the file in bytes.
+	std::vector< char > mBuffer; // Backing store if the file could not be mapped.
+
+public:
+	/**
+	 * Default constructor to an empty mapping.
+	 */
+	FastaMappedFile()
+	{
+		mData = nullptr;
+		mSize = 0;
+	}
+
+	FastaMappedFile(
+		const FastaMappedFile& other ) = delete;
+
+	FastaMappedFile& operator=(
+		const FastaMappedFile& other ) = delete;
+
+	/**
+	 * Destructor. Unmaps the file.
+	 */
+	~FastaMappedFile()
+	{
+		this->close();
+	}
+
+	/**
+	 * Unmap the file, if one is mapped.
+	 */
+	void close()
+	{
+#if defined( FASTA_HAS_POSIX )
+		if ( mBuffer.empty() and ( nullptr != mData ) )
+		{
+			::munmap( const_cast< char* >( mData ), mSize );
+		}
+#endif
+
+		mBuffer.clear();
+		mData = nullptr;
+		mSize = 0;
+	}
+
+	/**
+	 * Get the contents of the file.
+	 * @return A pointer to the first byte of the file, or nullptr if the file is empty.
+	 */
+	const char* data() const
+	{
+		return mData;
+	}
+
+	/**
+	 * Map the given file into memory, unmapping any file previously mapped.
+	 * @param filename The name of the file to map.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	int open(
+		const std::string& filename )
+	{
+		this->close();
+
+#if defined( FASTA_HAS_POSIX )
+		int fileDescriptor = ::open( filename.c_str(), O_RDONLY );
+
+		if ( -1 == fileDescriptor )
+		{
+			return errno;
+		}
+
+		struct stat fileStatus;
+
+		if ( -1 == ::fstat( fileDescriptor, &fileStatus ) )
+		{
+			int errorCode = errno;
+			::close( fileDescriptor );
+			return errorCode;
+		}
+
+		if ( 0 < fileStatus.st_size )
+		{
+			void* address = ::mmap( nullptr, static_cast< size_t >( fileStatus.st_size ),
+				PROT_READ, MAP_PRIVATE, fileDescriptor, 0 );
+
+			if ( MAP_FAILED == address )
+			{
+				int errorCode = errno;
+				::close( fileDescriptor );
+				return errorCode;
+			}
+
+			mData = static_cast< const char* >( address );
+			mSize = static_cast< size_t >( fileStatus.st_size );
+		}
+
+		if ( -1 == ::close( fileDescriptor ) )
+		{
+			int errorCode = errno;
+			this->close();
+			return errorCode;
+		}
+#else
+		std::ifstream inputFile( filename, std::ios::in | std::ios::binary );
+
+		if ( not inputFile )
+		{
+			return ENOENT;
+		}
+
+		mBuffer.assign( std::istreambuf_iterator< char >( inputFile ), std::istreambuf_iterator< char >() );
+		mData = mBuffer.empty() ? nullptr : mBuffer.data();
+		mSize = mBuffer.size();
+#endif
+
+		return 0;
+	}
+
+	/**
+	 * Get the size of the file.
+	 * @return The size of the file in bytes is returned.
+	 */
+	size_t size() const
+	{
+		return mSize;
+	}
+};
+
+/**
+ * This class contains a samtools compatible .fai index of a FastA file. Each entry
+ * records the name (the header up to the first whitespace), the sequence length, the
+ * byte offset of the first sequence character, and the number of sequence characters
+ * and bytes per line; enough to locate any base of the file without reading it.
+ */
+class FastaIndex
+{
+public:
+	/**
+	 * A single line of the .fai index.
+	 */
+	struct Entry
+	{
+		std::string name;  // Sequence name.
+		size_t length;     // Number of sequence characters.
+		size_t offset;     // Byte offset of the first sequence character.
+		size_t lineBases;  // Sequence characters per line.
+		size_t lineWidth;  // Bytes per line, including the line terminator.
+
+		/**
+		 * Get the byte offset of the sequence character at the given position.
+		 * @param position Offset from the beginning of the sequence.
+		 * @return The byte offset within the file is returned.
+		 */
+		size_t byteOffset(
+			size_t position ) const
+		{
+			return ( 0 == lineBases )
+				? offset
+				: offset + ( position / lineBases ) * lineWidth + ( position % lineBases );
+		}
+
+		/**
+		 * Check the line layout: a non-empty sequence must have characters on its lines,
+		 * and no more of them than the bytes of a line.
+		 * @return True is returned if the layout is consistent.
+		 */
+		bool isValid() const
+		{
+			return ( lineBases <= lineWidth ) and ( ( 0 < lineBases ) or ( 0 == length ) );
+		}
+	};
+
+	using const_iterator = std::vector< Entry >::const_iterator;
+
+private:
+	friend class FastaFile;
+
+	std::vector< Entry > mEntries;           // Entries in file order.
+	std::map< std::string, size_t > mNameMap; // Name to offset within mEntries.
+
+	// Find the next header at or after position, which must be at the start of a line.
+	static const char* _findHeader(
+		const char* position,
+		const char* end )
+	{
+		while ( ( position < end ) and ( '>' != *position ) )
+		{
+			const void* newline = std::memchr( position, '\n', end - position );
+			position = ( nullptr == newline ) ? end : static_cast< const char* >( newline ) + 1;
+		}
+
+		return position;
+	}
+
+	// Invoke function( header, sequenceBegin, sequenceEnd ) for each record whose header starts
+	// in [begin, limit); begin must be at the start of a line. Sequences may extend up to end.
+	template < typename Function >
+	static void _forEachRecord(
+		const char* begin,
+		const char* limit,
+		const char* end,
+		Function function )
+	{
+		for ( const char* header = _findHeader( begin, end ); header < limit; )
+		{
+			const char* newline = static_cast< const char* >( std::memchr( header, '\n', end - header ) );
+			const char* sequenceBegin = ( nullptr == newline ) ? end : newline + 1;
+			const char* sequenceEnd = _findHeader( sequenceBegin, end );
+
+			function( header, sequenceBegin, sequenceEnd );
+			header = sequenceEnd;
+		}
+	}
+
+	// Measure the line layout of the sequence lines between begin and end. Returns true if every
+	// line holds the same number of characters, with the exception of the last line which may be
+	// shorter, and if requested, every character is a character of the alphabet. Blank lines are
+	// only permitted after the last line.
+	static bool _scanLayout(
+		const char* begin,
+		const char* end,
+		bool validate,
+		size_t& length,
+		size_t& lineBases,
+		size_t& lineWidth,
+		FastaAlphabet::Type alphabet = FastaAlphabet::Type::Any )
+	{
+		bool isUniform( true );
+		bool hasLastLine( false );
+
+		length = 0;
+		lineBases = 0;
+		lineWidth = 0;
+
+		for ( const char* line( begin ); isUniform and ( line < end ); )
+		{
+			const char* newline = static_cast< const char* >( std::memchr( line, '\n', end - line ) );
+			const char* lineEnd = ( nullptr == newline ) ? end : newline;
+			const char* nextLine = ( nullptr == newline ) ? end : newline + 1;
+			size_t bases = lineEnd - line;
+			size_t width = nextLine - line;
+
+			if ( ( 0 < bases ) and ( '\r' == lineEnd[ -1 ] ) )
+			{
+				--bases;
+			}
+
+			if ( validate )
+			{
+				isUniform = ( bases == FastaAlphabet::findInvalid( alphabet, line, bases ) );
+			}
+
+			if ( 0 == bases )
+			{
+				hasLastLine = true;
+			}
+			else if ( hasLastLine or ( ( 0 < lineBases ) and ( lineBases < bases ) ) )
+			{
+				isUniform = false;
+			}
+			else if ( 0 == lineBases )
+			{
+				lineBases = bases;
+				lineWidth = width;
+			}
+			else if ( ( bases < lineBases ) or ( width != lineWidth ) )
+			{
+				hasLastLine = true;
+			}
+
+			length += bases;
+			line = nextLine;
+		}
+
+		return isUniform;
+	}
+
+	// Add an entry unless its name is empty or already present.
+	void _addEntry(
+		Entry&& entry )
+	{
+		if ( ( 0 < entry.name.length() ) and ( mNameMap.end() == mNameMap.find( entry.name ) ) )
+		{
+			mNameMap.emplace( entry.name, mEntries.size() );
+			mEntries.push_back( std::move( entry ) );
+		}
+	}
+
+public:
+	/**
+	 * Get the entry for the given sequence name.
+	 * @param name The name of the sequence.
+	 * @return Const reference to the entry of the sequence.
+	 * @throw std::out_of_range is thrown if no such name is present in the index.
+	 */
+	const Entry& at(
+		const std::string& name ) const
+	{
+		return mEntries[ mNameMap.at( name ) ];
+	}
+
+	/**
+	 * Get a const_iterator to the first entry of the index.
+	 * @return A const_iterator to the first entry, in file order, is returned.
+	 */
+	const_iterator begin() const
+	{
+		return mEntries.begin();
+	}
+
+	/**
+	 * Build the index by scanning FastA contents held in memory. Duplicate names are
+	 * ignored after their first occurrence, as samtools does.
+	 * @param data Pointer to the FastA contents.
+	 * @param length The length of the contents in bytes.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         EINVAL is returned if a sequence does not have uniform line lengths.
+	 */
+	int build(
+		const char* data,
+		size_t length )
+	{
+		const char* const end = data + length;
+		int errorCode( 0 );
+
+		this->clear();
+
+		_forEachRecord( data, end, end,
+			[ & ]( const char* header, const char* sequenceBegin, const char* sequenceEnd )
+			{
+				const char* nameEnd = std::find_if( header + 1, sequenceBegin,
+					[]( const unsigned char character )
+					{
+						return std::isspace( character );
+					} );
+				Entry entry;
+
+				entry.name.assign( header + 1, nameEnd );
+				entry.offset = sequenceBegin - data;
+
+				if ( not _scanLayout( sequenceBegin, sequenceEnd, false, entry.length, entry.lineBases, entry.lineWidth ) )
+				{
+					errorCode = EINVAL;
+				}
+
+				_addEntry( std::move( entry ) );
+			} );
+
+		if ( 0 != errorCode )
+		{
+			this->clear();
+		}
+
+		return errorCode;
+	}
+
+	/**
+	 * Build the index by scanning a FastA file. Duplicate names are
+	 * ignored after their first occurrence, as samtools does.
+	 * @param filename The name of the FastA file to index.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         EINVAL is returned if a sequence does not have uniform line lengths.
+	 */
+	int build(
+		const std::string& filename )
+	{
+		FastaMappedFile mappedFile;
+		int errorCode = mappedFile.open( filename );
+
+		this->clear();
+
+		if ( 0 != errorCode )
+		{
+			return errorCode;
+		}
+
+		return this->build( mappedFile.data(), mappedFile.size() );
+	}
+
+	/**
+	 * Remove all entries from the index.
+	 */
+	void clear()
+	{
+		mEntries.clear();
+		mNameMap.clear();
+	}
+
+	/**
+	 * Get a const_iterator to the end of the index.
+	 * @return A const_iterator to the end of the index is returned.
+	 */
+	const_iterator end() const
+	{
+		return mEntries.end();
+	}
+
+	/**
+	 * Check for the presence of a sequence name in the index.
+	 * @param name Const reference to the name to check for.
+	 * @return True is returned if the name is present.
+	 */
+	bool hasName(
+		const std::string& name ) const
+	{
+		return mNameMap.end() != mNameMap.find( name );
+	}
+
+	/**
+	 * Load a .fai index file, replacing the current entries.
+	 * @param filename The name of the .fai file to read.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         ENOENT is returned if the file cannot be opened.
+	 *         EINVAL is returned if a line of the index is malformed or its line layout is inconsistent.
+	 */
+	int readFile(
+		const std::string& filename )
+	{
+		std::ifstream inputFile( filename, std::ios::in );
+		std::string line;
+
+		this->clear();
+
+		if ( not inputFile )
+		{
+			return ENOENT;
+		}
+
+		while ( std::getline( inputFile, line ) )
+		{
+			if ( line.empty() )
+			{
+				continue;
+			}
+
+			Entry entry;
+			const size_t tab = line.find( '\t' );
+			char* fieldEnd = nullptr;
+			const char* field = ( std::string::npos == tab ) ? nullptr : line.c_str() + tab;
+			size_t* values[] = { &entry.length, &entry.offset, &entry.lineBases, &entry.lineWidth };
+
+			for ( size_t* value : values )
+			{
+				if ( ( nullptr == field ) or ( '\t' != *field ) )
+				{
+					this->clear();
+					return EINVAL;
+				}
+
+				*value = std::strtoull( field + 1, &fieldEnd, 10 );
+				field = ( fieldEnd == field + 1 ) ? nullptr : fieldEnd;
+			}
+
+			if ( not entry.isValid() )
+			{
+				this->clear();
+				return EINVAL;
+			}
+
+			entry.name = line.substr( 0, tab );
+			_addEntry( std::move( entry ) );
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Get the number of entries in the index.
+	 * @return The number of indexed sequences is returned.
+	 */
+	size_t size() const
+	{
+		return mEntries.size();
+	}
+
+	/**
+	 * Write the index out to a .fai file.
+	 * @param filename Name of the file to write to.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	int writeFile(
+		const std::string& filename ) const
+	{
+		std::ofstream outputFile( filename, std::ios::out | std::ios::trunc );
+
+		for ( const auto& entry : mEntries )
+		{
+			outputFile << entry.name << '\t' << entry.length << '\t' << entry.offset << '\t'
+				<< entry.lineBases << '\t' << entry.lineWidth << '\n';
+		}
+
+		outputFile.close();
+
+		return outputFile ? 0 : ( ( 0 == errno ) ? EIO : errno );
+	}
+};
+
+/**
+ * This class holds a .gzi index of a BGZF file, as written by bgzip and samtools: the
+ * compressed and uncompressed offsets of the start of each block, which locates the block
+ * holding any uncompressed offset without inflating the blocks before it.
+ */
+class FastaGzipIndex
+{
+public:
+	/**
+	 * Offsets of the start of a block.
+	 */
+	struct Entry
+	{
+		uint64_t compressedOffset;   // Offset of the block in the compressed file.
+		uint64_t uncompressedOffset; // Offset of the contents of the block in the uncompressed data.
+	};
+
+private:
+	std::vector< Entry > mEntries; // Blocks in file order; the first block at ( 0, 0 ) is implicit in the file format.
+
+	static void _putLittleEndian(
+		std::ostream& outputStream,
+		uint64_t value )
+	{
+		char bytes[ 8 ];
+
+		for ( char& byte : bytes )
+		{
+			byte = static_cast< char >( value & 0xFF );
+			value >>= 8;
+		}
+
+		outputStream.write( bytes, sizeof( bytes ) );
+	}
+
+public:
+	/**
+	 * Default constructor to an index of a single block.
+	 */
+	FastaGzipIndex()
+	{
+		this->clear();
+	}
+
+	/**
+	 * Get the entry at the given position.
+	 * @param position The position of the block in the file.
+	 * @return Const reference to the entry.
+	 * @throw std::out_of_range is thrown if position is not less than size().
+	 */
+	const Entry& at(
+		size_t position ) const
+	{
+		return mEntries.at( position );
+	}
+
+	/**
+	 * Build the index by scanning the block headers of a BGZF file. Blocks are not inflated.
+	 * @param filename The name of the BGZF file to index.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         EINVAL is returned if the file is not BGZF compressed.
+	 */
+	int build(
+		const std::string& filename )
+	{
+		FastaMappedFile mappedFile;
+		int errorCode = mappedFile.open( filename );
+
+		this->clear();
+
+		if ( 0 != errorCode )
+		{
+			return errorCode;
+		}
+
+		const char* const data = mappedFile.data();
+		Entry entry = { 0, 0 };
+
+		while ( entry.compressedOffset < mappedFile.size() )
+		{
+			const size_t available = mappedFile.size() - entry.compressedOffset;
+			const size_t blockSize = FastaCompression::bgzfBlockSize( data + entry.compressedOffset, available );
+
+			if ( ( 0 == blockSize ) or ( blockSize > available ) or ( 20 > blockSize ) )
+			{
+				this->clear();
+				return EINVAL;
+			}
+
+			entry.uncompressedOffset += FastaCompression::readLittleEndian( data + entry.compressedOffset + blockSize - 4, 4 );
+			entry.compressedOffset += blockSize;
+
+			if ( entry.compressedOffset < mappedFile.size() )
+			{
+				mEntries.push_back( entry );
+			}
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Reset to an index of a single block.
+	 */
+	void clear()
+	{
+		mEntries.assign( 1, Entry{ 0, 0 } );
+	}
+
+	/**
+	 * Find the block holding an uncompressed offset.
+	 * @param uncompressedOffset The offset in the uncompressed data.
+	 * @return The position of the last block starting at or before the offset is returned.
+	 */
+	size_t find(
+		uint64_t uncompressedOffset ) const
+	{
+		auto next = std::upper_bound( mEntries.begin() + 1, mEntries.end(), uncompressedOffset,
+			[]( const uint64_t offset, const Entry& entry )
+			{
+				return offset < entry.uncompressedOffset;
+			} );
+
+		return ( next - mEntries.begin() ) - 1;
+	}
+
+	/**
+	 * Read in a .gzi file, replacing the current entries.
+	 * @param filename The name of the .gzi file to read.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         EINVAL is returned if the file is malformed.
+	 */
+	int readFile(
+		const std::string& filename )
+	{
+		std::ifstream inputFile( filename, std::ios::in | std::ios::binary );
+		char bytes[ 16 ];
+
+		this->clear();
+
+		if ( not inputFile )
+		{
+			return ( 0 == errno ) ? ENOENT : errno;
+		}
+
+		if ( not inputFile.read( bytes, 8 ) )
+		{
+			return EINVAL;
+		}
+
+		for ( uint64_t count = FastaCompression::readLittleEndian( bytes, 8 ); 0 < count; --count )
+		{
+			if ( not inputFile.read( bytes, 16 ) )
+			{
+				this->clear();
+				return EINVAL;
+			}
+
+			mEntries.push_back( Entry{
+				FastaCompression::readLittleEndian( bytes, 8 ),
+				FastaCompression::readLittleEndian( bytes + 8, 8 ) } );
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Get the number of blocks in the index.
+	 * @return The number of blocks is returned.
+	 */
+	size_t size() const
+	{
+		return mEntries.size();
+	}
+
+	/**
+	 * Write the index out to a .gzi file.
+	 * @param filename The name of the .gzi file to write.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	int writeFile(
+		const std::string& filename ) const
+	{
+		std::ofstream outputFile( filename, std::ios::out | std::ios::trunc | std::ios::binary );
+
+		_putLittleEndian( outputFile, mEntries.size() - 1 );
+
+		for ( size_t entry( 1 ); entry < mEntries.size(); ++entry )
+		{
+			_putLittleEndian( outputFile, mEntries[ entry ].compressedOffset );
+			_putLittleEndian( outputFile, mEntries[ entry ].uncompressedOffset );
+		}
+
+		outputFile.close();
+
+		return outputFile ? 0 : ( ( 0 == errno ) ? EIO : errno );
+	}
+};
+
+/**
+ * This class provides random access to regions of an indexed FastA file. Only the bytes
+ * of the requested region are read, so a query costs O(region size) regardless of the
+ * size of the file.
+ */
+class IndexedFastaFile
+{
+public:
+	/**
+	 * A region of a sequence, in the zero-based, half-open coordinates of BED files.
+	 */
+	struct Region
+	{
+		std::string name; // Name of the sequence, as it appears in the index.
+		size_t start;     // Offset of the first character of the region.
+		size_t end;       // Offset one past the last character of the region.
+	};
+
+private:
+	FastaIndex mIndex;    // Index of the open file.
+	FastaGzipIndex mGzipIndex; // Block index of the open file if it is BGZF compressed.
+	bool mIsCompressed;   // True if the open file is BGZF compressed.
+#if defined( FASTA_HAS_POSIX )
+	int mFileDescriptor;  // Descriptor of the open file, or -1.
+#else
+	mutable std::ifstream mInputFile; // The open file.
+#endif
+
+	// Read up to count bytes from the given byte offset of the file, stopping short only at its end.
+	int _readFileBytes(
+		char* destination,
+		size_t count,
+		size_t offset,
+		size_t& bytesRead ) const
+	{
+		bytesRead = 0;
+
+#if defined( FASTA_HAS_POSIX )
+		while ( bytesRead < count )
+		{
+			ssize_t result = ::pread( mFileDescriptor, destination + bytesRead, count - bytesRead,
+				static_cast< off_t >( offset + bytesRead ) );
+
+			if ( 0 > result )
+			{
+				if ( EINTR == errno )
+				{
+					continue;
+				}
+
+				return errno;
+			}
+
+			if ( 0 == result )
+			{
+				break;
+			}
+
+			bytesRead += result;
+		}
+
+		return 0;
+#else
+		mInputFile.clear();
+		mInputFile.seekg( offset );
+		mInputFile.read( destination, count );
+		bytesRead = static_cast< size_t >( mInputFile.gcount() );
+
+		return mInputFile.bad() ? EIO : 0;
+#endif
+	}
+
+#if defined( FASTA_HAS_ZLIB )
+	// Inflate the BGZF block at the given offset of the file, using compressed as scratch space.
+	int _inflateBlock(
+		uint64_t compressedOffset,
+		std::string& compressed,
+		std::string& block,
+		size_t& blockSize ) const
+	{
+		size_t bytesRead;
+
+		compressed.resize( 1 << 16 );
+
+		int errorCode = _readFileBytes( &compressed[ 0 ], compressed.length(), compressedOffset, bytesRead );
+
+		if ( 0 != errorCode )
+		{
+			return errorCode;
+		}
+
+		blockSize = FastaCompression::bgzfBlockSize( compressed.data(), bytesRead );
+
+		if ( ( 0 == blockSize ) or ( blockSize > bytesRead ) )
+		{
+			return EIO;
+		}
+
+		return FastaCompression::inflateBgzfBlock( compressed.data(), blockSize, block );
+	}
+
+	// Build the FastA index of the open BGZF file by inflating it into memory.
+	int _buildCompressedIndex()
+	{
+		std::string compressed;
+		std::string block;
+		std::string contents;
+
+		for ( size_t position( 0 ); position < mGzipIndex.size(); ++position )
+		{
+			size_t blockSize;
+			int errorCode = _inflateBlock( mGzipIndex.at( position ).compressedOffset, compressed, block, blockSize );
+
+			if ( 0 != errorCode )
+			{
+				return errorCode;
+			}
+
+			contents += block;
+		}
+
+		return mIndex.build( contents.data(), contents.length() );
+	}
+#endif
+
+	// Read count bytes from the given byte offset of the uncompressed contents of the file.
+	int _readBytes(
+		char* destination,
+		size_t count,
+		size_t offset ) const
+	{
+#if defined( FASTA_HAS_ZLIB )
+		if ( mIsCompressed )
+		{
+			std::string compressed;
+			std::string block;
+			const size_t position = mGzipIndex.find( offset );
+			uint64_t compressedOffset = mGzipIndex.at( position ).compressedOffset;
+			size_t blockOffset = offset - mGzipIndex.at( position ).uncompressedOffset;
+
+			while ( 0 < count )
+			{
+				size_t blockSize;
+				int errorCode = _inflateBlock( compressedOffset, compressed, block, blockSize );
+
+				if ( 0 != errorCode )
+				{
+					return errorCode;
+				}
+
+				if ( blockOffset < block.length() )
+				{
+					const size_t blockCount = std::min( count, block.length() - blockOffset );
+
+					std::memcpy( destination, block.data() + blockOffset, blockCount );
+					destination += blockCount;
+					count -= blockCount;
+					blockOffset = 0;
+				}
+				else
+				{
+					blockOffset -= block.length();
+				}
+
+				compressedOffset += blockSize;
+			}
+
+			return 0;
+		}
+#endif
+
+		size_t bytesRead;
+		int errorCode = _readFileBytes( destination, count, offset, bytesRead );
+
+		return ( 0 != errorCode ) ? errorCode : ( ( bytesRead < count ) ? EIO : 0 );
+	}
+
+	// Remove the line terminators from the bytes read for a region.
+	static void _removeLineTerminators(
+		std::string& sequence )
+	{
+		sequence.erase(
+			std::remove_if(
+				sequence.begin(), sequence.end(),
+				[]( const char character )
+				{
+					return ( '\n' == character ) or ( '\r' == character );
+				} ),
+			sequence.end() );
+	}
+
+public:
+	/**
+	 * Default constructor to a closed file.
+	 */
+	IndexedFastaFile()
+	{
+		mIsCompressed = false;
+#if defined( FASTA_HAS_POSIX )
+		mFileDescriptor = -1;
+#endif
+	}
+
+	IndexedFastaFile(
+		const IndexedFastaFile& other ) = delete;
+
+	IndexedFastaFile& operator=(
+		const IndexedFastaFile& other ) = delete;
+
+	/**
+	 * Destructor. Closes the file.
+	 */
+	~IndexedFastaFile()
+	{
+		this->close();
+	}
+
+	/**
+	 * Close the file and discard its index.
+	 * @return Zero is returned upon success, else the errno value of closing the file is returned.
+	 */
+	int close()
+	{
+		int errorCode( 0 );
+
+#if defined( FASTA_HAS_POSIX )
+		if ( ( -1 != mFileDescriptor ) and ( -1 == ::close( mFileDescriptor ) ) )
+		{
+			errorCode = errno;
+		}
+
+		mFileDescriptor = -1;
+#else
+		if ( mInputFile.is_open() )
+		{
+			mInputFile.clear(); // Only the failure of close itself is reported, not that of earlier reads.
+			mInputFile.close();
+			errorCode = mInputFile ? 0 : EIO;
+		}
+#endif
+
+		mIndex.clear();
+		mGzipIndex.clear();
+		mIsCompressed = false;
+
+		return errorCode;
+	}
+
+	/**
+	 * Fetch a region of a sequence; only the bytes covering the region are read.
+	 * The end of the region is clamped to the length of the sequence.
+	 * @param identifier The name of the sequence, as it appears in the index.
+	 * @param start Zero-based offset of the first character of the region.
+	 * @param end Zero-based offset one past the last character of the region.
+	 * @param sequence Reference to the string to store the region in. Its capacity is reused.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         EINVAL is returned if the line layout of the sequence in the index is inconsistent.
+	 * @throw std::out_of_range is thrown if no such identifier is present in the index.
+	 */
+	int fetch(
+		const std::string& identifier,
+		size_t start,
+		size_t end,
+		std::string& sequence ) const
+	{
+		const FastaIndex::Entry& entry = mIndex.at( identifier );
+
+		end = std::min( end, entry.length );
+		sequence.clear();
+
+		if ( start >= end )
+		{
+			return 0;
+		}
+
+		const size_t firstByte = entry.byteOffset( start );
+		const size_t lastByte = entry.byteOffset( end - 1 );
+
+		if ( ( not entry.isValid() ) or ( lastByte < firstByte ) )
+		{
+			return EINVAL;
+		}
+
+		sequence.resize( lastByte - firstByte + 1 );
+
+		int errorCode = _readBytes( &sequence[ 0 ], sequence.length(), firstByte );
+
+		if ( 0 != errorCode )
+		{
+			sequence.clear();
+			return errorCode;
+		}
+
+		_removeLineTerminators( sequence );
+
+		return 0;
+	}
+
+	/**
+	 * Fetch a region given in samtools notation: "name", "name:begin" or "name:begin-end",
+	 * where begin and end are one-based and inclusive. If the whole region string is the
+	 * name of a sequence, then it is taken as the name.
+	 * @param region The region to fetch.
+	 * @param sequence Reference to the string to store the region in. Its capacity is reused.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         EINVAL is returned if the region cannot be parsed.
+	 * @throw std::out_of_range is thrown if no such identifier is present in the index.
+	 */
+	int fetch(
+		const std::string& region,
+		std::string& sequence ) const
+	{
+		const size_t colon = region.rfind( ':' );
+
+		if ( mIndex.hasName( region ) or ( std::string::npos == colon ) )
+		{
+			return this->fetch( region, 0, static_cast< size_t >( -1 ), sequence );
+		}
+
+		const char* range = region.c_str() + colon + 1;
+		char* rangeEnd = nullptr;
+		size_t begin = std::strtoull( range, &rangeEnd, 10 );
+		size_t end = static_cast< size_t >( -1 );
+
+		if ( ( rangeEnd == range ) or ( 0 == begin ) )
+		{
+			return EINVAL;
+		}
+
+		if ( '-' == *rangeEnd )
+		{
+			range = rangeEnd + 1;
+			end = std::strtoull( range, &rangeEnd, 10 );
+
+			if ( rangeEnd == range )
+			{
+				return EINVAL;
+			}
+		}
+
+		if ( '\0' != *rangeEnd )
+		{
+			return EINVAL;
+		}
+
+		return this->fetch( region.substr( 0, colon ), begin - 1, end, sequence );
+	}
+
+	/**
+	 * Fetch many regions at once with few reads. The byte ranges of the regions are sorted by
+	 * offset, and ranges that overlap or lie within {@param mergeDistance} bytes of each other are
+	 * read together, up to 16MiB at a time, so that neighbouring windows cost a single read.
+	 * The ranges read are spread across the threads. The end of each region is clamped to the
+	 * length of its sequence.
+	 * @param regions The regions to fetch; see readRegions for reading them from a BED file.
+	 * @param sequences Reference to the vector to store the regions in, in the order of {@param regions}.
+	 * @param threadCount The number of threads reading, or zero for one per hardware thread. Reads
+	 *                    are made one at a time on platforms without pread. [default: 1]
+	 * @param mergeDistance The largest gap, in bytes, read through to merge two ranges. [default: 4096]
+	 * @return Zero is returned upon success, else an errno value is returned and {@param sequences} is cleared.
+	 *         EINVAL is returned if the line layout of a sequence in the index is inconsistent.
+	 * @throw std::out_of_range is thrown if the name of a region is not present in the index.
+	 */
+	int fetchRegions(
+		const std::vector< Region >& regions,
+		std::vector< std::string >& sequences,
+		size_t threadCount = 1,
+		size_t mergeDistance = 4096 ) const
+	{
+		const size_t maxReadSize( 16 << 20 );
+
+		struct Range
+		{
+			size_t begin;  // Offset of the first byte of the region.
+			size_t end;    // Offset one past the last byte of the region.
+			size_t region; // Position of the region in the request.
+		};
+
+		struct Read
+		{
+			size_t begin;      // Offset of the first byte read.
+			size_t end;        // Offset one past the last byte read.
+			size_t firstRange; // First range covered by the read.
+			size_t lastRange;  // One past the last range covered by the read.
+		};
+
+		std::vector< Range > ranges;
+		std::vector< Read > reads;
+
+		sequences.assign( regions.size(), std::string() );
+
+		for ( size_t region( 0 ); region < regions.size(); ++region )
+		{
+			const FastaIndex::Entry& entry = mIndex.at( regions[ region ].name );
+			const size_t end = std::min( regions[ region ].end, entry.length );
+
+			if ( not entry.isValid() )
+			{
+				sequences.clear();
+				return EINVAL;
+			}
+
+			if ( regions[ region ].start < end )
+			{
+				ranges.push_back( Range{ entry.byteOffset( regions[ region ].start ), entry.byteOffset( end - 1 ) + 1, region } );
+			}
+		}
+
+		std::sort( ranges.begin(), ranges.end(),
+			[]( const Range& lhs, const Range& rhs )
+			{
+				return lhs.begin < rhs.begin;
+			} );
+
+		for ( size_t range( 0 ); range < ranges.size(); ++range )
+		{
+			if ( reads.empty() or ( ranges[ range ].begin > reads.back().end + mergeDistance )
+				or ( std::max( reads.back().end, ranges[ range ].end ) - reads.back().begin > maxReadSize ) )
+			{
+				reads.push_back( Read{ ranges[ range ].begin, ranges[ range ].end, range, range + 1 } );
+			}
+			else
+			{
+				reads.back().end = std::max( reads.back().end, ranges[ range ].end );
+				reads.back().lastRange = range + 1;
+			}
+		}
+
+#if defined( FASTA_HAS_POSIX )
+		threadCount = ( 0 == threadCount ) ? std::max( std::thread::hardware_concurrency(), 1u ) : threadCount;
+#else
+		threadCount = 1;
+#endif
+
+		std::atomic< size_t > nextRead( 0 );
+		std::atomic< int > firstErrorCode( 0 );
+		std::vector< std::thread > threads;
+
+		auto worker = [ & ]()
+		{
+			std::string bytes;
+
+			for ( size_t read = nextRead++; read < reads.size(); read = nextRead++ )
+			{
+				bytes.resize( reads[ read ].end - reads[ read ].begin );
+
+				int errorCode = _readBytes( &bytes[ 0 ], bytes.length(), reads[ read ].begin );
+
+				if ( 0 != errorCode )
+				{
+					int noError( 0 );
+					firstErrorCode.compare_exchange_strong( noError, errorCode );
+					nextRead = reads.size();
+					break;
+				}
+
+				for ( size_t range( reads[ read ].firstRange ); range < reads[ read ].lastRange; ++range )
+				{
+					std::string& sequence = sequences[ ranges[ range ].region ];
+
+					sequence.assign( bytes, ranges[ range ].begin - reads[ read ].begin, ranges[ range ].end - ranges[ range ].begin );
+					_removeLineTerminators( sequence );
+				}
+			}
+		};
+
+		for ( size_t thread( 1 ); thread < std::min( threadCount, reads.size() ); ++thread )
+		{
+			threads.emplace_back( worker );
+		}
+
+		worker();
+
+		for ( auto& thread : threads )
+		{
+			thread.join();
+		}
+
+		if ( 0 != firstErrorCode )
+		{
+			sequences.clear();
+		}
+
+		return firstErrorCode;
+	}
+
+	/**
+	 * Get the index of the open file.
+	 * @return Const reference to the index.
+	 */
+	const FastaIndex& index() const
+	{
+		return mIndex;
+	}
+
+	/**
+	 * Open a FastA file for random access. The index is loaded from filename + ".fai" if it
+	 * exists, otherwise the index is built by scanning the file. BGZF compressed files are
+	 * supported; their block index is loaded from filename + ".gzi" if it exists, otherwise
+	 * it is built from the block headers. Building the FastA index of a compressed file
+	 * inflates the whole file into memory.
+	 * @param filename The name of the FastA file to open.
+	 * @param writeIndex Flag to write newly built indexes out to filename + ".fai" and ".gzi". [default: false]
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         ENOTSUP is returned for gzip files that are not BGZF, which cannot be seeked,
+	 *         and for BGZF files if zlib support is not enabled.
+	 */
+	int open(
+		const std::string& filename,
+		bool writeIndex = false )
+	{
+		const std::string indexFilename = filename + ".fai";
+		const FastaCompression::Format format = FastaCompression::detectFile( filename );
+		int errorCode;
+
+		this->close();
+
+#if defined( FASTA_HAS_ZLIB )
+		if ( FastaCompression::Format::Gzip == format )
+#else
+		if ( FastaCompression::Format::None != format )
+#endif
+		{
+			return ENOTSUP;
+		}
+
+#if defined( FASTA_HAS_POSIX )
+		mFileDescriptor = ::open( filename.c_str(), O_RDONLY );
+
+		if ( -1 == mFileDescriptor )
+		{
+			errorCode = errno;
+			this->close();
+			return errorCode;
+		}
+#else
+		mInputFile.open( filename, std::ios::in | std::ios::binary );
+
+		if ( not mInputFile )
+		{
+			this->close();
+			return ENOENT;
+		}
+#endif
+
+#if defined( FASTA_HAS_ZLIB )
+		const std::string gzipIndexFilename = filename + ".gzi";
+
+		mIsCompressed = ( FastaCompression::Format::Bgzf == format );
+
+		if ( mIsCompressed and ( 0 != mGzipIndex.readFile( gzipIndexFilename ) ) )
+		{
+			errorCode = mGzipIndex.build( filename );
+
+			if ( ( 0 == errorCode ) and writeIndex )
+			{
+				errorCode = mGzipIndex.writeFile( gzipIndexFilename );
+			}
+
+			if ( 0 != errorCode )
+			{
+				this->close();
+				return errorCode;
+			}
+		}
+#endif
+
+		if ( 0 != mIndex.readFile( indexFilename ) )
+		{
+#if defined( FASTA_HAS_ZLIB )
+			errorCode = mIsCompressed ? _buildCompressedIndex() : mIndex.build( filename );
+#else
+			errorCode = mIndex.build( filename );
+#endif
+
+			if ( ( 0 == errorCode ) and writeIndex )
+			{
+				errorCode = mIndex.writeFile( indexFilename );
+			}
+
+			if ( 0 != errorCode )
+			{
+				this->close();
+				return errorCode;
+			}
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Read regions from a BED file: a chrom, chromStart and chromEnd per line, separated by
+	 * white space and followed by any other columns, which are ignored. Blank lines, comments,
+	 * and track and browser lines are skipped.
+	 * @param filename The name of the BED file to read.
+	 * @param regions Reference to the vector to append the regions to.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         EINVAL is returned if a line is malformed; the regions of the lines before it are kept.
+	 */
+	static int readRegions(
+		const std::string& filename,
+		std::vector< Region >& regions )
+	{
+		std::ifstream inputFile( filename, std::ios::in | std::ios::binary );
+		std::string line;
+
+		if ( not inputFile )
+		{
+			return ( 0 == errno ) ? ENOENT : errno;
+		}
+
+		// Parse an unsigned decimal column following white space, leaving end at field on failure.
+		auto parseColumn = []( const char* field, const char*& end ) -> size_t
+		{
+			end = field;
+
+			while ( ( ' ' == *field ) or ( '\t' == *field ) )
+			{
+				++field;
+			}
+
+			char* digitsEnd = nullptr;
+			const size_t value = std::isdigit( static_cast< unsigned char >( *field ) ) ? std::strtoull( field, &digitsEnd, 10 ) : 0;
+
+			end = ( nullptr == digitsEnd ) ? end : digitsEnd;
+
+			return value;
+		};
+
+		while ( std::getline( inputFile, line ) )
+		{
+			const char* field = line.c_str();
+
+			while ( std::isspace( static_cast< unsigned char >( *field ) ) )
+			{
+				++field;
+			}
+
+			if ( ( '\0' == *field ) or ( '#' == *field ) or ( 0 == line.compare( field - line.c_str(), 5, "track" ) )
+				or ( 0 == line.compare( field - line.c_str(), 7, "browser" ) ) )
+			{
+				continue;
+			}
+
+			const char* nameEnd = field;
+
+			while ( ( '\0' != *nameEnd ) and not std::isspace( static_cast< unsigned char >( *nameEnd ) ) )
+			{
+				++nameEnd;
+			}
+
+			Region region;
+			const char* startEnd;
+			const char* endEnd;
+
+			region.name.assign( field, nameEnd );
+			region.start = parseColumn( nameEnd, startEnd );
+			region.end = parseColumn( startEnd, endEnd );
+
+			if ( ( startEnd == nameEnd ) or ( endEnd == startEnd ) or ( region.end < region.start )
+				or ( ( '\0' != *endEnd ) and not std::isspace( static_cast< unsigned char >( *endEnd ) ) ) )
+			{
+				return EINVAL;
+			}
+
+			regions.push_back( std::move( region ) );
+		}
+
+		return inputFile.bad() ? EIO : 0;
+	}
+};
+
+/**
+ * This class is a bump allocator handing out bytes from a few large slabs. Allocations are
+ * not freed individually; every slab is released at once when the arena is destroyed.
+ * FastaFile keeps the identifiers and sequences it loads in an arena, each sequence holding
+ * a reference to the arena for as long as it views bytes in it.
+ */
+class FastaArena
+{
+private:
+	std::vector< std::unique_ptr< char[] > > mSlabs; // Allocated slabs.
+	size_t mSlabSize;  // Largest size of a regular slab.
+	char* mCursor;     // Next free byte of the current slab.
+	size_t mAvailable; // Free bytes left in the current slab.
+	size_t mCapacity;  // Total bytes of all slabs.
+	size_t mSize;      // Total bytes handed out.
+
+public:
+	/**
+	 * Constructor. Slabs start at 64KiB and double in size up to slabSize, so that small
+	 * containers stay small.
+	 * @param slabSize Largest size of a slab in bytes. [default: 16MiB]
+	 */
+	explicit FastaArena(
+		size_t slabSize = 16 << 20 )
+	{
+		mSlabSize = std::max( slabSize, static_cast< size_t >( 1 ) );
+		mCursor = nullptr;
+		mAvailable = 0;
+		mCapacity = 0;
+		mSize = 0;
+	}
+
+	FastaArena(
+		const FastaArena& other ) = delete;
+
+	FastaArena& operator=(
+		const FastaArena& other ) = delete;
+
+	/**
+	 * Allocate bytes from the arena. They remain valid until the arena is destroyed.
+	 * Requests larger than a quarter of the next slab get a slab of their own, so that
+	 * the remainder of the current slab is not wasted.
+	 * @param length The number of bytes to allocate.
+	 * @return A pointer to the allocated bytes is returned.
+	 * @throw std::bad_alloc is thrown if a slab cannot be allocated.
+	 */
+	char* allocate(
+		size_t length )
+	{
+		if ( length > mAvailable )
+		{
+			const size_t slabSize = std::min( mSlabSize, std::max( mCapacity, static_cast< size_t >( 1 << 16 ) ) );
+
+			if ( 4 * length > slabSize )
+			{
+				mSlabs.emplace_back( new char[ length ] );
+				mCapacity += length;
+				mSize += length;
+
+				return mSlabs.back().get();
+			}
+
+			mSlabs.emplace_back( new char[ slabSize ] );
+			mCursor = mSlabs.back().get();
+			mAvailable = slabSize;
+			mCapacity += slabSize;
+		}
+
+		char* bytes = mCursor;
+		mCursor += length;
+		mAvailable -= length;
+		mSize += length;
+
+		return bytes;
+	}
+
+	/**
+	 * Get the total size of the slabs.
+	 * @return The number of bytes allocated from the heap is returned.
+	 */
+	size_t capacity() const
+	{
+		return mCapacity;
+	}
+
+	/**
+	 * Get the number of bytes handed out.
+	 * @return The number of bytes allocated from the arena is returned.
+	 */
+	size_t size() const
+	{
+		return mSize;
+	}
+};
+
+/**
+ * This class contains a collection of FastaSequences and
+ * facilitates the reading/writing of FastA files, searchinng
+ * based on the identifier, iterating over the collection, addition
+ * and subtraction of sequences
+ */
+class FastaFile
+{
+public:
+	/**
+	 * How writeFile partitions the records across several output files.
+	 */
+	enum class Sharding
+	{
+		Count,      // Consecutive runs of records, an equal number of records per file.
+		Bases,      // Consecutive runs of records, about an equal number of bases per file.
+		Identifier  // Records by identifier hash, so an identifier always goes to the same file.
+	};
+
+	/**
+	 * Breakdown of the heap memory held by the container; see memoryUsage.
+	 */
+	struct MemoryUsage
+	{
+		size_t identifiers;    // Identifiers held by the records.
+		size_t sequences;      // Sequences held by the records, unpacked or packed.
+		size_t arena;          // Slabs of the arena holding loaded records; see useArenaStorage.
+		size_t records;        // The FastaSequence instances and the vectors grouping them.
+		size_t index;          // Index from identifier to group, and the sorted index of findByPrefix.
+		size_t identifiersSet; // Set cached by getIdentifiers, estimated from its node layout.
+		size_t slack;          // Unused capacity of the vectors and strings above, included in them.
+
+		/**
+		 * Get the total heap memory held by the container.
+		 * @return The number of bytes is returned.
+		 */
+		size_t total() const
+		{
+			return identifiers + sequences + arena + records + index + identifiersSet;
+		}
+	};
+
+private:
+	friend class ConcurrentFastaFile;
+
+	using SequenceGroupsType = std::vector< std::vector< FastaSequence > >;
+
+	// Slot of the identifier hash index; group is npos for an empty slot.
+	struct IdentifierSlot
+	{
+		size_t hash;
+		size_t group;
+	};
+
+	// Layout of a snapshot; see saveSnapshot. Every integer is little endian.
+	static const uint32_t SnapshotVersion = 1;
+	static const size_t SnapshotHeaderSize = 80; // Magic, version, flags, hash check, counts and offsets.
+	static const size_t SnapshotRecordSize = 48; // Offsets and lengths of the identifier and sequence, group, alphabet, storage.
+	static const size_t SnapshotSlotSize = 16;   // Hash and group of an index slot.
+	static const size_t SnapshotPackedSize = 24; // Byte, N run and soft-masked run counts ahead of packed bases.
+
+	bool mIsBareSequence;
+	bool mDuplicateIdentifiersAllowed;
+	bool mIsArenaStorageUsed;                     // True if loaded records are stored in mArena.
+	FastaSequence::Normalization mNormalization;  // How the sequences of loaded records are normalized.
+	FastaAlphabet::Type mAlphabet;                // Alphabet the sequences of loaded records are normalized to.
+	bool mIsAlphabetDetected;                     // True if mAlphabet is detected from each file loaded.
+	std::shared_ptr< FastaArena > mArena;         // Storage of the loaded records, created on demand.
+	SequenceGroupsType mSequenceGroups;           // Sequences sharing an identifier, in order of first insertion.
+	std::vector< IdentifierSlot > mIdentifierSlots; // Open addressing index from identifier to group.
+	size_t mGeneration;                              // Bumped whenever groups are removed or replaced, but not when appended.
+	mutable std::set< std::string > mIdentifiersSet; // Built on demand by getIdentifiers.
+	mutable size_t mIdentifiersSetGeneration;        // Generation of the groups mIdentifiersSet was built from.
+	mutable std::vector< size_t > mSortedGroups;     // Groups in identifier order, built on demand by findByPrefix.
+	mutable size_t mSortedGroupsGeneration;          // Generation of the groups mSortedGroups was built from.
+
+	void _copyAssign(
+		const FastaFile& other )
+	{
+		mIsBareSequence = other.mIsBareSequence;
+		mDuplicateIdentifiersAllowed = other.mDuplicateIdentifiersAllowed;
+		mIsArenaStorageUsed = other.mIsArenaStorageUsed;
+		mNormalization = other.mNormalization;
+		mAlphabet = other.mAlphabet;
+		mIsAlphabetDetected = other.mIsAlphabetDetected;
+		mArena.reset(); // Copies share the bytes already loaded, but allocate from an arena of their own.
+		mSequenceGroups = other.mSequenceGroups;
+		mIdentifierSlots = other.mIdentifierSlots;
+		mGeneration = other.mGeneration;
+		mIdentifiersSet.clear();
+		mIdentifiersSetGeneration = mGeneration;
+		mSortedGroups.clear();
+		mSortedGroupsGeneration = mGeneration;
+	}
+
+	void _moveAssign(
+		FastaFile&& other )
+	{
+		mIsBareSequence = std::exchange( other.mIsBareSequence, false );
+		mDuplicateIdentifiersAllowed = std::exchange( other.mDuplicateIdentifiersAllowed, true );
+		mIsArenaStorageUsed = std::exchange( other.mIsArenaStorageUsed, false );
+		mNormalization = std::exchange( other.mNormalization, FastaSequence::Normalization::Eager );
+		mAlphabet = std::exchange( other.mAlphabet, FastaAlphabet::Type::Any );
+		mIsAlphabetDetected = std::exchange( other.mIsAlphabetDetected, false );
+		mArena = std::move( other.mArena );
+		mSequenceGroups = std::move( other.mSequenceGroups );
+		mIdentifierSlots = std::move( other.mIdentifierSlots );
+		mGeneration = other.mGeneration++;
+		mIdentifiersSet = std::move( other.mIdentifiersSet );
+		mIdentifiersSetGeneration = other.mIdentifiersSetGeneration;
+		mSortedGroups = std::move( other.mSortedGroups );
+		mSortedGroupsGeneration = other.mSortedGroupsGeneration;
+		other.mSequenceGroups.clear();
+		other.mIdentifierSlots.clear();
+		other.mIdentifiersSet.clear();
+		other.mSortedGroups.clear();
+	}
+
+	// Add the sequence to the group of its identifier.
+	void _addSequence(
+		FastaSequence&& sequence )
+	{
+		const size_t group = _insertGroup( sequence._identifierView() );
+		mSequenceGroups[ group ].push_back( std::move( sequence ) );
+	}
+
+	// Copy the identifier and sequence of the record into the arena, returning a sequence viewing them.
+	static FastaSequence _arenaSequence(
+		const std::shared_ptr< FastaArena >& arena,
+		const FastaSequence& record )
+	{
+		const FastaStringView identifier = record._identifierView();
+		const size_t length = record.length();
+		char* bytes = arena->allocate( identifier.length() + length );
+		FastaSequence sequence;
+
+		std::memcpy( bytes, identifier.data(), identifier.length() );
+		record.copy( bytes + identifier.length(), length );
+		sequence.mAlphabet = record.mAlphabet;
+		sequence._setExternalIdentifier( std::shared_ptr< const char >( arena, bytes ), identifier.length() );
+		sequence._setExternalSequence(
+			std::shared_ptr< const char >( arena, bytes + identifier.length() ), length, length, length );
+
+		return sequence;
+	}
+
+	// Set the reader to load records as configured, detecting the alphabet first if requested.
+	// The file is read ahead on an I/O thread, so that reading overlaps with parsing.
+	void _configureReader(
+		FastaReader& reader )
+	{
+		if ( mIsAlphabetDetected )
+		{
+			mAlphabet = reader.detectAlphabet();
+		}
+
+		reader.setAlphabet( mAlphabet );
+		reader.setNormalization( mNormalization );
+		reader.useReadAhead();
+	}
+
+	// Invoke function( group, worker ) for every group, spreading the groups across the threads;
+	// worker is the index of the thread, below _threadCount( threadCount ). Each group is visited
+	// by a single thread. The first exception thrown stops the remaining groups from being
+	// visited and is rethrown.
+	template < typename Function >
+	void _forEachGroup(
+		size_t threadCount,
+		Function function ) const
+	{
+		std::atomic< size_t > nextGroup( 0 );
+		std::vector< std::thread > threads;
+		std::exception_ptr exception;
+		std::mutex exceptionMutex;
+
+		threadCount = _threadCount( threadCount );
+
+		auto worker = [ & ]( size_t workerIndex )
+		{
+			for ( size_t group = nextGroup++; group < mSequenceGroups.size(); group = nextGroup++ )
+			{
+				try
+				{
+					function( group, workerIndex );
+				}
+				catch ( ... )
+				{
+					std::lock_guard< std::mutex > lock( exceptionMutex );
+					exception = exception ? exception : std::current_exception();
+					nextGroup = mSequenceGroups.size();
+				}
+			}
+		};
+
+		for ( size_t thread( 1 ); thread < std::min( threadCount, mSequenceGroups.size() ); ++thread )
+		{
+			threads.emplace_back( worker, thread );
+		}
+
+		worker( 0 );
+
+		for ( auto& thread : threads )
+		{
+			thread.join();
+		}
+
+		if ( exception )
+		{
+			std::rethrow_exception( exception );
+		}
+	}
+
+	// The number of threads to use: one per hardware thread if zero.
+	static size_t _threadCount(
+		size_t threadCount )
+	{
+		return ( 0 == threadCount ) ? std::max( std::thread::hardware_concurrency(), 1u ) : threadCount;
+	}
+
+	// Hash of the sequence characters, the same wherever the sequence is stored.
+	static uint64_t _contentHash(
+		const FastaSequence& sequence,
+		std::vector< char >& buffer )
+	{
+		const size_t chunkSize( 1 << 16 );
+		const size_t length = sequence.length();
+		uint64_t hash = length;
+
+		for ( size_t offset( 0 ); offset < length; offset += chunkSize )
+		{
+			const size_t count = std::min( length - offset, chunkSize );
+			const char* data( nullptr );
+
+			if ( sequence._isExternal() )
+			{
+				buffer.resize( chunkSize );
+				sequence.copy( &buffer[ 0 ], count, offset );
+				data = buffer.data();
+			}
+			else
+			{
+				data = sequence.mSequence.data() + offset;
+			}
+
+			hash = ( hash ^ FastaStringView( data, count ).hash() ) * 0x9E3779B97F4A7C15ull;
+			hash ^= hash >> 29;
+		}
+
+		return hash;
+	}
+
+	// Collect every sequence in container order, along with the offset of the first sequence
+	// holding the same characters as each. Sequences are hashed across the threads, and those
+	// with equal hashes are compared in full.
+	std::vector< size_t > _findDuplicateSequences(
+		std::vector< FastaSequence* >& sequences,
+		size_t threadCount )
+	{
+		std::vector< size_t > groupOffsets;
+
+		sequences.clear();
+
+		for ( auto& sequenceGroup : mSequenceGroups )
+		{
+			groupOffsets.push_back( sequences.size() );
+
+			for ( auto& sequence : sequenceGroup )
+			{
+				sequences.push_back( &sequence );
+			}
+		}
+
+		std::vector< std::pair< uint64_t, size_t > > hashes( sequences.size() );
+		std::vector< std::vector< char > > buffers( _threadCount( threadCount ) );
+
+		_forEachGroup( threadCount,
+			[ & ]( size_t group, size_t worker )
+			{
+				for ( size_t offset( groupOffsets[ group ] ); offset < groupOffsets[ group ] + mSequenceGroups[ group ].size(); ++offset )
+				{
+					hashes[ offset ] = std::make_pair( _contentHash( *sequences[ offset ], buffers[ worker ] ), offset );
+				}
+			} );
+
+		std::sort( hashes.begin(), hashes.end() );
+
+		std::vector< size_t > firstSequences( sequences.size() );
+
+		for ( size_t run( 0 ), runEnd( 0 ); run < hashes.size(); run = runEnd )
+		{
+			for ( runEnd = run; ( runEnd < hashes.size() ) and ( hashes[ runEnd ].first == hashes[ run ].first ); ++runEnd )
+			{
+				const size_t offset = hashes[ runEnd ].second;
+				size_t first( run );
+
+				// The offsets of a run ascend, so the first of equal sequences is met first.
+				while ( ( first < runEnd ) and ( ( firstSequences[ hashes[ first ].second ] != hashes[ first ].second )
+					or ( sequences[ hashes[ first ].second ]->length() != sequences[ offset ]->length() )
+					or ( 0 != sequences[ hashes[ first ].second ]->_compareSequence( *sequences[ offset ] ) ) ) )
+				{
+					++first;
+				}
+
+				firstSequences[ offset ] = ( first < runEnd ) ? hashes[ first ].second : offset;
+			}
+		}
+
+		return firstSequences;
+	}
+
+	// Find the group of the identifier. Returns npos if the identifier is not present.
+	size_t _findGroup(
+		FastaStringView identifier ) const
+	{
+		return mIdentifierSlots.empty() ?
+			std::string::npos : mIdentifierSlots[ _findSlot( identifier, identifier.hash() ) ].group;
+	}
+
+	// Check whether the text matches the glob pattern, where '*' matches any run of characters and '?' any one.
+	static bool _isGlobMatch(
+		FastaStringView text,
+		FastaStringView pattern )
+	{
+		size_t textOffset( 0 );
+		size_t patternOffset( 0 );
+		size_t starPattern( std::string::npos ); // Offset after the last '*' seen.
+		size_t starText( 0 );                    // Offset of the text matched by that '*' so far.
+
+		while ( textOffset < text.length() )
+		{
+			if ( ( patternOffset < pattern.length() ) and ( '*' == pattern[ patternOffset ] ) )
+			{
+				starPattern = ++patternOffset;
+				starText = textOffset;
+			}
+			else if ( ( patternOffset < pattern.length() )
+				and ( ( '?' == pattern[ patternOffset ] ) or ( text[ textOffset ] == pattern[ patternOffset ] ) ) )
+			{
+				++patternOffset;
+				++textOffset;
+			}
+			else if ( std::string::npos != starPattern )
+			{
+				// Let the last '*' take one more character and retry from after it.
+				patternOffset = starPattern;
+				textOffset = ++starText;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		while ( ( patternOffset < pattern.length() ) and ( '*' == pattern[ patternOffset ] ) )
+		{
+			++patternOffset;
+		}
+
+		return patternOffset == pattern.length();
+	}
+
+	// The range of mSortedGroups whose identifiers start with the prefix, sorting the groups first if needed.
+	std::pair< size_t, size_t > _prefixRange(
+		FastaStringView prefix ) const
+	{
+		// An index built before groups were removed or replaced is rebuilt. Otherwise groups have
+		// only been appended since, so those missing are the ones past its size; they are sorted
+		// and merged in.
+		if ( mSortedGroupsGeneration != mGeneration )
+		{
+			mSortedGroups.clear();
+			mSortedGroupsGeneration = mGeneration;
+		}
+
+		if ( mSortedGroups.size() != mSequenceGroups.size() )
+		{
+			const size_t sortedCount = mSortedGroups.size();
+			auto isBefore = [ this ]( size_t lhs, size_t rhs )
+			{
+				return mSequenceGroups[ lhs ].front()._identifierView() < mSequenceGroups[ rhs ].front()._identifierView();
+			};
+
+			for ( size_t group( sortedCount ); group < mSequenceGroups.size(); ++group )
+			{
+				mSortedGroups.push_back( group );
+			}
+
+			std::sort( mSortedGroups.begin() + sortedCount, mSortedGroups.end(), isBefore );
+			std::inplace_merge( mSortedGroups.begin(), mSortedGroups.begin() + sortedCount, mSortedGroups.end(), isBefore );
+		}
+
+		auto identifierPrefix = [ & ]( size_t group )
+		{
+			const FastaStringView identifier = mSequenceGroups[ group ].front()._identifierView();
+
+			return identifier.view( 0, prefix.length() );
+		};
+
+		const auto first = std::lower_bound( mSortedGroups.begin(), mSortedGroups.end(), prefix,
+			[ & ]( size_t group, FastaStringView value )
+			{
+				return identifierPrefix( group ) < value;
+			} );
+		const auto last = std::upper_bound( first, mSortedGroups.end(), prefix,
+			[ & ]( FastaStringView value, size_t group )
+			{
+				return value < identifierPrefix( group );
+			} );
+
+		return std::make_pair( first - mSortedGroups.begin(), last - mSortedGroups.begin() );
+	}
+
+	// Probe for the slot holding the identifier, or the empty slot ending its probe sequence.
+	size_t _findSlot(
+		FastaStringView identifier,
+		size_t hash ) const
+	{
+		const size_t mask = mIdentifierSlots.size() - 1;
+
+		for ( size_t slot = hash & mask; ; slot = ( slot + 1 ) & mask )
+		{
+			const IdentifierSlot& identifierSlot = mIdentifierSlots[ slot ];
+
+			if ( ( std::string::npos == identifierSlot.group ) or ( ( hash == identifierSlot.hash ) and
+				( identifier == mSequenceGroups[ identifierSlot.group ].front()._identifierView() ) ) )
+			{
+				return slot;
+			}
+		}
+	}
+
+	// Find the group of the identifier, appending an empty group if it is not present.
+	size_t _insertGroup(
+		FastaStringView identifier )
+	{
+		// Keep the load factor at or below one half.
+		if ( 2 * ( mSequenceGroups.size() + 1 ) > mIdentifierSlots.size() )
+		{
+			_rehash( std::max( 2 * mIdentifierSlots.size(), static_cast< size_t >( 16 ) ) );
+		}
+
+		const size_t hash = identifier.hash();
+		IdentifierSlot& identifierSlot = mIdentifierSlots[ _findSlot( identifier, hash ) ];
+
+		if ( std::string::npos == identifierSlot.group )
+		{
+			identifierSlot.hash = hash;
+			identifierSlot.group = mSequenceGroups.size();
+			mSequenceGroups.emplace_back();
+		}
+
+		return identifierSlot.group;
+	}
+
+	// Build the index afresh from the identifiers of the groups.
+	void _reindex()
+	{
+		size_t slotCount( 16 );
+
+		while ( slotCount < 2 * mSequenceGroups.size() )
+		{
+			slotCount *= 2;
+		}
+
+		mIdentifierSlots.assign( slotCount, IdentifierSlot{ 0, std::string::npos } );
+
+		for ( size_t group( 0 ); group < mSequenceGroups.size(); ++group )
+		{
+			const FastaStringView identifier = mSequenceGroups[ group ].front()._identifierView();
+			const size_t hash = identifier.hash();
+
+			mIdentifierSlots[ _findSlot( identifier, hash ) ] = IdentifierSlot{ hash, group };
+		}
+	}
+
+	// Rebuild the index with the given number of slots, a power of two.
+	void _rehash(
+		size_t slotCount )
+	{
+		std::vector< IdentifierSlot > identifierSlots( slotCount, IdentifierSlot{ 0, std::string::npos } );
+		const size_t mask = slotCount - 1;
+
+		for ( const auto& identifierSlot : mIdentifierSlots )
+		{
+			if ( std::string::npos != identifierSlot.group )
+			{
+				size_t slot = identifierSlot.hash & mask;
+
+				while ( std::string::npos != identifierSlots[ slot ].group )
+				{
+					slot = ( slot + 1 ) & mask;
+				}
+
+				identifierSlots[ slot ] = identifierSlot;
+			}
+		}
+
+		mIdentifierSlots.swap( identifierSlots );
+	}
+
+	// Assign the sequence lines between begin and end to the sequence. If every line holds the
+	// same number of valid sequence characters (the last line may be shorter), then the sequence
+	// becomes a view into the mapping; otherwise the lines are copied and normalized.
+	static void _mapSequence(
+		FastaSequence& sequence,
+		const std::shared_ptr< const FastaMappedFile >& mappedFile,
+		const char* begin,
+		const char* end,
+		FastaSequence::Normalization normalization )
+	{
+		size_t length, lineBases, lineWidth;
+
+		if ( FastaIndex::_scanLayout( begin, end, true, length, lineBases, lineWidth, sequence.mAlphabet ) )
+		{
+			sequence._setExternalSequence(
+				std::shared_ptr< const char >( mappedFile, begin ), length, lineBases, lineWidth );
+		}
+		else
+		{
+			sequence.setSequence( std::string( begin, end ), normalization );
+		}
+	}
+
+	// Append the low byteCount bytes of the value, little endian.
+	static void _appendLittleEndian(
+		std::string& bytes,
+		uint64_t value,
+		size_t byteCount = 8 )
+	{
+		for ( ; 0 < byteCount; --byteCount, value >>= 8 )
+		{
+			bytes.push_back( static_cast< char >( value & 0xFF ) );
+		}
+	}
+
+	// Hash of a fixed identifier, which tells whether a snapshot index was hashed as this build hashes.
+	static uint64_t _snapshotHashCheck()
+	{
+		return FastaStringView( "FastaFile snapshot" ).hash();
+	}
+
+	// FNV-1a hash of the identifier a byte at a time, which is the same on every platform,
+	// so that Identifier sharding assigns an identifier to the same file everywhere.
+	static uint64_t _shardHash(
+		FastaStringView identifier )
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+
+		for ( const char character : identifier )
+		{
+			hash = ( hash ^ static_cast< uint8_t >( character ) ) * 0x100000001B3ull;
+		}
+
+		return hash;
+	}
+
+	// Round a snapshot offset up to a multiple of eight.
+	static size_t _snapshotAlign(
+		size_t offset )
+	{
+		return ( offset + 7 ) & ~static_cast< size_t >( 7 );
+	}
+
+	// True if [offset, offset + length) lies within a snapshot of the given size.
+	static bool _isInSnapshot(
+		uint64_t offset,
+		uint64_t length,
+		size_t size )
+	{
+		return ( length <= size ) and ( offset <= size - length );
+	}
+
+	// Restore a packed sequence from a snapshot, returning nullptr if its layout is invalid.
+	static std::shared_ptr< const FastaPackedSequence > _loadPackedSequence(
+		const char* data,
+		size_t size,
+		uint64_t offset,
+		uint64_t length,
+		FastaPackedSequence::Encoding encoding )
+	{
+		if ( not _isInSnapshot( offset, SnapshotPackedSize, size ) )
+		{
+			return nullptr;
+		}
+
+		const char* blob = data + offset;
+		const uint64_t byteCount = FastaCompression::readLittleEndian( blob, 8 );
+		const uint64_t nRunCount = FastaCompression::readLittleEndian( blob + 8, 8 );
+		const uint64_t lowerCaseRunCount = FastaCompression::readLittleEndian( blob + 16, 8 );
+		const uint64_t runsOffset = _snapshotAlign( offset + SnapshotPackedSize + byteCount );
+		const uint64_t expectedByteCount = ( FastaPackedSequence::Encoding::TwoBit == encoding ) ? ( length + 3 ) / 4 : ( length + 1 ) / 2;
+
+		if ( ( expectedByteCount != byteCount ) or ( size / SnapshotSlotSize < nRunCount ) or ( size / SnapshotSlotSize < lowerCaseRunCount ) or
+			not _isInSnapshot( offset + SnapshotPackedSize, byteCount, size ) or
+			not _isInSnapshot( runsOffset, ( nRunCount + lowerCaseRunCount ) * SnapshotSlotSize, size ) )
+		{
+			return nullptr;
+		}
+
+		auto packedSequence = std::make_shared< FastaPackedSequence >();
+		const char* runs = data + runsOffset;
+
+		packedSequence->mEncoding = encoding;
+		packedSequence->mLength = static_cast< size_t >( length );
+		packedSequence->mBytes.assign( blob + SnapshotPackedSize, blob + SnapshotPackedSize + byteCount );
+
+		for ( uint64_t run( 0 ); run < nRunCount + lowerCaseRunCount; ++run, runs += SnapshotSlotSize )
+		{
+			std::vector< FastaPackedSequence::Run >& list = ( run < nRunCount ) ? packedSequence->mNRuns : packedSequence->mLowerCaseRuns;
+			const uint64_t begin = FastaCompression::readLittleEndian( runs, 8 );
+			const uint64_t runLength = FastaCompression::readLittleEndian( runs + 8, 8 );
+
+			// Runs must be ordered and within the sequence, as lookups bisect them.
+			if ( ( length < runLength ) or ( length - runLength < begin ) or
+				( ( not list.empty() ) and ( begin < list.back().begin + list.back().length ) ) )
+			{
+				return nullptr;
+			}
+
+			list.push_back( FastaPackedSequence::Run{ static_cast< size_t >( begin ), static_cast< size_t >( runLength ) } );
+		}
+
+		return packedSequence;
+	}
+
+	// Read in a FastA file, with the given number of threads and gathering statistics if not nullptr.
+	int _readFile(
+		const std::string& filename,
+		bool allowDuplicates,
+		size_t threadCount,
+		FastaStatistics* statistics )
+	{
+		if ( 0 == threadCount )
+		{
+			threadCount = std::max( std::thread::hardware_concurrency(), 1u );
+		}
+
+		if ( 1 == threadCount )
+		{
+			FastaReader reader;
+			int errorCode = reader.open( filename );
+
+			if ( 0 != errorCode )
+			{
+				return errorCode;
+			}
+
+			_configureReader( reader );
+
+			return _readRecords( reader, allowDuplicates, statistics );
+		}
+
+		const double mapStart = ( nullptr == statistics ) ? 0 : FastaStatistics::now();
+		FastaMappedFile mappedFile;
+		int errorCode = mappedFile.open( filename );
+
+		if ( 0 != errorCode )
+		{
+			return errorCode;
+		}
+
+		// Compressed input is inflated across the threads and parsed as it streams in.
+		if ( FastaCompression::Format::None != FastaCompression::detect( mappedFile.data(), mappedFile.size() ) )
+		{
+			FastaReader reader;
+
+			mappedFile.close();
+			errorCode = reader.open( filename, threadCount );
+
+			if ( 0 != errorCode )
+			{
+				return errorCode;
+			}
+
+			_configureReader( reader );
+
+			return _readRecords( reader, allowDuplicates, statistics );
+		}
+
+		if ( mIsAlphabetDetected )
+		{
+			mAlphabet = FastaAlphabet::detect( mappedFile.data(),
+				std::min( mappedFile.size(), static_cast< size_t >( FastaAlphabet::DetectionLength ) ) );
+		}
+
+		// Times are taken only if statistics are gathered.
+		auto clock = [ statistics ]()
+		{
+			return ( nullptr == statistics ) ? 0 : FastaStatistics::now();
+		};
+
+		struct RangeStatistics
+		{
+			double ioSeconds;
+			double normalizeSeconds;
+			double insertSeconds;
+			size_t charactersRemoved;
+			FastaComposition composition;
+			std::vector< FastaRecordStatistics > recordStatistics;
+		};
+
+		const bool isCompositionGathered = ( nullptr != statistics ) and statistics->isCompositionGathered;
+
+		// Several ranges per thread balance the load across uneven records.
+		const char* const begin = mappedFile.data();
+		const char* const end = begin + mappedFile.size();
+		const size_t rangeCount = std::max( std::min( threadCount * 4, mappedFile.size() ), static_cast< size_t >( 1 ) );
+		std::vector< const char* > rangeBegins( rangeCount + 1, end );
+		std::vector< std::vector< FastaSequence > > rangeSequences( rangeCount );
+		std::vector< RangeStatistics > rangeStatistics( rangeCount, RangeStatistics() );
+		const std::thread::id callingThread = std::this_thread::get_id();
+		std::atomic< size_t > completedBytes( 0 );
+		std::atomic< size_t > completedRecords( 0 );
+		std::atomic< size_t > nextRange( 0 );
+		std::atomic< int > workerErrorCode( 0 );
+
+		if ( nullptr != statistics )
+		{
+			statistics->ioSeconds += clock() - mapStart;
+		}
+
+		for ( size_t range( 0 ); range < rangeCount; ++range )
+		{
+			const char* rangeBegin = begin + ( mappedFile.size() / rangeCount ) * range;
+
+			if ( ( begin < rangeBegin ) and ( '\n' != rangeBegin[ -1 ] ) )
+			{
+				const void* newline = std::memchr( rangeBegin, '\n', end - rangeBegin );
+				rangeBegin = ( nullptr == newline ) ? end : static_cast< const char* >( newline ) + 1;
+			}
+
+			rangeBegins[ range ] = rangeBegin;
+		}
+
+		// Each range loads into an arena of its own, so the workers never share one. Copying the
+		// record out of the mapping is counted as I/O, since that is where its pages are read in.
+		auto worker = [ & ]()
+		{
+			for ( size_t range = nextRange++; range < rangeCount; range = nextRange++ )
+			{
+				try
+				{
+					std::shared_ptr< FastaArena > arena( mIsArenaStorageUsed ? new FastaArena : nullptr );
+					RangeStatistics& counts = rangeStatistics[ range ];
+					FastaSequence record;
+
+					FastaIndex::_forEachRecord( rangeBegins[ range ], rangeBegins[ range + 1 ], end,
+						[ & ]( const char* header, const char* sequenceBegin, const char* sequenceEnd )
+						{
+							const double copyStart = clock();
+
+							record.mIdentifier.assign( header, sequenceBegin );
+							record.mSequence.assign( sequenceBegin, sequenceEnd );
+
+							const double normalizeStart = clock();
+
+							record.mAlphabet = mAlphabet;
+							record._normalizeIdentifier();
+							record._normalizeSequence( mNormalization );
+
+							if ( isCompositionGathered )
+							{
+								FastaStatistics::_gatherComposition( counts.composition, counts.recordStatistics,
+									record._identifierView(), record.mSequence.data(), record.mSequence.length() );
+							}
+
+							const double insertStart = clock();
+
+							counts.charactersRemoved += static_cast< size_t >( sequenceEnd - sequenceBegin ) - record.mSequence.length();
+							rangeSequences[ range ].push_back( arena ? _arenaSequence( arena, record ) : std::move( record ) );
+
+							const double insertEnd = clock();
+
+							counts.ioSeconds += normalizeStart - copyStart;
+							counts.normalizeSeconds += insertStart - normalizeStart;
+							counts.insertSeconds += insertEnd - insertStart;
+						} );
+				}
+				catch ( const std::bad_alloc& )
+				{
+					workerErrorCode = ENOMEM;
+				}
+
+				completedBytes += rangeBegins[ range + 1 ] - rangeBegins[ range ];
+				completedRecords += rangeSequences[ range ].size();
+
+				// Progress is reported from the calling thread only, so the callback needs no locking.
+				if ( ( nullptr != statistics ) and ( callingThread == std::this_thread::get_id() ) )
+				{
+					statistics->bytes = completedBytes;
+					statistics->records = completedRecords;
+					statistics->_progress();
+				}
+			}
+		};
+
+		std::vector< std::thread > threads;
+
+		for ( size_t thread( 1 ); thread < threadCount; ++thread )
+		{
+			threads.emplace_back( worker );
+		}
+
+		worker();
+
+		for ( auto& thread : threads )
+		{
+			thread.join();
+		}
+
+		if ( 0 != workerErrorCode )
+		{
+			return workerErrorCode;
+		}
+
+		const double mergeStart = clock();
+		size_t duplicatesDropped( 0 );
+
+		for ( auto& sequences : rangeSequences )
+		{
+			for ( auto& sequence : sequences )
+			{
+				if ( 0 == sequence._identifierView().length() )
+				{
+					continue;
+				}
+
+				if ( allowDuplicates or ( std::string::npos == _findGroup( sequence._identifierView() ) ) )
+				{
+					_addSequence( std::move( sequence ) );
+				}
+				else
+				{
+					++duplicatesDropped;
+				}
+			}
+
+			std::vector< FastaSequence >().swap( sequences );
+		}
+
+		this->allowDuplicateIdentifiers( allowDuplicates );
+
+		if ( nullptr != statistics )
+		{
+			statistics->bytes = completedBytes;
+			statistics->records = completedRecords;
+			statistics->duplicatesDropped += duplicatesDropped;
+			statistics->insertSeconds += clock() - mergeStart;
+
+			for ( auto& counts : rangeStatistics )
+			{
+				statistics->ioSeconds += counts.ioSeconds;
+				statistics->normalizeSeconds += counts.normalizeSeconds;
+				statistics->insertSeconds += counts.insertSeconds;
+				statistics->charactersRemoved += counts.charactersRemoved;
+				statistics->composition.add( counts.composition );
+				statistics->recordStatistics.insert( statistics->recordStatistics.end(),
+					std::make_move_iterator( counts.recordStatistics.begin() ), std::make_move_iterator( counts.recordStatistics.end() ) );
+			}
+
+			statistics->elapsedSeconds = clock() - statistics->mStartTime;
+		}
+
+		return 0;
+	}
+
+	// Add every record of the reader to the container, gathering statistics if not nullptr. If duplicates
+	// are not allowed, a record whose identifier is already present is dropped before it is stored.
+	int _readRecords(
+		FastaReader& reader,
+		bool allowDuplicates,
+		FastaStatistics* statistics )
+	{
+		FastaSequence sequence;
+
+		if ( mIsArenaStorageUsed and not mArena )
+		{
+			mArena = std::make_shared< FastaArena >();
+		}
+
+		reader.setStatistics( statistics );
+
+		while ( reader.read( sequence ) )
+		{
+			const double insertStart = ( nullptr == statistics ) ? 0 : FastaStatistics::now();
+
+			if ( 0 == sequence._identifierView().length() )
+			{
+				continue;
+			}
+
+			if ( allowDuplicates or ( std::string::npos == _findGroup( sequence._identifierView() ) ) )
+			{
+				// The arena copy leaves the buffers of the sequence to be reused by the next record.
+				_addSequence( mIsArenaStorageUsed ? _arenaSequence( mArena, sequence ) : std::move( sequence ) );
+			}
+			else if ( nullptr != statistics )
+			{
+				++statistics->duplicatesDropped;
+			}
+
+			if ( nullptr != statistics )
+			{
+				statistics->insertSeconds += FastaStatistics::now() - insertStart;
+			}
+		}
+
+		reader.setStatistics( nullptr );
+		this->allowDuplicateIdentifiers( allowDuplicates );
+
+		if ( nullptr != statistics )
+		{
+			statistics->elapsedSeconds = FastaStatistics::now() - statistics->mStartTime;
+		}
+
+		return reader.error();
+	}
+
+	// Write the contents of the container out to file, gathering statistics if not nullptr.
+	int _writeFile(
+		const std::string& filename,
+		size_t lineLength,
+		FastaStatistics* statistics ) const
+	{
+		FastaWriter writer( nullptr, lineLength );
+		int errorCode = writer.open( filename );
+
+		if ( 0 != errorCode )
+		{
+			return errorCode;
+		}
+
+		writer.setStatistics( statistics );
+
+		for ( const auto& sequenceGroup : mSequenceGroups )
+		{
+			for ( const auto& sequence : sequenceGroup )
+			{
+				writer.write( sequence );
+			}
+		}
+
+		errorCode = writer.close();
+
+		if ( nullptr != statistics )
+		{
+			statistics->elapsedSeconds = FastaStatistics::now() - statistics->mStartTime;
+		}
+
+		return errorCode;
+	}
+
+	// Write the records to the file in order, and the .fai of the file if requested.
+	static int _writeShard(
+		const std::string& filename,
+		const std::vector< const FastaSequence* >& sequences,
+		size_t lineLength,
+		bool writeIndex )
+	{
+		FastaWriter writer( nullptr, lineLength );
+		FastaIndex index;
+		int errorCode = writer.open( filename );
+
+		if ( 0 != errorCode )
+		{
+			return errorCode;
+		}
+
+		for ( const FastaSequence* sequence : sequences )
+		{
+			if ( writeIndex )
+			{
+				FastaIndex::Entry entry;
+				const size_t length = sequence->length();
+
+				entry.name = std::string( sequence->id() );
+				entry.length = length;
+				entry.offset = writer.offset() + sequence->_identifierView().length() + 2;
+				entry.lineBases = ( 0 == lineLength ) ? length : std::min( lineLength, length );
+				entry.lineWidth = ( 0 == length ) ? 0 : entry.lineBases + 1;
+				index._addEntry( std::move( entry ) );
+			}
+
+			writer.write( *sequence );
+		}
+
+		errorCode = writer.close();
+
+		return ( ( 0 == errorCode ) and writeIndex ) ? index.writeFile( filename + ".fai" ) : errorCode;
+	}
+
+public:
+	/**
+	 * Class for iterating over the container and possibly mutating elements.
+	 */
+	class iterator
+	{
+	private:
+		friend class FastaFile;
+
+		bool mIsValid;
+		SequenceGroupsType::iterator mGroupIterator;
+		size_t mVectorOffset;
+
+		iterator(
+			SequenceGroupsType::iterator groupIterator )
+		{
+			mIsValid = true;
+			mGroupIterator = groupIterator;
+			mVectorOffset = 0;
+		}
+
+		void _copyAssign(
+			const iterator& other )
+		{
+			mIsValid = other.mIsValid;
+			mGroupIterator = other.mGroupIterator;
+			mVectorOffset = other.mVectorOffset;
+		}
+
+		void _moveAssign(
+			iterator&& other )
+		{
+			mIsValid = std::exchange( other.mIsValid, false );
+			mGroupIterator = std::move( other.mGroupIterator );
+			mVectorOffset = std::exchange( other.mVectorOffset, 0 );
+		}
+
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using difference_type   = std::ptrdiff_t;
+		using value_type        = FastaSequence;
+		using pointer           = FastaSequence*;
+		using reference         = FastaSequence&;
+
+		/**
+		 * Default constructor to an empty iterator.
+		 */
+		iterator()
+		{
+			mIsValid = false;
+			mVectorOffset = 0;
+		}
+
+		/**
+		 * Copy constructor.
+		 * @param other Const reference to iterator to copy to this instance.
+		 */
+		iterator(
+			const iterator& other )
+		{
+			_copyAssign( other );
+		}
+
+		/**
+		 * Move constructor.
+		 * @param other R-Value to iterator to move to this instance.
+		 */
+		iterator(
+			iterator&& other )
+		{
+			_moveAssign( std::move( other ) );
+		}
+
+		/**
+		 * Copy assignment operator.
+		 * @param other Const reference to iterator to copy to this instance.
+		 * @return Reference to this iterator instance is returned.
+		 */
+		iterator& operator=(
+			const iterator& other )
+		{
+			if ( this != &other )
+			{
+				_copyAssign( other );
+			}
+
+			return *this;
+		}
+
+		/**
+		 * Move assignment operator.
+		 * @param other R-Value to iterator to move to this instance.
+		 * @return Reference to this iterator instance is returned.
+		 */
+		iterator operator=(
+			iterator&& other )
+		{
+			if ( this != &other )
+			{
+				_moveAssign( std::move( other ) );
+			}
+
+			return *this;
+		}
+
+		/**
+		 * Compare iterators for equality.
+		 * @param other Const reference to the iterator to compare against for equality.
+		 * @return True is returned if this and other are equal.
+		 */
+		bool operator==(
+			const iterator& other )
+		{
+			return mIsValid
+				and ( mIsValid == other.mIsValid )
+				and ( mGroupIterator == other.mGroupIterator )
+				and ( mVectorOffset == other.mVectorOffset );
+		}
+
+		/**
+		 * Compare iterators for inequality.
+		 * @param other Const reference to the iterator to compare against for inequality.
+		 * @return True is returned if this and other are not equal.
+		 */
+		bool operator!=(
+			const iterator& other )
+		{
+			return not this->operator==( other );
+		}
+
+		/**
+		 * Pointer access to the FastaSequence.
+		 * @return A pointer to the underlying FastaSequence object.
+		 */
+		pointer operator->()
+		{
+			if ( mIsValid )
+			{
+				return &( *mGroupIterator )[ mVectorOffset ];
+			}
+
+			return static_cast< pointer >( nullptr );
+		}
+
+		/**
+		 * Reference acess to the FastaSequence.
+		 * @return A reference to the underlying FastaSequence object.
+		 */
+		reference operator*()
+		{
+			if ( mIsValid )
+			{
+				return ( *mGroupIterator )[ mVectorOffset ];
+			}
+
+			return *static_cast< pointer >( nullptr );
+		}
+
+		/**
+		 * Post-increment operator.
+		 * @return Return the iterator prior to incrementing.
+		 */
+		iterator operator++( int )
+		{
+			iterator prior( *this );
+			this->operator++();
+			return prior;
+		}
+
+		/**
+		 * Pre-increment operator.
+		 * @return Reference to this iterator instance is returned.
+		 */
+		iterator& operator++()
+		{
+			if ( mIsValid and ( ++mVectorOffset == mGroupIterator->size() ) )
+			{
+				++mGroupIterator;
+				mVectorOffset = 0;
+			}
+
+			return *this;
+		}
+
+		/**
+		 * Swap the contents of this iterator with other.
+		 * @param other Reference to the iterator instance to swap values with.
+		 */
+		void swap(
+			iterator& other )
+		{
+			std::swap( mIsValid, other.mIsValid );
+			std::swap( mGroupIterator, other.mGroupIterator );
+			std::swap( mVectorOffset, other.mVectorOffset );
+		}
+	};
+
+	/**
+	 * Class for iterating over the container in an immutable manner.
+	 */
+	class const_iterator
+	{
+	private:
+		friend class FastaFile;
+
+		bool mIsValid;
+		SequenceGroupsType::const_iterator mConstGroupIterator;
+		size_t mVectorOffset;
+
+		const_iterator(
+			SequenceGroupsType::const_iterator constGroupIterator )
+		{
+			mIsValid = true;
+			mConstGroupIterator = constGroupIterator;
+			mVectorOffset = 0;
+		}
+
+		void _copyAssign(
+			const const_iterator& other )
+		{
+			mIsValid = other.mIsValid;
+			mConstGroupIterator = other.mConstGroupIterator;
+			mVectorOffset = other.mVectorOffset;
+		}
+
+		void _moveAssign(
+			const_iterator&& other )
+		{
+			mIsValid = std::exchange( other.mIsValid, false );
+			mConstGroupIterator = std::move( other.mConstGroupIterator );
+			mVectorOffset = std::exchange( other.mVectorOffset, 0 );
+		}
+
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using difference_type   = std::ptrdiff_t;
+		using value_type        = FastaSequence;
+		using pointer           = const FastaSequence*;
+		using reference         = const FastaSequence&;
+
+		/**
+		 * Default constructor to an empty const_iterator.
+		 */
+		const_iterator()
+		{
+			mIsValid = false;
+			mVectorOffset = 0;
+		}
+
+		/**
+		 * Copy constructor.
+		 * @param other Const reference to const_iterator to copy to this instance.
+		 */
+		const_iterator(
+			const const_iterator& other )
+		{
+			_copyAssign( other );
+		}
+
+		/**
+		 * Move constructor.
+		 * @param other R-Value to const_iterator to move to this instance.
+		 */
+		const_iterator(
+			const_iterator&& other )
+		{
+			_moveAssign( std::move( other ) );
+		}
+
+		/**
+		 * Copy assignment operator.
+		 * @param other Const reference to const_iterator to copy to this instance.
+		 * @return Reference to this const_iterator instance is returned.
+		 */
+		const_iterator& operator=(
+			const const_iterator& other )
+		{
+			if ( this != &other )
+			{
+				_copyAssign( other );
+			}
+
+			return *this;
+		}
+
+		/**
+		 * Move assignment operator.
+		 * @param other R-Value to const_iterator to move to this instance.
+		 * @return Reference to this const_iterator instance is returned.
+		 */
+		const_iterator& operator=(
+			const_iterator&& other )
+		{
+			if ( this != &other )
+			{
+				_moveAssign( std::move( other ) );
+			}
+
+			return *this;
+		}
+
+		/**
+		 * Compare const_iterators for equality.
+		 * @param other Const reference to the const_iterator to compare against for equality.
+		 * @return True is returned if this and other are equal.
+		 */
+		bool operator==(
+			const const_iterator& other )
+		{
+			return mIsValid
+				and ( mIsValid == other.mIsValid )
+				and ( mConstGroupIterator == other.mConstGroupIterator )
+				and ( mVectorOffset == other.mVectorOffset );
+		}
+
+		/**
+		 * Compare const_iterators for inequality.
+		 * @param other Const reference to the const_iterator to compare against for inequality.
+		 * @return True is returned if this and other are not equal.
+		 */
+		bool operator!=(
+			const const_iterator& other )
+		{
+			return not this->operator==( other );
+		}
+
+		/**
+		 * Const pointer access to the FastaSequence.
+		 * @return A const pointer to the underlying FastaSequence object.
+		 */
+		pointer operator->()
+		{
+			if ( mIsValid )
+			{
+				return &( *mConstGroupIterator )[ mVectorOffset ];
+			}
+
+			return static_cast< pointer >( nullptr );
+		}
+
+		/**
+		 * Const reference acess to the FastaSequence.
+		 * @return A const reference to the underlying FastaSequence object.
+		 */
+		reference operator*()
+		{
+			if ( mIsValid )
+			{
+				return ( *mConstGroupIterator )[ mVectorOffset ];
+			}
+
+			return *static_cast< pointer >( nullptr );
+		}
+
+		/**
+		 * Post-increment operator.
+		 * @return Return the const_iterator prior to incrementing.
+		 */
+		const_iterator operator++( int )
+		{
+			const_iterator prior( *this );
+			this->operator++();
+			return prior;
+		}
+
+		/**
+		 * Pre-increment operator.
+		 * @return Reference to this const_iterator instance is returned.
+		 */
+		const_iterator& operator++()
+		{
+			if ( mIsValid and ( ++mVectorOffset == mConstGroupIterator->size() ) )
+			{
+				++mConstGroupIterator;
+				mVectorOffset = 0;
+			}
+
+			return *this;
+		}
+
+		/**
+		 * Swap the contents of this const_iterator with other.
+		 * @param other Reference to the const_iterator instance to swap values with.
+		 */
+		void swap(
+			const_iterator& other )
+		{
+			std::swap( mIsValid, other.mIsValid );
+			std::swap( mConstGroupIterator, other.mConstGroupIterator );
+			std::swap( mVectorOffset, other.mVectorOffset );
+		}
+	};
+
+	/**
+	 * Default constructor.
+	 * @param filename The name of the file to load into this instance. [default: ""]
+	 * @param allowDuplicates Flag to allow or disallow duplicate identifiers. [default: true]
+	 */
+	FastaFile(
+		const std::string& filename = std::string(),
+		bool allowDuplicates = true )
+	{
+		mIsBareSequence = false;
+		mIsArenaStorageUsed = false;
+		mNormalization = FastaSequence::Normalization::Eager;
+		mAlphabet = FastaAlphabet::Type::Any;
+		mIsAlphabetDetected = false;
+		mGeneration = 0;
+		mIdentifiersSetGeneration = 0;
+		mSortedGroupsGeneration = 0;
+
+		if ( filename.empty() )
+		{
+			mDuplicateIdentifiersAllowed = allowDuplicates;
+		}
+		else
+		{
+			this->readFile( filename, allowDuplicates );
+		}
+	}
+
+	/**
+	 * Copy constructor.
+	 * @param other Const reference to the FastaFile to copy to this instance.
+	 */
+	FastaFile(
+		const FastaFile& other )
+	{
+		_copyAssign( other );
+	}
+
+	/**
+	 * Move constructor.
+	 * @param other R-Value to the FastaFile to move to this instance.
+	 */
+	FastaFile(
+		FastaFile&& other )
+	{
+		_moveAssign( std::move( other ) );
+	}
+
+	/**
+	 * Add the sequence to the container.
+	 * @param Const reference to the sequence to add to the container.
+	 * @return If duplicates are allowed, then this will always return 1.
+	 *         If duplicates are not allowed, then 1 will only be returned if the
+	 *         identifier for the sequence is not already taken.
+	 */
+	size_t addSequence(
+		const FastaSequence& sequence )
+	{
+		if ( not mDuplicateIdentifiersAllowed and ( std::string::npos != _findGroup( sequence._identifierView() ) ) )
+		{
+			return 0;
+		}
+
+		_addSequence( FastaSequence( sequence ) );
+
+		return 1;
+	}
+
+	/**
+	 * Add the sequence to the container, moving it in without copying its buffers.
+	 * @param R-Value to the sequence to add to the container.
+	 * @return If duplicates are allowed, then this will always return 1.
+	 *         If duplicates are not allowed, then 1 will only be returned if the
+	 *         identifier for the sequence is not already taken.
+	 */
+	size_t addSequence(
+		FastaSequence&& sequence )
+	{
+		if ( not mDuplicateIdentifiersAllowed and ( std::string::npos != _findGroup( sequence._identifierView() ) ) )
+		{
+			return 0;
+		}
+
+		_addSequence( std::move( sequence ) );
+
+		return 1;
+	}
+
+	/**
+	 * Add a vector of sequences to the container.
+	 * @param Const reference to the vector of sequences to add to the container.
+	 * @return The number of sequences from the vector added to the container from the
+	 *         vector is returned. If duplicates are not allowed, then the number returned
+	 *         may be less than the size of the vector.
+	 */
+	size_t addSequences(
+		const std::vector< FastaSequence >& sequences )
+	{
+		size_t numberAdded( 0 );
+
+		for ( const auto& sequence : sequences )
+		{
+			numberAdded += this->addSequence( sequence );
+		}
+
+		return numberAdded;
+	}
+
+	/**
+	 * Add a vector of sequences to the container, moving them in without copying their
+	 * buffers. The vector is left empty.
+	 * @param R-Value to the vector of sequences to add to the container.
+	 * @return The number of sequences from the vector added to the container from the
+	 *         vector is returned. If duplicates are not allowed, then the number returned
+	 *         may be less than the size of the vector.
+	 */
+	size_t addSequences(
+		std::vector< FastaSequence >&& sequences )
+	{
+		size_t numberAdded( 0 );
+
+		for ( auto& sequence : sequences )
+		{
+			numberAdded += this->addSequence( std::move( sequence ) );
+		}
+
+		sequences.clear();
+
+		return numberAdded;
+	}
+
+	/**
+	 * Flag that the container is or is not allowed duplicate identifiers.
+	 * By default, the container allows duplicate identifiers. Should false be
+	 * passed into this method, then a scan is performed to removed any
+	 * sequences that map to a shared identifier excluding the first added to this container.
+	 * @param allow Flag whether or not duplicate identifiers are allowed.
+	 */
+	void allowDuplicateIdentifiers(
+		bool allow = true )
+	{
+		mDuplicateIdentifiersAllowed = allow;
+
+		if ( not mDuplicateIdentifiersAllowed )
+		{
+			for ( auto& sequenceGroup : mSequenceGroups )
+			{
+				sequenceGroup.resize( 1 );
+			}
+		}
+	}
+
+	/**
+	 * Get the alphabet the sequences of loaded records are normalized to, as set or last detected.
+	 * @return The alphabet of loaded records is returned. [default: Any]
+	 */
+	FastaAlphabet::Type alphabet() const
+	{
+		return mAlphabet;
+	}
+
+	/**
+	 * Get the vector of FastaSequences associated with the given identifier.
+	 * @param identifier The identifier to the associated sequences.
+	 * @return Const reference to the vector of FastaSequences associated with the given identifier.
+	 * @throw std::out_of_range is thrown if no such identifier is present in the container.
+	 */
+	const std::vector< FastaSequence >& at(
+		const std::string& identifier ) const
+	{
+		const size_t group = _findGroup( identifier );
+
+		if ( std::string::npos == group )
+		{
+			throw std::out_of_range( "FastaFile::at: no such identifier" );
+		}
+
+		return mSequenceGroups[ group ];
+	}
+
+	/**
+	 * Get a const_iterator to the beginning of the container.
+	 * @return A const_iterator to the beginning of the container is returned.
+	 */
+	const_iterator begin() const
+	{
+		return const_iterator( mSequenceGroups.begin() );
+	}
+
+	/**
+	 * Get an iterator to the beginning of the container.
+	 * @return An iterator to the beginning of the container is returned.
+	 */
+	iterator begin()
+	{
+		return iterator( mSequenceGroups.begin() );
+	}
+
+	/**
+	 * Get a const_iterator to the beginning of the container.
+	 * @return A const_iterator to the beginning of the container is returned.
+	 */
+	const_iterator cbegin() const
+	{
+		return const_iterator( mSequenceGroups.begin() );
+	}
+
+	/**
+	 * Get a const_iterator to the end of the container.
+	 * @return A const_iterator to the end of the container is returned.
+	 */
+	const_iterator cend() const
+	{
+		return const_iterator( mSequenceGroups.end() );
+	}
+
+	/**
+	 * Collapse records holding byte-identical sequences into the first of them, whose identifier
+	 * becomes the identifiers of all of them joined by the separator, in container order. The
+	 * records are found by a 64-bit hash of their sequences, and confirmed by comparing them in
+	 * full. Empty sequences are left as is. New identifiers that are taken by other records are
+	 * dropped with their records if duplicate identifiers are not allowed.
+	 * @param separator Text placed between the merged identifiers; control characters are removed. [default: ";"]
+	 * @param threadCount The number of threads to hash with; zero selects one per hardware thread. [default: 1]
+	 * @return The number of records removed is returned.
+	 */
+	size_t collapseDuplicateSequences(
+		const std::string& separator = ";",
+		size_t threadCount = 1 )
+	{
+		std::vector< FastaSequence* > sequences;
+		const std::vector< size_t > firstSequences = _findDuplicateSequences( sequences, threadCount );
+		std::vector< std::string > identifiers( sequences.size() );
+		size_t numberRemoved( 0 );
+
+		for ( size_t offset( 0 ); offset < sequences.size(); ++offset )
+		{
+			const size_t first = firstSequences[ offset ];
+
+			if ( ( first != offset ) and ( 0 < sequences[ offset ]->length() ) )
+			{
+				if ( identifiers[ first ].empty() )
+				{
+					identifiers[ first ] = std::string( sequences[ first ]->_identifierView() );
+				}
+
+				identifiers[ first ] += separator;
+				identifiers[ first ] += std::string( sequences[ offset ]->_identifierView() );
+				++numberRemoved;
+			}
+		}
+
+		if ( 0 == numberRemoved )
+		{
+			return 0;
+		}
+
+		SequenceGroupsType sequenceGroups( std::move( mSequenceGroups ) );
+
+		mSequenceGroups.clear();
+		mIdentifierSlots.clear();
+		++mGeneration;
+
+		for ( size_t offset( 0 ); offset < sequences.size(); ++offset )
+		{
+			FastaSequence& sequence = *sequences[ offset ];
+
+			if ( ( firstSequences[ offset ] != offset ) and ( 0 < sequence.length() ) )
+			{
+				continue;
+			}
+
+			if ( not identifiers[ offset ].empty() )
+			{
+				sequence.setIdentifier( identifiers[ offset ] );
+			}
+
+			if ( mDuplicateIdentifiersAllowed or ( std::string::npos == _findGroup( sequence._identifierView() ) ) )
+			{
+				_addSequence( std::move( sequence ) );
+			}
+			else
+			{
+				++numberRemoved;
+			}
+		}
+
+		return numberRemoved;
+	}
+
+	/**
+	 * Count the k-mers of every sequence across the threads; see FastaKmerCounter.
+	 * @param k The number of bases in each k-mer, at most 32 for 64-bit words and 64 for 128-bit words.
+	 * @param canonical Flag whether k-mers are counted together with their reverse complement. [default: true]
+	 * @param threadCount The number of threads to count with; zero selects one per hardware thread. [default: 1]
+	 * @return The counts of the k-mers are returned.
+	 * @throw std::out_of_range is thrown if k is zero or too large for the word.
+	 */
+	template < typename Word = uint64_t >
+	FastaKmerCounter< Word > countKmers(
+		size_t k,
+		bool canonical = true,
+		size_t threadCount = 1 ) const
+	{
+		using Inserter = typename FastaKmerCounter< Word >::Inserter;
+
+		FastaKmerCounter< Word > counter( k, canonical );
+		std::vector< std::unique_ptr< Inserter > > inserters;
+
+		for ( size_t worker( 0 ); worker < _threadCount( threadCount ); ++worker )
+		{
+			inserters.emplace_back( new Inserter( counter ) );
+		}
+
+		_forEachGroup( threadCount,
+			[ & ]( size_t group, size_t worker )
+			{
+				for ( const auto& sequence : mSequenceGroups[ group ] )
+				{
+					inserters[ worker ]->add( sequence );
+				}
+			} );
+
+		for ( auto& inserter : inserters )
+		{
+			inserter->flush();
+		}
+
+		inserters.clear();
+
+		return counter;
+	}
+
+	/**
+	 * Construct a sequence in place from an identifier and a sequence, which are normalized
+	 * as in FastaSequence, and add it to the container. The strings are moved from, so passing
+	 * r-values avoids copying their buffers.
+	 * @param identifier The header/sequence identifier of the sequence to add.
+	 * @param sequence The genomic sequence to add.
+	 * @return If duplicates are allowed, then this will always return 1.
+	 *         If duplicates are not allowed, then 1 will only be returned if the
+	 *         identifier for the sequence is not already taken.
+	 */
+	size_t emplaceSequence(
+		std::string identifier,
+		std::string sequence )
+	{
+		return this->addSequence( FastaSequence( std::move( identifier ), std::move( sequence ) ) );
+	}
+
+	/**
+	 * Get a const_iterator to the end of the container.
+	 * @return A const_iterator to the end of the container is returned.
+	 */
+	const_iterator end() const
+	{
+		return const_iterator( mSequenceGroups.end() );
+	}
+
+	/**
+	 * Get an iterator to the end of the container.
+	 * @return An iterator to the end of the container is returned.
+	 */
+	iterator end()
+	{
+		return iterator( mSequenceGroups.end() );
+	}
+
+	/**
+	 * Find the groups of sequences whose identifiers match a glob pattern, in identifier order; '*'
+	 * matches any run of characters and '?' any one character. Only the identifiers that start
+	 * with the characters ahead of the first wildcard are tested, through the sorted index of
+	 * findByPrefix, so patterns such as "chrUn_*_random" stay fast. The index is built on demand
+	 * and kept up to date as groups are added, so it is not safe to call concurrently.
+	 * @param pattern The glob pattern to match whole identifiers against.
+	 * @return Pointers to the vectors of sequences sharing a matching identifier are returned.
+	 *         They are invalidated by adding sequences to the container.
+	 */
+	std::vector< const std::vector< FastaSequence >* > findByPattern(
+		const std::string& pattern ) const
+	{
+		const FastaStringView patternView( pattern );
+		const std::pair< size_t, size_t > range = _prefixRange( patternView.view( 0, pattern.find_first_of( "*?" ) ) );
+		std::vector< const std::vector< FastaSequence >* > groups;
+
+		for ( size_t position( range.first ); position < range.second; ++position )
+		{
+			const std::vector< FastaSequence >& sequenceGroup = mSequenceGroups[ mSortedGroups[ position ] ];
+
+			if ( _isGlobMatch( sequenceGroup.front()._identifierView(), patternView ) )
+			{
+				groups.push_back( &sequenceGroup );
+			}
+		}
+
+		return groups;
+	}
+
+	/**
+	 * Find the groups of sequences whose identifiers start with a prefix, in identifier order. The
+	 * groups are looked up by binary search over an index of the groups sorted by identifier,
+	 * which holds a group number per identifier rather than a copy of it. The index is built on
+	 * demand and kept up to date as groups are added, so it is not safe to call concurrently.
+	 * @param prefix The prefix of the identifiers to find; an empty prefix finds every group.
+	 * @return Pointers to the vectors of sequences sharing a matching identifier are returned.
+	 *         They are invalidated by adding sequences to the container.
+	 */
+	std::vector< const std::vector< FastaSequence >* > findByPrefix(
+		const std::string& prefix ) const
+	{
+		const std::pair< size_t, size_t > range = _prefixRange( prefix );
+		std::vector< const std::vector< FastaSequence >* > groups;
+
+		groups.reserve( range.second - range.first );
+
+		for ( size_t position( range.first ); position < range.second; ++position )
+		{
+			groups.push_back( &mSequenceGroups[ mSortedGroups[ position ] ] );
+		}
+
+		return groups;
+	}
+
+	/**
+	 * Retrieve the list of identifiers present within the container. The set is built on
+	 * demand and cached until identifiers are added or removed, so it is not safe to call concurrently.
+	 * @return A const reference to the sorted set of identifiers present.
+	 */
+	const std::set< std::string >& getIdentifiers() const
+	{
+		// The cache is rebuilt once groups are appended, or removed or replaced, which bumps the generation.
+		if ( ( mIdentifiersSetGeneration != mGeneration ) or ( mIdentifiersSet.size() != mSequenceGroups.size() ) )
+		{
+			mIdentifiersSet.clear();
+			mIdentifiersSetGeneration = mGeneration;
+
+			for ( const auto& sequenceGroup : mSequenceGroups )
+			{
+				mIdentifiersSet.insert( std::string( sequenceGroup.front()._identifierView() ) );
+			}
+		}
+
+		return mIdentifiersSet;
+	}
+
+	/**
+	 * Check for the presence of an identifier in the container.
+	 * @param identifier Const reference to the identifier to check for.
+	 * @return True is returned if the identifier is present.
+	 */
+	bool hasIdentifier(
+		const std::string& identifier ) const
+	{
+		return std::string::npos != _findGroup( identifier );
+	}
+
+	/**
+	 * Returns true if the file is a bare sequence.
+	 * @return True is returned if the file is a bare sequence.
+	 */
+	bool isBareSequence() const
+	{
+		return mIsBareSequence;
+	}
+
+	/**
+	 * Load a snapshot written by saveSnapshot, replacing the contents of this instance. The
+	 * snapshot is mapped into memory and nothing is parsed or normalized: identifiers and
+	 * unpacked sequences become read-only views into the mapping, whose pages are read in
+	 * as they are first accessed, and the identifier index is taken as stored once its hashes
+	 * are checked against the identifiers, which are hashed but not copied. Packed
+	 * sequences are copied out of the mapping in their packed form. If the snapshot was
+	 * written by a build hashing identifiers differently, the index is rebuilt instead.
+	 * @param filename The name of the snapshot to load.
+	 * @return Zero is returned upon success, else an errno value is returned; EINVAL if the
+	 *         file is not a valid snapshot, in which case this instance is left unchanged.
+	 */
+	int loadSnapshot(
+		const std::string& filename )
+	{
+		auto mappedFile = std::make_shared< FastaMappedFile >();
+		int errorCode = mappedFile->open( filename );
+
+		if ( 0 != errorCode )
+		{
+			return errorCode;
+		}
+
+		const char* const data = mappedFile->data();
+		const size_t size = mappedFile->size();
+
+		if ( ( size < SnapshotHeaderSize ) or ( 0 != std::memcmp( data, "FASTASNP", 8 ) ) or
+			( SnapshotVersion != FastaCompression::readLittleEndian( data + 8, 4 ) ) )
+		{
+			return EINVAL;
+		}
+
+		const uint64_t flags = FastaCompression::readLittleEndian( data + 12, 4 );
+		const uint64_t hashCheck = FastaCompression::readLittleEndian( data + 16, 8 );
+		const uint64_t sequenceCount = FastaCompression::readLittleEndian( data + 24, 8 );
+		const uint64_t groupCount = FastaCompression::readLittleEndian( data + 32, 8 );
+		const uint64_t slotCount = FastaCompression::readLittleEndian( data + 40, 8 );
+		const uint64_t recordsOffset = FastaCompression::readLittleEndian( data + 48, 8 );
+		const uint64_t slotsOffset = FastaCompression::readLittleEndian( data + 56, 8 );
+		const uint64_t fileSize = FastaCompression::readLittleEndian( data + 72, 8 );
+
+		if ( ( size != fileSize ) or ( sequenceCount < groupCount ) or ( 0 != ( slotCount & ( slotCount - 1 ) ) ) or
+			( slotCount < 2 * groupCount ) or
+			( size / SnapshotRecordSize < sequenceCount ) or not _isInSnapshot( recordsOffset, sequenceCount * SnapshotRecordSize, size ) or
+			( size / SnapshotSlotSize < slotCount ) or not _isInSnapshot( slotsOffset, slotCount * SnapshotSlotSize, size ) )
+		{
+			return EINVAL;
+		}
+
+		SequenceGroupsType sequenceGroups( static_cast< size_t >( groupCount ) );
+		std::vector< IdentifierSlot > identifierSlots;
+
+		for ( const char* record = data + recordsOffset; record < data + recordsOffset + sequenceCount * SnapshotRecordSize; record += SnapshotRecordSize )
+		{
+			const uint64_t identifierOffset = FastaCompression::readLittleEndian( record, 8 );
+			const uint64_t identifierLength = FastaCompression::readLittleEndian( record + 8, 8 );
+			const uint64_t sequenceOffset = FastaCompression::readLittleEndian( record + 16, 8 );
+			const uint64_t length = FastaCompression::readLittleEndian( record + 24, 8 );
+			const uint64_t group = FastaCompression::readLittleEndian( record + 32, 8 );
+			const uint64_t alphabet = FastaCompression::readLittleEndian( record + 40, 1 );
+			const uint64_t storage = FastaCompression::readLittleEndian( record + 41, 1 );
+			FastaSequence sequence;
+
+			if ( ( groupCount <= group ) or ( static_cast< uint64_t >( FastaAlphabet::Type::Protein ) < alphabet ) or ( 2 < storage ) or
+				not _isInSnapshot( identifierOffset, identifierLength, size ) )
+			{
+				return EINVAL;
+			}
+
+			sequence.mAlphabet = static_cast< FastaAlphabet::Type >( alphabet );
+			sequence._setExternalIdentifier( std::shared_ptr< const char >( mappedFile, data + identifierOffset ),
+				static_cast< size_t >( identifierLength ) );
+
+			if ( 0 == storage )
+			{
+				if ( not _isInSnapshot( sequenceOffset, length, size ) )
+				{
+					return EINVAL;
+				}
+
+				sequence._setExternalSequence( std::shared_ptr< const char >( mappedFile, data + sequenceOffset ),
+					static_cast< size_t >( length ), static_cast< size_t >( length ), static_cast< size_t >( length ) );
+			}
+			else
+			{
+				sequence.mPackedSequence = _loadPackedSequence( data, size, sequenceOffset, length,
+					( 1 == storage ) ? FastaPackedSequence::Encoding::TwoBit : FastaPackedSequence::Encoding::FourBit );
+
+				if ( not sequence.mPackedSequence )
+				{
+					return EINVAL;
+				}
+			}
+
+			// The sequences of a group share its identifier, which the index compares against.
+			if ( ( not sequenceGroups[ group ].empty() ) and
+				( sequenceGroups[ group ].front()._identifierView() != sequence._identifierView() ) )
+			{
+				return EINVAL;
+			}
+
+			sequenceGroups[ group ].push_back( std::move( sequence ) );
+		}
+
+		for ( const auto& sequenceGroup : sequenceGroups )
+		{
+			if ( sequenceGroup.empty() )
+			{
+				return EINVAL;
+			}
+		}
+
+		if ( _snapshotHashCheck() == hashCheck )
+		{
+			// Each group must be indexed exactly once, which also leaves the empty slots that end probing.
+			std::vector< bool > isIndexed( static_cast< size_t >( groupCount ), false );
+
+			identifierSlots.reserve( static_cast< size_t >( slotCount ) );
+
+			for ( const char* slot = data + slotsOffset; slot < data + slotsOffset + slotCount * SnapshotSlotSize; slot += SnapshotSlotSize )
+			{
+				const uint64_t group = FastaCompression::readLittleEndian( slot + 8, 8 );
+
+				if ( group < groupCount )
+				{
+					if ( isIndexed[ group ] )
+					{
+						return EINVAL;
+					}
+
+					isIndexed[ group ] = true;
+				}
+				else if ( ~static_cast< uint64_t >( 0 ) != group )
+				{
+					return EINVAL;
+				}
+
+				identifierSlots.push_back( IdentifierSlot{
+					static_cast< size_t >( FastaCompression::readLittleEndian( slot, 8 ) ),
+					( groupCount <= group ) ? std::string::npos : static_cast< size_t >( group ) } );
+			}
+
+			if ( isIndexed.end() != std::find( isIndexed.begin(), isIndexed.end(), false ) )
+			{
+				return EINVAL;
+			}
+
+			// Each slot must hold the hash of its identifier and be reached by probing from that
+			// hash, past no empty slot nor another group with the same identifier.
+			const size_t mask = identifierSlots.size() - 1;
+
+			for ( size_t slot( 0 ); slot < identifierSlots.size(); ++slot )
+			{
+				const IdentifierSlot& identifierSlot = identifierSlots[ slot ];
+
+				if ( std::string::npos == identifierSlot.group )
+				{
+					continue;
+				}
+
+				const FastaStringView identifier = sequenceGroups[ identifierSlot.group ].front()._identifierView();
+
+				if ( identifier.hash() != identifierSlot.hash )
+				{
+					return EINVAL;
+				}
+
+				for ( size_t probe = identifierSlot.hash & mask; probe != slot; probe = ( probe + 1 ) & mask )
+				{
+					if ( ( std::string::npos == identifierSlots[ probe ].group ) or
+						( ( identifierSlots[ probe ].hash == identifierSlot.hash ) and
+							( sequenceGroups[ identifierSlots[ probe ].group ].front()._identifierView() == identifier ) ) )
+					{
+						return EINVAL;
+					}
+				}
+			}
+		}
+
+		mSequenceGroups = std::move( sequenceGroups );
+		mIdentifierSlots = std::move( identifierSlots );
+		++mGeneration;
+		mDuplicateIdentifiersAllowed = ( 0 != ( flags & 0x1 ) );
+		mIsBareSequence = ( 0 != ( flags & 0x2 ) );
+
+		// An index hashed by another build is rebuilt from the identifiers.
+		if ( mIdentifierSlots.empty() and not mSequenceGroups.empty() )
+		{
+			_reindex();
+		}
+
+		return 0;
+	}
+
+	/**
+	 * Map a FastA file into memory and load it into this FastaFile instance without copying
+	 * the sequences. Sequences stored as fixed width lines of valid sequence characters become
+	 * read-only views into the mapping, which is kept alive for as long as any sequence refers
+	 * to it; a sequence is only copied once it is mutated or its sequence() string is requested.
+	 * Sequences requiring normalization are copied and normalized as in readFile.
+	 * If {@param allowDuplicates} is set to false and there are duplicates present
+	 * in the file, then only the first sequence is selected.
+	 * @param filename The name of the file to load into this instance.
+	 * @param allowDuplicates Flag to allow or disallow duplicate identifiers in the source file. [default: true]
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	int mapFile(
+		const std::string& filename,
+		bool allowDuplicates = true )
+	{
+		auto mappedFile = std::make_shared< FastaMappedFile >();
+		int errorCode = mappedFile->open( filename );
+
+		if ( 0 != errorCode )
+		{
+			return errorCode;
+		}
+
+		// Compressed files cannot be viewed in place, so they are read instead.
+		if ( FastaCompression::Format::None != FastaCompression::detect( mappedFile->data(), mappedFile->size() ) )
+		{
+			return this->readFile( filename, allowDuplicates );
+		}
+
+		const char* const end = mappedFile->data() + mappedFile->size();
+
+		if ( mIsAlphabetDetected )
+		{
+			mAlphabet = FastaAlphabet::detect( mappedFile->data(),
+				std::min( mappedFile->size(), static_cast< size_t >( FastaAlphabet::DetectionLength ) ) );
+		}
+
+		FastaIndex::_forEachRecord( mappedFile->data(), end, end,
+			[ & ]( const char* header, const char* sequenceBegin, const char* sequenceEnd )
+			{
+				FastaSequence sequence( std::string( header, sequenceBegin ), std::string() );
+
+				if ( 0 < sequence.identifier().length() )
+				{
+					sequence.mAlphabet = mAlphabet;
+					_mapSequence( sequence, mappedFile, sequenceBegin, sequenceEnd, mNormalization );
+					_addSequence( std::move( sequence ) );
+				}
+			} );
+
+		this->allowDuplicateIdentifiers( allowDuplicates );
+
+		return 0;
+	}
+
+	/**
+	 * Get a breakdown of the heap memory held by the container, to size memory limits by and to
+	 * find the slack that shrinkToFit would release. Bytes that records view, such as those of
+	 * mapFile or shareDuplicateSequences, are not counted; a packed sequence shared by several
+	 * records is counted for each of them.
+	 * @return The breakdown of the memory held is returned.
+	 */
+	MemoryUsage memoryUsage() const
+	{
+		MemoryUsage usage = {};
+
+		for ( const auto& sequenceGroup : mSequenceGroups )
+		{
+			for ( const auto& sequence : sequenceGroup )
+			{
+				size_t identifierBytes, sequenceBytes, slackBytes;
+
+				sequence._heapUsage( identifierBytes, sequenceBytes, slackBytes );
+
+				usage.identifiers += identifierBytes;
+				usage.sequences += sequenceBytes + ( sequence.mPackedSequence ? sequence.mPackedSequence->memoryUsage() : 0 );
+				usage.slack += slackBytes;
+			}
+
+			usage.records += sequenceGroup.capacity() * sizeof( FastaSequence );
+			usage.slack += ( sequenceGroup.capacity() - sequenceGroup.size() ) * sizeof( FastaSequence );
+		}
+
+		usage.arena = mArena ? mArena->capacity() : 0;
+		usage.records += mSequenceGroups.capacity() * sizeof( std::vector< FastaSequence > );
+		usage.slack += ( mSequenceGroups.capacity() - mSequenceGroups.size() ) * sizeof( std::vector< FastaSequence > );
+		usage.index = mIdentifierSlots.capacity() * sizeof( IdentifierSlot ) + mSortedGroups.capacity() * sizeof( size_t );
+		usage.slack += ( mIdentifierSlots.capacity() - mIdentifierSlots.size() ) * sizeof( IdentifierSlot );
+
+		for ( const auto& identifier : mIdentifiersSet )
+		{
+			// A red-black tree node holds a colour and three links ahead of its value.
+			usage.identifiersSet += 4 * sizeof( void* ) + sizeof( std::string ) + FastaSequence::_heapBytes( identifier );
+		}
+
+		return usage;
+	}
+
+	/**
+	 * Normalize every sequence whose normalization was deferred by lazy loading; see setNormalization.
+	 * The sequences are independent, so they are normalized in parallel across the threads.
+	 * @param threadCount The number of threads to normalize with; zero selects one per hardware thread. [default: 1]
+	 * @return The number of sequences normalized is returned.
+	 */
+	size_t normalize(
+		size_t threadCount = 1 )
+	{
+		std::atomic< size_t > numberNormalized( 0 );
+
+		_forEachGroup( threadCount,
+			[ & ]( size_t group, size_t )
+			{
+				for ( auto& sequence : mSequenceGroups[ group ] )
+				{
+					if ( not sequence.isNormalized() )
+					{
+						sequence.normalize();
+						++numberNormalized;
+					}
+				}
+			} );
+
+		return numberNormalized;
+	}
+
+	/**
+	 * Copy assignment operator.
+	 * @param other Const reference to the FastaFile to copy to this instance.
+	 * @return Reference to this FastaFile instance is returned.
+	 */
+	FastaFile& operator=(
+		const FastaFile& other )
+	{
+		if ( this != &other )
+		{
+			_copyAssign( other );
+		}
 
 		return *this;
 	}
 
 	/**
-	 * Sequence string element access.
-	 * @param index Offset from the beginning of the sequence string.
-	 * @return Reference to the character at the given offset.
+	 * Move assignment operator.
+	 * @param other R-Value to the FastaFile to move to this instance.
+	 * @return Reference to this FastaFile instance is returned.
 	 */
-	char& operator[](
-		size_t index )
+	FastaFile& operator=(
+		FastaFile&& other )
 	{
-		return mSequence[ index ];
+		if ( this != &other )
+		{
+			_moveAssign( std::move( other ) );
+		}
+
+		return *this;
 	}
 
 	/**
-	 * Const sequence string element access.
-	 * @param index Offset from the beginning of the sequence string.
-	 * @return Const reference to the character at the given offset.
-	 * @throw std::out_of_range is thrown if the index is greater than the sequence length.
+	 * Pack every nucleotide sequence in the container; see FastaSequence::pack.
+	 * Sequences holding characters that cannot be packed are left as is.
+	 * @return The number of sequences that are packed is returned.
 	 */
-	const char& operator[](
-		size_t index ) const
+	size_t pack()
 	{
-		return mSequence.at( index );
+		size_t numberPacked( 0 );
+
+		for ( auto& sequenceGroup : mSequenceGroups )
+		{
+			for ( auto& sequence : sequenceGroup )
+			{
+				numberPacked += sequence.pack();
+			}
+		}
+
+		return numberPacked;
 	}
 
 	/**
-	 * Get the sequence.
-	 * @return A const reference to the sequence.
+	 * Read in a FastA file into this FastaFile instance. If {@param allowDuplicates} is set
+	 * to false and there are duplicates present in the file, then only the first sequence is selected.
+	 * Gzip and BGZF compressed files are inflated as they are read.
+	 * @param filename The name of the file to load into this instance.
+	 * @param allowDuplicates Flag to allow or disallow duplicate identifiers in the source file. [default: true]
+	 * @return Zero is returned upon success, else an errno value is returned.
 	 */
-	const std::string& sequence() const
+	int readFile(
+		const std::string& filename,
+		bool allowDuplicates = true )
 	{
-		return mSequence;
+		return _readFile( filename, allowDuplicates, 1, nullptr );
 	}
 
 	/**
-	 * Set the identifier and normalize.
-	 * @param identifier Const reference to the identifier to assign to this object.
+	 * Read in a FastA file into this FastaFile instance as readFile does, gathering statistics of
+	 * the load and reporting progress through the callback of {@param statistics}, if set.
+	 * @param filename The name of the file to load into this instance.
+	 * @param allowDuplicates Flag to allow or disallow duplicate identifiers in the source file.
+	 * @param statistics Reference to the statistics to gather; they are reset first.
+	 * @return Zero is returned upon success, else an errno value is returned.
 	 */
-	void setIdentifier(
-		const std::string& identifier )
+	int readFile(
+		const std::string& filename,
+		bool allowDuplicates,
+		FastaStatistics& statistics )
 	{
-		mIdentifier = identifier;
-		_normalizeIdentifier();
+		statistics.reset();
+
+		return _readFile( filename, allowDuplicates, 1, &statistics );
 	}
 
 	/**
-	 * Set the sequence and normalize.
-	 * @param sequence Const reference to the sequence to assign to this object.
+	 * Read in a FastA file into this FastaFile instance using multiple threads. The file is
+	 * mapped into memory and split into byte ranges, each starting at the first header at or
+	 * after its nominal start, which are parsed in parallel and then merged in file order. The
+	 * resulting container, including insertion order and the handling of duplicate identifiers,
+	 * is the same as that of the single threaded readFile. Compressed files are parsed as a
+	 * stream, with BGZF blocks inflated across the threads.
+	 * @param filename The name of the file to load into this instance.
+	 * @param allowDuplicates Flag to allow or disallow duplicate identifiers in the source file.
+	 * @param threadCount The number of threads to parse with; zero selects one per hardware thread.
+	 * @return Zero is returned upon success, else an errno value is returned.
 	 */
-	void setSequence(
-		const std::string& sequence )
+	int readFile(
+		const std::string& filename,
+		bool allowDuplicates,
+		size_t threadCount )
 	{
-		mSequence = sequence;
-		_normalizeSequence();
+		return _readFile( filename, allowDuplicates, threadCount, nullptr );
 	}
-};
-
-/**
- * This class contains a collection of FastaSequences and
- * facilitates the reading/writing of FastA files, searchinng
- * based on the identifier, iterating over the collection, addition
- * and subtraction of sequences
- */
-class FastaFile
-{
-private:
-	using IdentifierSequenceMapType = std::map< std::string, std::vector< FastaSequence > >;
-
-	bool mIsBareSequence;
-	bool mDuplicateIdentifiersAllowed;
-	std::set< std::string > mIdentifiersSet;
-	IdentifierSequenceMapType mIdentifierSequenceMap;
 
-	void _copyAssign(
-		const FastaFile& other )
+	/**
+	 * Read in a FastA file into this FastaFile instance using multiple threads as readFile does,
+	 * gathering statistics of the load. The times spent parsing are summed across the threads, and
+	 * progress is reported from the calling thread as each byte range of the file is parsed.
+	 * @param filename The name of the file to load into this instance.
+	 * @param allowDuplicates Flag to allow or disallow duplicate identifiers in the source file.
+	 * @param threadCount The number of threads to parse with; zero selects one per hardware thread.
+	 * @param statistics Reference to the statistics to gather; they are reset first.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	int readFile(
+		const std::string& filename,
+		bool allowDuplicates,
+		size_t threadCount,
+		FastaStatistics& statistics )
 	{
-		mIsBareSequence = other.mIsBareSequence;
-		mDuplicateIdentifiersAllowed = other.mDuplicateIdentifiersAllowed;
-		mIdentifiersSet = other.mIdentifiersSet;
-		mIdentifierSequenceMap = other.mIdentifierSequenceMap;
-	}
+		statistics.reset();
 
-	void _moveAssign(
-		FastaFile&& other )
-	{
-		mIsBareSequence = std::exchange( other.mIsBareSequence, false );
-		mDuplicateIdentifiersAllowed = std::exchange( other.mDuplicateIdentifiersAllowed, true );
-		mIdentifiersSet = std::move( other.mIdentifiersSet );
-		mIdentifierSequenceMap = std::move( other.mIdentifierSequenceMap );
+		return _readFile( filename, allowDuplicates, threadCount, &statistics );
 	}
 
-public:
 	/**
-	 * Class for iterating over the container and possibly mutating elements.
+	 * Read the records appended to a growing FastA file since the last call, adding them to this
+	 * container as readFile would. Reading starts at offset, which is then advanced past every
+	 * record read; pass zero the first time, and the updated offset on each later call. Unless
+	 * {@param isAtEnd} is set, the last record of the file is left unread, as more of its sequence
+	 * lines may still be appended; it is read once another header follows it, or by a final call
+	 * with {@param isAtEnd} set once the file is complete. Only the bytes past offset are read.
+	 * If {@param allowDuplicates} is set to false, records whose identifiers are already present
+	 * are dropped.
+	 * @param filename The name of the file to read.
+	 * @param offset Reference to the byte offset of the first record not read yet, which is advanced.
+	 * @param allowDuplicates Flag to allow or disallow duplicate identifiers. [default: true]
+	 * @param isAtEnd Flag that the file is complete, so that its last record is read too. [default: false]
+	 * @return Zero is returned upon success, else an errno value is returned. EINVAL is returned if
+	 *         offset is past the end of the file or not at the start of a record, and ENOTSUP for
+	 *         compressed files, which cannot be resumed. On error, offset is only advanced past
+	 *         the records that were added.
 	 */
-	class iterator
+	int resumeFile(
+		const std::string& filename,
+		size_t& offset,
+		bool allowDuplicates = true,
+		bool isAtEnd = false )
 	{
-	private:
-		friend class FastaFile;
-
-		bool mIsValid;
-		IdentifierSequenceMapType::iterator mMapIterator;
-		size_t mVectorOffset;
+		FastaMappedFile mappedFile;
+		int errorCode = mappedFile.open( filename );
 
-		iterator(
-			IdentifierSequenceMapType::iterator mapIterator )
+		if ( 0 != errorCode )
 		{
-			mIsValid = true;
-			mMapIterator = mapIterator;
-			mVectorOffset = 0;
+			return errorCode;
 		}
 
-		void _copyAssign(
-			const iterator& other )
-		{
-			mIsValid = other.mIsValid;
-			mMapIterator = other.mMapIterator;
-			mVectorOffset = other.mVectorOffset;
-		}
+		const char* const begin = mappedFile.data();
+		const char* const end = begin + mappedFile.size();
 
-		void _moveAssign(
-			iterator&& other )
+		if ( FastaCompression::Format::None != FastaCompression::detect( begin, mappedFile.size() ) )
 		{
-			mIsValid = std::exchange( other.mIsValid, false );
-			mMapIterator = std::move( other.mMapIterator );
-			mVectorOffset = std::exchange( other.mVectorOffset, 0 );
+			return ENOTSUP;
 		}
 
-	public:
-		using iterator_category = std::forward_iterator_tag;
-		using difference_type   = std::ptrdiff_t;
-		using value_type        = FastaSequence;
-		using pointer           = FastaSequence*;
-		using reference         = FastaSequence&;
-
-		/**
-		 * Default constructor to an empty iterator.
-		 */
-		iterator()
+		if ( ( mappedFile.size() < offset ) or
+			( ( 0 < offset ) and ( offset < mappedFile.size() ) and ( ( '>' != begin[ offset ] ) or ( '\n' != begin[ offset - 1 ] ) ) ) )
 		{
-			mIsValid = false;
-			mVectorOffset = 0;
+			return EINVAL;
 		}
 
-		/**
-		 * Copy constructor.
-		 * @param other Const reference to iterator to copy to this instance.
-		 */
-		iterator(
-			const iterator& other )
+		if ( mIsAlphabetDetected and ( 0 == offset ) )
 		{
-			_copyAssign( other );
+			mAlphabet = FastaAlphabet::detect( begin,
+				std::min( mappedFile.size(), static_cast< size_t >( FastaAlphabet::DetectionLength ) ) );
 		}
 
-		/**
-		 * Move constructor.
-		 * @param other R-Value to iterator to move to this instance.
-		 */
-		iterator(
-			iterator&& other )
+		if ( mIsArenaStorageUsed and not mArena )
 		{
-			_moveAssign( std::move( other ) );
+			mArena = std::make_shared< FastaArena >();
 		}
 
-		/**
-		 * Copy assignment operator.
-		 * @param other Const reference to iterator to copy to this instance.
-		 * @return Reference to this iterator instance is returned.
-		 */
-		iterator& operator=(
-			const iterator& other )
+		FastaSequence record;
+		const char* nextRecord = begin + offset;
+
+		// Each record is copied out of the mapping, which is released on return.
+		auto addRecord = [ & ]( const char* header, const char* sequenceBegin, const char* sequenceEnd )
 		{
-			if ( this != &other )
+			record.mIdentifier.assign( header, sequenceBegin );
+			record.mSequence.assign( sequenceBegin, sequenceEnd );
+			record.mAlphabet = mAlphabet;
+			record._normalizeIdentifier();
+			record._normalizeSequence( mNormalization );
+
+			if ( ( 0 < record._identifierView().length() ) and
+				( allowDuplicates or ( std::string::npos == _findGroup( record._identifierView() ) ) ) )
 			{
-				_copyAssign( other );
+				_addSequence( mIsArenaStorageUsed ? _arenaSequence( mArena, record ) : std::move( record ) );
 			}
 
-			return *this;
-		}
+			nextRecord = sequenceEnd;
+		};
 
-		/**
-		 * Move assignment operator.
-		 * @param other R-Value to iterator to move to this instance.
-		 * @return Reference to this iterator instance is returned.
-		 */
-		iterator operator=(
-			iterator&& other )
+		try
 		{
-			if ( this != &other )
+			// Each record is added once the next one is found, so the last one can be held back.
+			const char* pendingHeader = nullptr;
+			const char* pendingSequence = nullptr;
+
+			FastaIndex::_forEachRecord( begin + offset, end, end,
+				[ & ]( const char* header, const char* sequenceBegin, const char* )
+				{
+					if ( nullptr != pendingHeader )
+					{
+						addRecord( pendingHeader, pendingSequence, header );
+					}
+
+					pendingHeader = header;
+					pendingSequence = sequenceBegin;
+				} );
+
+			if ( nullptr == pendingHeader )
 			{
-				_moveAssign( std::move( other ) );
+				nextRecord = isAtEnd ? end : nextRecord;
+			}
+			else if ( isAtEnd )
+			{
+				addRecord( pendingHeader, pendingSequence, end );
+			}
+			else
+			{
+				nextRecord = pendingHeader;
 			}
-
-			return *this;
 		}
-
-		/**
-		 * Compare iterators for equality.
-		 * @param other Const reference to the iterator to compare against for equality.
-		 * @return True is returned if this and other are equal.
-		 */
-		bool operator==(
-			const iterator& other )
+		catch ( const std::bad_alloc& )
 		{
-			return mIsValid
-				and ( mIsValid == other.mIsValid )
-				and ( mMapIterator == other.mMapIterator )
-				and ( mVectorOffset == other.mVectorOffset );
+			errorCode = ENOMEM;
 		}
 
-		/**
-		 * Compare iterators for inequality.
-		 * @param other Const reference to the iterator to compare against for inequality.
-		 * @return True is returned if this and other are not equal.
-		 */
-		bool operator!=(
-			const iterator& other )
-		{
-			return not this->operator==( other );
-		}
+		offset = nextRecord - begin;
+		this->allowDuplicateIdentifiers( allowDuplicates );
 
-		/**
-		 * Pointer access to the FastaSequence.
-		 * @return A pointer to the underlying FastaSequence object.
-		 */
-		pointer operator->()
-		{
-			if ( mIsValid )
+		return errorCode;
+	}
+
+	/**
+	 * Reverse complement every sequence in place; see FastaSequence::reverseComplement.
+	 * @param threadCount The number of threads to work with; zero selects one per hardware thread. [default: 1]
+	 */
+	void reverseComplement(
+		size_t threadCount = 1 )
+	{
+		_forEachGroup( threadCount,
+			[ this ]( size_t group, size_t )
 			{
-				return &mMapIterator.operator*().second[ mVectorOffset ];
-			}
+				for ( auto& sequence : mSequenceGroups[ group ] )
+				{
+					sequence.reverseComplement();
+				}
+			} );
+	}
 
-			return static_cast< pointer >( nullptr );
+	/**
+	 * Save the contents of this instance as a snapshot, which loadSnapshot maps back in without
+	 * parsing. The layout, with every integer little endian, is an 80 byte header (the magic
+	 * "FASTASNP", version, flags, a hash check, the number of sequences, groups and index slots,
+	 * the offsets of the record table, the index and the data, and the file size), a 48 byte
+	 * record per sequence in group order (the offsets and lengths of its identifier and
+	 * sequence, its group, alphabet and storage), the 16 byte slots of the identifier hash
+	 * index, and then the identifiers and sequences. Sequences that are packed are stored
+	 * packed, aligned to eight bytes, with their runs of N and soft-masked bases. Snapshots
+	 * are meant to speed up reloading data already loaded once; they are not an interchange format.
+	 * @param filename The name of the snapshot to write.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	int saveSnapshot(
+		const std::string& filename ) const
+	{
+		std::string tables;
+		std::vector< size_t > sequenceOffsets;
+		size_t sequenceCount( 0 );
+
+		for ( const auto& sequenceGroup : mSequenceGroups )
+		{
+			sequenceCount += sequenceGroup.size();
 		}
 
-		/**
-		 * Reference acess to the FastaSequence.
-		 * @return A reference to the underlying FastaSequence object.
-		 */
-		reference operator*()
+		const size_t recordsOffset = SnapshotHeaderSize;
+		const size_t slotsOffset = recordsOffset + sequenceCount * SnapshotRecordSize;
+		const size_t dataOffset = slotsOffset + mIdentifierSlots.size() * SnapshotSlotSize;
+		size_t dataEnd = dataOffset;
+
+		tables.reserve( dataOffset );
+		tables.resize( SnapshotHeaderSize );
+		sequenceOffsets.reserve( sequenceCount );
+
+		for ( size_t group( 0 ); group < mSequenceGroups.size(); ++group )
 		{
-			if ( mIsValid )
+			for ( const auto& sequence : mSequenceGroups[ group ] )
 			{
-				return mMapIterator.operator*().second[ mVectorOffset ];
-			}
+				const FastaStringView identifier = sequence._identifierView();
+				const size_t length = sequence.length();
+				const FastaPackedSequence* packedSequence = sequence.mPackedSequence.get();
+				uint64_t storage( 0 );
 
-			return *static_cast< pointer >( nullptr );
+				_appendLittleEndian( tables, dataEnd );
+				_appendLittleEndian( tables, identifier.length() );
+				dataEnd += identifier.length();
+
+				if ( nullptr != packedSequence )
+				{
+					storage = ( FastaPackedSequence::Encoding::TwoBit == packedSequence->mEncoding ) ? 1 : 2;
+					dataEnd = _snapshotAlign( dataEnd );
+					sequenceOffsets.push_back( dataEnd );
+					_appendLittleEndian( tables, dataEnd );
+					dataEnd = _snapshotAlign( dataEnd + SnapshotPackedSize + packedSequence->mBytes.size() ) +
+						( packedSequence->mNRuns.size() + packedSequence->mLowerCaseRuns.size() ) * SnapshotSlotSize;
+				}
+				else
+				{
+					sequenceOffsets.push_back( dataEnd );
+					_appendLittleEndian( tables, dataEnd );
+					dataEnd += length;
+				}
+
+				_appendLittleEndian( tables, length );
+				_appendLittleEndian( tables, group );
+				_appendLittleEndian( tables, static_cast< uint64_t >( sequence.mAlphabet ), 1 );
+				_appendLittleEndian( tables, storage, 1 );
+				_appendLittleEndian( tables, 0, 6 );
+			}
 		}
 
-		/**
-		 * Post-increment operator.
-		 * @return Return the iterator prior to incrementing.
-		 */
-		iterator operator++( int )
+		for ( const auto& identifierSlot : mIdentifierSlots )
 		{
-			iterator prior( *this );
-			this->operator++();
-			return prior;
+			_appendLittleEndian( tables, identifierSlot.hash );
+			_appendLittleEndian( tables, ( std::string::npos == identifierSlot.group ) ? ~static_cast< uint64_t >( 0 ) : identifierSlot.group );
 		}
 
-		/**
-		 * Pre-increment operator.
-		 * @return Reference to this iterator instance is returned.
-		 */
-		iterator& operator++()
+		std::string header( "FASTASNP" );
+
+		_appendLittleEndian( header, SnapshotVersion, 4 );
+		_appendLittleEndian( header, ( mDuplicateIdentifiersAllowed ? 0x1 : 0 ) | ( mIsBareSequence ? 0x2 : 0 ), 4 );
+		_appendLittleEndian( header, _snapshotHashCheck() );
+		_appendLittleEndian( header, sequenceCount );
+		_appendLittleEndian( header, mSequenceGroups.size() );
+		_appendLittleEndian( header, mIdentifierSlots.size() );
+		_appendLittleEndian( header, recordsOffset );
+		_appendLittleEndian( header, slotsOffset );
+		_appendLittleEndian( header, dataOffset );
+		_appendLittleEndian( header, dataEnd );
+		tables.replace( 0, SnapshotHeaderSize, header );
+
+		std::ofstream outputFile( filename, std::ios::out | std::ios::trunc | std::ios::binary );
+		std::vector< char > buffer( 1 << 16 );
+		const char padding[ 8 ] = {};
+		size_t offset = dataOffset;
+		size_t record( 0 );
+
+		outputFile.write( tables.data(), tables.size() );
+
+		for ( const auto& sequenceGroup : mSequenceGroups )
 		{
-			if ( mIsValid )
+			for ( const auto& sequence : sequenceGroup )
 			{
-				mMapIterator.operator++();
-			}
+				const FastaStringView identifier = sequence._identifierView();
+				const FastaPackedSequence* packedSequence = sequence.mPackedSequence.get();
 
-			return *this;
-		}
+				outputFile.write( identifier.data(), identifier.length() );
+				outputFile.write( padding, sequenceOffsets[ record ] - ( offset + identifier.length() ) );
+				offset = sequenceOffsets[ record++ ];
 
-		/**
-		 * Swap the contents of this iterator with other.
-		 * @param other Reference to the iterator instance to swap values with.
-		 */
-		void swap(
-			iterator& other )
-		{
-			std::swap( mIsValid, other.mIsValid );
-			std::swap( mMapIterator, other.mMapIterator );
-			std::swap( mVectorOffset, other.mVectorOffset );
+				if ( nullptr != packedSequence )
+				{
+					std::string blob;
+
+					_appendLittleEndian( blob, packedSequence->mBytes.size() );
+					_appendLittleEndian( blob, packedSequence->mNRuns.size() );
+					_appendLittleEndian( blob, packedSequence->mLowerCaseRuns.size() );
+					blob.append( packedSequence->mBytes.begin(), packedSequence->mBytes.end() );
+					blob.resize( _snapshotAlign( blob.size() ), '\0' );
+
+					for ( const auto* runs : { &packedSequence->mNRuns, &packedSequence->mLowerCaseRuns } )
+					{
+						for ( const auto& run : *runs )
+						{
+							_appendLittleEndian( blob, run.begin );
+							_appendLittleEndian( blob, run.length );
+						}
+					}
+
+					outputFile.write( blob.data(), blob.size() );
+					offset += blob.size();
+				}
+				else
+				{
+					const size_t length = sequence.length();
+
+					for ( size_t position( 0 ); position < length; position += buffer.size() )
+					{
+						outputFile.write( buffer.data(), sequence.copy( buffer.data(), buffer.size(), position ) );
+					}
+
+					offset += length;
+				}
+			}
 		}
-	};
+
+		outputFile.close();
+
+		return outputFile ? 0 : ( ( 0 == errno ) ? EIO : errno );
+	}
+
+	/**
+	 * Set the alphabet the sequences loaded by readFile and mapFile are normalized to; characters
+	 * outside of it are removed. Records added by addSequence keep their own alphabet.
+	 * @param alphabet The alphabet of loaded sequences. [default: Any]
+	 */
+	void setAlphabet(
+		FastaAlphabet::Type alphabet )
+	{
+		mAlphabet = alphabet;
+	}
 
 	/**
-	 * Class for iterating over the container in an immutable manner.
+	 * Set how the sequences loaded by readFile, and by mapFile for records it cannot view in
+	 * place, are normalized. Lazily loaded sequences keep their raw bytes, line terminators
+	 * included, until their length or characters are first accessed or normalize is called, so
+	 * loads that only need the identifiers do not scan the sequences. Trusted input, such as
+	 * files written by writeFile, must hold only valid sequence characters; only its line
+	 * terminators are removed. Records stored in an arena are normalized as they are copied in.
+	 * Identifiers are always normalized.
+	 * @param normalization How the sequences are normalized. [default: Eager]
 	 */
-	class const_iterator
+	void setNormalization(
+		FastaSequence::Normalization normalization )
 	{
-	private:
-		friend class FastaFile;
+		mNormalization = normalization;
+	}
 
-		bool mIsValid;
-		IdentifierSequenceMapType::const_iterator mConstMapIterator;
-		size_t mVectorOffset;
+	/**
+	 * Make records holding byte-identical sequences share a single copy of the characters, each
+	 * keeping its own identifier. The records are found by a 64-bit hash of their sequences, and
+	 * confirmed by comparing them in full. The shared characters are held as a view, as in mapFile,
+	 * and a record mutated later takes a copy of its own first.
+	 * @param threadCount The number of threads to hash with; zero selects one per hardware thread. [default: 1]
+	 * @return The number of records now sharing the characters of an earlier record is returned.
+	 */
+	size_t shareDuplicateSequences(
+		size_t threadCount = 1 )
+	{
+		std::vector< FastaSequence* > sequences;
+		const std::vector< size_t > firstSequences = _findDuplicateSequences( sequences, threadCount );
+		size_t numberShared( 0 );
 
-		const_iterator(
-			IdentifierSequenceMapType::const_iterator constMapIterator )
+		for ( size_t offset( 0 ); offset < sequences.size(); ++offset )
 		{
-			mIsValid = true;
-			mConstMapIterator = constMapIterator;
-			mVectorOffset = 0;
-		}
+			const size_t first = firstSequences[ offset ];
 
-		void _copyAssign(
-			const const_iterator& other )
-		{
-			mIsValid = other.mIsValid;
-			mConstMapIterator = other.mConstMapIterator;
-			mVectorOffset = other.mVectorOffset;
+			if ( ( first != offset ) and ( 0 < sequences[ offset ]->length() ) )
+			{
+				sequences[ first ]->_makeShareable();
+				sequences[ offset ]->_shareSequence( *sequences[ first ] );
+				++numberShared;
+			}
 		}
 
-		void _moveAssign(
-			const_iterator&& other )
+		return numberShared;
+	}
+
+	/**
+	 * Release excess memory: the spare capacity of every identifier, sequence and vector, such as
+	 * that left by append or by allowDuplicateIdentifiers( false ), the cache of getIdentifiers,
+	 * and the index, if larger than needed. Slabs of the arena are kept while records view them.
+	 */
+	void shrinkToFit()
+	{
+		for ( auto& sequenceGroup : mSequenceGroups )
 		{
-			mIsValid = std::exchange( other.mIsValid, false );
-			mConstMapIterator = std::move( other.mConstMapIterator );
-			mVectorOffset = std::exchange( other.mVectorOffset, 0 );
+			for ( auto& sequence : sequenceGroup )
+			{
+				sequence.shrinkToFit();
+			}
+
+			sequenceGroup.shrink_to_fit();
 		}
 
-	public:
-		using iterator_category = std::forward_iterator_tag;
-		using difference_type   = std::ptrdiff_t;
-		using value_type        = FastaSequence;
-		using pointer           = const FastaSequence*;
-		using reference         = const FastaSequence&;
+		mSequenceGroups.shrink_to_fit();
+		std::set< std::string >().swap( mIdentifiersSet );
+		std::vector< size_t >().swap( mSortedGroups );
 
-		/**
-		 * Default constructor to an empty const_iterator.
-		 */
-		const_iterator()
+		if ( mIdentifierSlots.size() > std::max( 4 * mSequenceGroups.size(), static_cast< size_t >( 16 ) ) )
 		{
-			mIsValid = false;
-			mVectorOffset = 0;
+			mIdentifierSlots = std::vector< IdentifierSlot >();
+			_reindex();
 		}
 
-		/**
-		 * Copy constructor.
-		 * @param other Const reference to const_iterator to copy to this instance.
-		 */
-		const_iterator(
-			const const_iterator& other )
-		{
-			_copyAssign( other );
-		}
+		mIdentifierSlots.shrink_to_fit();
+	}
 
-		/**
-		 * Move constructor.
-		 * @param other R-Value to const_iterator to move to this instance.
-		 */
-		const_iterator(
-			const_iterator&& other )
-		{
-			_moveAssign( std::move( other ) );
-		}
+	/**
+	 * Translate every sequence into a protein; see FastaSequence::translate.
+	 * @param frame The reading frame: 1, 2, 3, or -1, -2, -3 on the reverse complement. [default: 1]
+	 * @param codonTable Const reference to the genetic code. [default: FastaCodonTable::standard()]
+	 * @param threadCount The number of threads to work with; zero selects one per hardware thread. [default: 1]
+	 * @return A container of the proteins, in the order of the sequences, is returned.
+	 * @throw std::out_of_range is thrown if the frame is not one of the above.
+	 */
+	FastaFile translate(
+		int frame = 1,
+		const FastaCodonTable& codonTable = FastaCodonTable::standard(),
+		size_t threadCount = 1 ) const
+	{
+		SequenceGroupsType proteinGroups( mSequenceGroups.size() );
+		FastaFile proteins;
 
-		/**
-		 * Copy assignment operator.
-		 * @param other Const reference to const_iterator to copy to this instance.
-		 * @return Reference to this const_iterator instance is returned.
-		 */
-		const_iterator& operator=(
-			const const_iterator& other )
-		{
-			if ( this != &other )
+		_forEachGroup( threadCount,
+			[ & ]( size_t group, size_t )
 			{
-				_copyAssign( other );
-			}
+				for ( const auto& sequence : mSequenceGroups[ group ] )
+				{
+					proteinGroups[ group ].push_back( sequence.translate( frame, codonTable ) );
+				}
+			} );
 
-			return *this;
-		}
+		proteins.mIsBareSequence = mIsBareSequence;
+		proteins.mDuplicateIdentifiersAllowed = mDuplicateIdentifiersAllowed;
 
-		/**
-		 * Move assignment operator.
-		 * @param other R-Value to const_iterator to move to this instance.
-		 * @return Reference to this const_iterator instance is returned.
-		 */
-		const_iterator& operator=(
-			const_iterator&& other )
+		for ( auto& proteinGroup : proteinGroups )
 		{
-			if ( this != &other )
+			for ( auto& protein : proteinGroup )
 			{
-				_moveAssign( std::move( other ) );
+				proteins._addSequence( std::move( protein ) );
 			}
-
-			return *this;
 		}
 
-		/**
-		 * Compare const_iterators for equality.
-		 * @param other Const reference to the const_iterator to compare against for equality.
-		 * @return True is returned if this and other are equal.
-		 */
-		bool operator==(
-			const const_iterator& other )
+		return proteins;
+	}
+
+	/**
+	 * Set whether readFile and mapFile detect the alphabet of each file from its first
+	 * FastaAlphabet::DetectionLength bytes, replacing the alphabet set; see FastaAlphabet::detect.
+	 * @param use Flag whether or not the alphabet is detected. [default: true]
+	 */
+	void useAlphabetDetection(
+		bool use = true )
+	{
+		mIsAlphabetDetected = use;
+	}
+
+	/**
+	 * Set whether the identifiers and sequences loaded by readFile are stored in a few large
+	 * arena slabs rather than in a heap allocation per identifier and per sequence. Loaded
+	 * sequences are then read-only views of the arena, copied out as in mapFile once they are
+	 * mutated or their identifier() or sequence() strings are requested. Releasing the
+	 * container releases the slabs; it is kept alive by any sequence copied out of the container.
+	 * Records added by addSequence are stored as given.
+	 * @param use Flag whether or not loaded records are stored in an arena. [default: true]
+	 */
+	void useArenaStorage(
+		bool use = true )
+	{
+		mIsArenaStorageUsed = use;
+	}
+
+	/**
+	 * Write the contents of this container out to file.
+	 * @param filename Name of the file to write to.
+	 * @param lineLength Length of each sequence line. If {@param lineLength} is zero, then
+	 *                   the entire sequence will be on a single line. [default: 80]
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	int writeFile(
+		const std::string& filename,
+		size_t lineLength = 80 ) const
+	{
+		return _writeFile( filename, lineLength, nullptr );
+	}
+
+	/**
+	 * Write the contents of this container out to file as writeFile does, gathering statistics
+	 * of the write and reporting progress through the callback of {@param statistics}, if set.
+	 * @param filename Name of the file to write to.
+	 * @param lineLength Length of each sequence line, or zero for a single line per sequence.
+	 * @param statistics Reference to the statistics to gather; they are reset first.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 */
+	int writeFile(
+		const std::string& filename,
+		size_t lineLength,
+		FastaStatistics& statistics ) const
+	{
+		statistics.reset();
+
+		return _writeFile( filename, lineLength, &statistics );
+	}
+
+	/**
+	 * Write the contents of this container out across several files, one per filename, formatting
+	 * and writing the files in parallel. Count and Bases sharding keep the records in container
+	 * order, the first file holding the first run of records; Identifier sharding sends each
+	 * identifier to the file that a hash of its bytes selects, the same on every platform, in
+	 * container order within each file. A file is written, and empty, even if no record falls in it.
+	 * @param filenames Names of the files to write to; their number is the number of shards.
+	 * @param sharding How the records are partitioned across the files.
+	 * @param lineLength Length of each sequence line, or zero for a single line per sequence. [default: 80]
+	 * @param writeIndex Flag to also write a .fai index of each file to its filename + ".fai". [default: false]
+	 * @param threadCount Number of threads writing files, or zero for one per hardware thread. [default: 0]
+	 * @return Zero is returned upon success, else the errno value of the first failed file, in
+	 *         the order of {@param filenames}, is returned. EINVAL is returned if no filename is given.
+	 */
+	int writeFile(
+		const std::vector< std::string >& filenames,
+		Sharding sharding,
+		size_t lineLength = 80,
+		bool writeIndex = false,
+		size_t threadCount = 0 ) const
+	{
+		const size_t shardCount = filenames.size();
+		std::vector< std::vector< const FastaSequence* > > shards( shardCount );
+		std::vector< int > errorCodes( shardCount, 0 );
+		size_t totalRecords( 0 );
+		size_t totalBases( 0 );
+
+		if ( 0 == shardCount )
 		{
-			return mIsValid
-				and ( mIsValid == other.mIsValid )
-				and ( mConstMapIterator == other.mConstMapIterator )
-				and ( mVectorOffset == other.mVectorOffset );
+			return EINVAL;
 		}
 
-		/**
-		 * Compare const_iterators for inequality.
-		 * @param other Const reference to the const_iterator to compare against for inequality.
-		 * @return True is returned if this and other are not equal.
-		 */
-		bool operator!=(
-			const const_iterator& other )
+		for ( const auto& sequenceGroup : mSequenceGroups )
 		{
-			return not this->operator==( other );
+			for ( const auto& sequence : sequenceGroup )
+			{
+				++totalRecords;
+				totalBases += sequence.length();
+			}
 		}
 
-		/**
-		 * Const pointer access to the FastaSequence.
-		 * @return A const pointer to the underlying FastaSequence object.
-		 */
-		pointer operator->()
+		size_t record( 0 );
+		size_t bases( 0 );
+
+		for ( const auto& sequenceGroup : mSequenceGroups )
 		{
-			if ( mIsValid )
+			const size_t identifierShard = static_cast< size_t >( _shardHash( sequenceGroup.front()._identifierView() ) % shardCount );
+
+			for ( const auto& sequence : sequenceGroup )
 			{
-				return &mConstMapIterator.operator*().second[ mVectorOffset ];
-			}
+				size_t shard( identifierShard );
 
-			return static_cast< pointer >( nullptr );
+				if ( Sharding::Count == sharding )
+				{
+					shard = static_cast< size_t >( static_cast< double >( record ) * shardCount / totalRecords );
+				}
+				else if ( Sharding::Bases == sharding )
+				{
+					// The record goes to the file its midpoint falls in.
+					const double midpoint = bases + 0.5 * sequence.length();
+					shard = ( 0 == totalBases ) ? record * shardCount / totalRecords
+						: static_cast< size_t >( midpoint * shardCount / totalBases );
+				}
+
+				shards[ std::min( shard, shardCount - 1 ) ].push_back( &sequence );
+				++record;
+				bases += sequence.length();
+			}
 		}
 
-		/**
-		 * Const reference acess to the FastaSequence.
-		 * @return A const reference to the underlying FastaSequence object.
-		 */
-		reference operator*()
+		std::atomic< size_t > nextShard( 0 );
+		std::vector< std::thread > threads;
+
+		auto worker = [ & ]()
 		{
-			if ( mIsValid )
+			for ( size_t shard = nextShard++; shard < shardCount; shard = nextShard++ )
 			{
-				return mConstMapIterator.operator*().second[ mVectorOffset ];
+				errorCodes[ shard ] = _writeShard( filenames[ shard ], shards[ shard ], lineLength, writeIndex );
 			}
+		};
 
-			return *static_cast< pointer >( nullptr );
+		for ( size_t thread( 1 ); thread < std::min( _threadCount( threadCount ), shardCount ); ++thread )
+		{
+			threads.emplace_back( worker );
 		}
 
-		/**
-		 * Post-increment operator.
-		 * @return Return the const_iterator prior to incrementing.
-		 */
-		const_iterator operator++( int )
+		worker();
+
+		for ( auto& thread : threads )
 		{
-			const_iterator prior( *this );
-			this->operator++();
-			return prior;
+			thread.join();
 		}
 
-		/**
-		 * Pre-increment operator.
-		 * @return Reference to this const_iterator instance is returned.
-		 */
-		const_iterator& operator++()
+		for ( const int errorCode : errorCodes )
 		{
-			if ( mIsValid )
+			if ( 0 != errorCode )
 			{
-				mConstMapIterator.operator++();
+				return errorCode;
 			}
-
-			return *this;
 		}
 
-		/**
-		 * Swap the contents of this const_iterator with other.
-		 * @param other Reference to the const_iterator instance to swap values with.
-		 */
-		void swap(
-			const_iterator& other )
-		{
-			std::swap( mIsValid, other.mIsValid );
-			std::swap( mConstMapIterator, other.mConstMapIterator );
-			std::swap( mVectorOffset, other.mVectorOffset );
-		}
+		return 0;
+	}
+};
+
+/**
+ * This class is a FastaFile that several threads may add to and read from at once. The
+ * sequences are sharded by identifier hash across FastaFiles of their own, each behind a
+ * reader-writer lock, so producers adding records of different shards never wait on each
+ * other, and readers only wait on producers of the same shard. All the sequences sharing an
+ * identifier fall in the same shard, so duplicate identifiers are suppressed exactly, under
+ * the lock of that shard alone. The order of the sequences of an identifier is kept; the
+ * order across identifiers is not.
+ */
+class ConcurrentFastaFile
+{
+private:
+	struct Shard
+	{
+		mutable std::shared_timed_mutex mutex; // Shared by readers, exclusive to producers.
+		FastaFile file;                        // The sequences of the shard.
 	};
 
-	/**
-	 * Default constructor.
-	 * @param filename The name of the file to load into this instance. [default: ""]
-	 * @param allowDuplicates Flag to allow or disallow duplicate identifiers. [default: true]
-	 */
-	FastaFile(
-		const std::string& filename = std::string(),
-		bool allowDuplicates = true )
+	bool mDuplicateIdentifiersAllowed;
+	std::vector< std::unique_ptr< Shard > > mShards; // The shards; their number is a power of two.
+	unsigned mShardShift;                            // Shift of the identifier hash down to a shard.
+
+	// Shard of the identifier, picked by the high bits of its hash as the low bits index the shard.
+	Shard& _shard(
+		FastaStringView identifier ) const
 	{
-		mIsBareSequence = false;
+		return *mShards[ ( 1 == mShards.size() ) ? 0 : identifier.hash() >> mShardShift ];
+	}
 
-		if ( filename.empty() )
+	// Move sequences into the shards, locking each shard once for all of its sequences.
+	template < typename Sequences >
+	size_t _addSequences(
+		Sequences& sequences )
+	{
+		std::vector< std::vector< FastaSequence > > shardSequences( mShards.size() );
+		size_t numberAdded( 0 );
+
+		for ( auto& sequence : sequences )
 		{
-			mDuplicateIdentifiersAllowed = allowDuplicates;
+			const size_t shard = ( 1 == mShards.size() ) ? 0 : sequence._identifierView().hash() >> mShardShift;
+			shardSequences[ shard ].push_back( std::move( sequence ) );
 		}
-		else
+
+		for ( size_t shard( 0 ); shard < mShards.size(); ++shard )
 		{
-			this->readFile( filename, allowDuplicates );
+			if ( not shardSequences[ shard ].empty() )
+			{
+				std::lock_guard< std::shared_timed_mutex > lock( mShards[ shard ]->mutex );
+				numberAdded += mShards[ shard ]->file.addSequences( std::move( shardSequences[ shard ] ) );
+			}
 		}
-	}
 
-	/**
-	 * Copy constructor.
-	 * @param other Const reference to the FastaFile to copy to this instance.
-	 */
-	FastaFile(
-		const FastaFile& other )
-	{
-		_copyAssign( other );
+		return numberAdded;
 	}
 
+public:
 	/**
-	 * Move constructor.
-	 * @param other R-Value to the FastaFile to move to this instance.
+	 * Constructor to an empty container.
+	 * @param allowDuplicates Flag to allow or disallow duplicate identifiers. [default: true]
+	 * @param shardCount The number of shards, rounded up to a power of two of at most 65536. [default: 64]
 	 */
-	FastaFile(
-		FastaFile&& other )
+	explicit ConcurrentFastaFile(
+		bool allowDuplicates = true,
+		size_t shardCount = 64 )
 	{
-		_moveAssign( std::move( other ) );
+		size_t rounded( 1 );
+
+		mDuplicateIdentifiersAllowed = allowDuplicates;
+		mShardShift = static_cast< unsigned >( 8 * sizeof( size_t ) );
+
+		while ( rounded < shardCount and rounded < ( static_cast< size_t >( 1 ) << 16 ) )
+		{
+			rounded *= 2;
+			--mShardShift;
+		}
+
+		for ( size_t shard( 0 ); shard < rounded; ++shard )
+		{
+			mShards.emplace_back( new Shard );
+			mShards.back()->file.allowDuplicateIdentifiers( allowDuplicates );
+		}
 	}
 
+	ConcurrentFastaFile(
+		const ConcurrentFastaFile& other ) = delete;
+
+	ConcurrentFastaFile& operator=(
+		const ConcurrentFastaFile& other ) = delete;
+
 	/**
-	 * Add the sequence to the container.
-	 * @param Const reference to the sequence to add to the container.
+	 * Add the sequence to the container. Safe to call from several threads at once.
+	 * @param sequence Const reference to the sequence to add to the container.
 	 * @return If duplicates are allowed, then this will always return 1.
 	 *         If duplicates are not allowed, then 1 will only be returned if the
 	 *         identifier for the sequence is not already taken.
@@ -854,12 +10369,12 @@ public:
 	size_t addSequence(
 		const FastaSequence& sequence )
 	{
-		return this->addSequences( std::vector< FastaSequence >{ sequence } );
+		return this->addSequence( FastaSequence( sequence ) );
 	}
 
 	/**
-	 * Add the sequence to the container.
-	 * @param Const reference to the sequence to add to the container.
+	 * Add the sequence to the container, moving it in. Safe to call from several threads at once.
+	 * @param sequence R-Value to the sequence to add to the container.
 	 * @return If duplicates are allowed, then this will always return 1.
 	 *         If duplicates are not allowed, then 1 will only be returned if the
 	 *         identifier for the sequence is not already taken.
@@ -867,275 +10382,556 @@ public:
 	size_t addSequence(
 		FastaSequence&& sequence )
 	{
-		return this->addSequences( std::vector< FastaSequence >{ std::move( sequence ) } );
+		Shard& shard = _shard( sequence._identifierView() );
+		std::lock_guard< std::shared_timed_mutex > lock( shard.mutex );
+
+		return shard.file.addSequence( std::move( sequence ) );
 	}
 
 	/**
-	 * Add a vector of sequences to the container.
-	 * @param Const reference to the vector of sequences to add to the container.
-	 * @return The number of sequences from the vector added to the container from the
-	 *         vector is returned. If duplicates are not allowed, then the number returned
-	 *         may be less than the size of the vector.
+	 * Add a vector of sequences to the container, locking each shard once. Safe to call from
+	 * several threads at once.
+	 * @param sequences Const reference to the vector of sequences to add to the container.
+	 * @return The number of sequences from the vector added to the container is returned. If
+	 *         duplicates are not allowed, then the number returned may be less than the size of the vector.
 	 */
 	size_t addSequences(
 		const std::vector< FastaSequence >& sequences )
 	{
-		size_t numberAdded( 0 );
+		std::vector< FastaSequence > copies( sequences );
 
-		if ( mDuplicateIdentifiersAllowed )
-		{
-			for ( const auto& sequence : sequences )
-			{
-				mIdentifierSequenceMap[ sequence.identifier() ].push_back( sequence );
-			}
+		return _addSequences( copies );
+	}
+
+	/**
+	 * Add a vector of sequences to the container, moving them in and locking each shard once.
+	 * The vector is left empty. Safe to call from several threads at once.
+	 * @param sequences R-Value to the vector of sequences to add to the container.
+	 * @return The number of sequences from the vector added to the container is returned. If
+	 *         duplicates are not allowed, then the number returned may be less than the size of the vector.
+	 */
+	size_t addSequences(
+		std::vector< FastaSequence >&& sequences )
+	{
+		const size_t numberAdded = _addSequences( sequences );
+
+		sequences.clear();
+
+		return numberAdded;
+	}
+
+	/**
+	 * Get a copy of the FastaSequences associated with the given identifier. A copy is returned,
+	 * as sequences may be added to the identifier concurrently. Safe to call from several threads at once.
+	 * @param identifier The identifier of the associated sequences.
+	 * @return The FastaSequences associated with the given identifier are returned.
+	 * @throw std::out_of_range is thrown if no such identifier is present in the container.
+	 */
+	std::vector< FastaSequence > at(
+		const std::string& identifier ) const
+	{
+		const Shard& shard = _shard( identifier );
+		std::shared_lock< std::shared_timed_mutex > lock( shard.mutex );
+		const size_t group = shard.file._findGroup( identifier );
 
-			numberAdded = sequences.size();
+		if ( std::string::npos == group )
+		{
+			throw std::out_of_range( "ConcurrentFastaFile::at: no such identifier" );
 		}
-		else
+
+		return shard.file.mSequenceGroups[ group ];
+	}
+
+	/**
+	 * Move every sequence into a FastaFile, leaving this container empty. Sequences added
+	 * concurrently end up either in the FastaFile or in this container.
+	 * @return The FastaFile holding the sequences is returned.
+	 */
+	FastaFile extract()
+	{
+		FastaFile file;
+
+		file.allowDuplicateIdentifiers( mDuplicateIdentifiersAllowed );
+
+		for ( auto& shard : mShards )
 		{
-			for ( const auto& sequence : sequences )
+			std::lock_guard< std::shared_timed_mutex > lock( shard->mutex );
+
+			// The shards hold disjoint identifiers, so no duplicates need to be looked for.
+			for ( auto& sequenceGroup : shard->file.mSequenceGroups )
 			{
-				if ( mIdentifierSequenceMap.end() == mIdentifierSequenceMap.find( sequence.identifier() ) )
+				for ( auto& sequence : sequenceGroup )
 				{
-					mIdentifierSequenceMap[ sequence.identifier() ].push_back( sequence );
-					++numberAdded;
+					file._addSequence( std::move( sequence ) );
 				}
 			}
+
+			shard->file = FastaFile();
+			shard->file.allowDuplicateIdentifiers( mDuplicateIdentifiersAllowed );
 		}
 
-		return numberAdded;
+		return file;
 	}
 
 	/**
-	 * Flag that the container is or is not allowed duplicate identifiers.
-	 * By default, the container allows duplicate identifiers. Should false be
-	 * passed into this method, then a scan is performed to removed any
-	 * sequences that map to a shared identifier excluding the first added to this container.
-	 * @param allow Flag whether or not duplicate identifiers are allowed.
+	 * Invoke function( sequence ) for every sequence, a shard at a time under its read lock, so
+	 * sequences may be added concurrently; each is visited at most once. The function must not
+	 * add to this container, and should be quick, as producers of the shard wait on it.
+	 * @param function The function to invoke with a const reference to each sequence.
 	 */
-	void allowDuplicateIdentifiers(
-		bool allow = true )
+	template < typename Function >
+	void forEach(
+		Function function ) const
 	{
-		mDuplicateIdentifiersAllowed = allow;
+		for ( const auto& shard : mShards )
+		{
+			std::shared_lock< std::shared_timed_mutex > lock( shard->mutex );
 
-		if ( not mDuplicateIdentifiersAllowed )
+			for ( const auto& sequence : shard->file )
+			{
+				function( sequence );
+			}
+		}
+	}
+
+	/**
+	 * Retrieve the identifiers present within the container. Safe to call from several threads at once.
+	 * @return The sorted set of identifiers present is returned.
+	 */
+	std::set< std::string > getIdentifiers() const
+	{
+		std::set< std::string > identifiers;
+
+		for ( const auto& shard : mShards )
 		{
-			for ( auto& sequenceVector : mIdentifierSequenceMap )
+			std::shared_lock< std::shared_timed_mutex > lock( shard->mutex );
+
+			for ( const auto& sequenceGroup : shard->file.mSequenceGroups )
 			{
-				sequenceVector.second.resize( 1 );
+				identifiers.insert( std::string( sequenceGroup.front()._identifierView() ) );
 			}
 		}
+
+		return identifiers;
 	}
 
 	/**
-	 * Get the vector of FastaSequences associated with the given identifier.
-	 * @param identifier The identifier to the associated sequences.
-	 * @return Const reference to the vector of FastaSequences associated with the given identifier.
-	 * @throw std::out_of_range is thrown if no such identifier is present in the container.
+	 * Check for the presence of an identifier in the container. Safe to call from several threads at once.
+	 * @param identifier The identifier to check for.
+	 * @return True is returned if the identifier is present.
 	 */
-	const std::vector< FastaSequence >& at(
+	bool hasIdentifier(
 		const std::string& identifier ) const
 	{
-		return mIdentifierSequenceMap.at( identifier );
+		const Shard& shard = _shard( identifier );
+		std::shared_lock< std::shared_timed_mutex > lock( shard.mutex );
+
+		return shard.file.hasIdentifier( identifier );
 	}
 
 	/**
-	 * Get a const_iterator to the beginning of the container.
-	 * @return A const_iterator to the beginning of the container is returned.
+	 * Check if duplicate identifiers are allowed, as set on construction.
+	 * @return True is returned if duplicate identifiers are allowed.
 	 */
-	const_iterator begin() const
+	bool isDuplicateIdentifiersAllowed() const
 	{
-		return const_iterator( mIdentifierSequenceMap.begin() );
+		return mDuplicateIdentifiersAllowed;
 	}
 
 	/**
-	 * Get an iterator to the beginning of the container.
-	 * @return An iterator to the beginning of the container is returned.
+	 * Get the number of sequences in the container. Safe to call from several threads at once.
+	 * @return The number of sequences is returned.
 	 */
-	iterator begin()
+	size_t size() const
 	{
-		return iterator( mIdentifierSequenceMap.begin() );
+		size_t size( 0 );
+
+		for ( const auto& shard : mShards )
+		{
+			std::shared_lock< std::shared_timed_mutex > lock( shard->mutex );
+
+			for ( const auto& sequenceGroup : shard->file.mSequenceGroups )
+			{
+				size += sequenceGroup.size();
+			}
+		}
+
+		return size;
 	}
+};
 
+/**
+ * This class holds a multiple sequence alignment, rows of equal length with '-' for gaps, in
+ * column-major order: the characters of each column are contiguous, so that walking the
+ * alignment column by column reads memory sequentially rather than touching every row. The
+ * rows are transposed in tiles of 64 rows by 64 columns, which keep the reads and writes of
+ * the transposition within cache. Column profiles are computed from the histogram of each
+ * column by FastaKernels::histogram.
+ */
+class FastaAlignment
+{
+public:
 	/**
-	 * Get a const_iterator to the beginning of the container.
-	 * @return A const_iterator to the beginning of the container is returned.
+	 * Summary of a column of the alignment.
 	 */
-	const_iterator cbegin() const
+	struct ColumnProfile
+	{
+		char consensus;     // Most frequent residue, in upper case and the first in ASCII order on ties, or '-' if the column only holds gaps.
+		double gapFraction; // Fraction of the rows holding a gap.
+		double entropy;     // Shannon entropy of the residues, in either case and gaps excluded, in bits.
+	};
+
+private:
+	std::vector< std::string > mIdentifiers; // Identifier of each row.
+	std::string mColumns;                    // Column c is held at [ c * mRowCount, ( c + 1 ) * mRowCount ).
+	size_t mRowCount;                        // Number of rows.
+	size_t mColumnCount;                     // Number of columns.
+
+	// Profile the characters of a column.
+	static ColumnProfile _profile(
+		const char* data,
+		size_t length )
+	{
+		uint64_t counts[ 256 ] = {};
+		ColumnProfile profile = { '-', 0, 0 };
+
+		FastaKernels::histogram( data, length, counts );
+
+		for ( int character( 'a' ); character <= 'z'; ++character )
+		{
+			counts[ character & ~0x20 ] += counts[ character ];
+			counts[ character ] = 0;
+		}
+
+		const uint64_t residues = length - counts[ static_cast< uint8_t >( '-' ) ];
+		uint64_t consensusCount( 0 );
+
+		counts[ static_cast< uint8_t >( '-' ) ] = 0;
+
+		for ( int byte( 0 ); byte < 256; ++byte )
+		{
+			if ( 0 < counts[ byte ] )
+			{
+				const double frequency = static_cast< double >( counts[ byte ] ) / residues;
+
+				profile.entropy -= frequency * std::log2( frequency );
+
+				if ( counts[ byte ] > consensusCount )
+				{
+					consensusCount = counts[ byte ];
+					profile.consensus = static_cast< char >( byte );
+				}
+			}
+		}
+
+		profile.gapFraction = ( 0 == length ) ? 0 : static_cast< double >( length - residues ) / length;
+		profile.entropy = std::max( profile.entropy, 0.0 );
+
+		return profile;
+	}
+
+	// Take the given rows, in order, returning false if they differ in length.
+	bool _assign(
+		const std::vector< const FastaSequence* >& rows )
 	{
-		return const_iterator( mIdentifierSequenceMap.begin() );
+		const size_t tileSize( 64 );
+		std::string tile;
+
+		mIdentifiers.clear();
+		mColumns.clear();
+		mRowCount = 0;
+		mColumnCount = 0;
+
+		for ( const FastaSequence* sequence : rows )
+		{
+			if ( sequence->length() != rows.front()->length() )
+			{
+				mIdentifiers.clear();
+				return false;
+			}
+
+			mIdentifiers.push_back( sequence->identifier() );
+		}
+
+		mRowCount = rows.size();
+		mColumnCount = rows.empty() ? 0 : rows.front()->length();
+		mColumns.resize( mRowCount * mColumnCount );
+
+		for ( size_t firstRow( 0 ); firstRow < mRowCount; firstRow += tileSize )
+		{
+			const size_t tileRows = std::min( tileSize, mRowCount - firstRow );
+
+			tile.resize( tileRows * mColumnCount );
+
+			for ( size_t row( 0 ); row < tileRows; ++row )
+			{
+				rows[ firstRow + row ]->copy( &tile[ row * mColumnCount ], mColumnCount );
+			}
+
+			for ( size_t firstColumn( 0 ); firstColumn < mColumnCount; firstColumn += tileSize )
+			{
+				const size_t lastColumn = std::min( firstColumn + tileSize, mColumnCount );
+
+				for ( size_t column( firstColumn ); column < lastColumn; ++column )
+				{
+					char* destination = &mColumns[ column * mRowCount + firstRow ];
+
+					for ( size_t row( 0 ); row < tileRows; ++row )
+					{
+						destination[ row ] = tile[ row * mColumnCount + column ];
+					}
+				}
+			}
+		}
+
+		return true;
 	}
 
+public:
 	/**
-	 * Get a const_iterator to the end of the container.
-	 * @return A const_iterator to the end of the container is returned.
+	 * Default constructor to an empty alignment.
 	 */
-	const_iterator cend() const
+	FastaAlignment()
 	{
-		return const_iterator( mIdentifierSequenceMap.end() );
+		mRowCount = 0;
+		mColumnCount = 0;
 	}
 
 	/**
-	 * Get a const_iterator to the end of the container.
-	 * @return A const_iterator to the end of the container is returned.
+	 * Constructor taking the sequences of a FastaFile as the rows, in container order: sequences
+	 * sharing an identifier are grouped together, so rows with a repeated identifier do not keep
+	 * their order in the file. Use readFile to keep the rows of a file in file order.
+	 * @param file Const reference to the FastaFile holding the aligned sequences.
+	 * @throw std::invalid_argument is thrown if the sequences differ in length.
 	 */
-	const_iterator end() const
+	explicit FastaAlignment(
+		const FastaFile& file )
 	{
-		return const_iterator( mIdentifierSequenceMap.end() );
+		this->assign( file );
 	}
 
 	/**
-	 * Get an iterator to the end of the container.
-	 * @return An iterator to the end of the container is returned.
+	 * Take the sequences of a FastaFile as the rows, in container order, replacing the current rows.
+	 * Sequences sharing an identifier are grouped together; see the FastaFile constructor.
+	 * @param file Const reference to the FastaFile holding the aligned sequences.
+	 * @throw std::invalid_argument is thrown if the sequences differ in length; the alignment is left empty.
 	 */
-	iterator end()
+	void assign(
+		const FastaFile& file )
 	{
-		return iterator( mIdentifierSequenceMap.end() );
+		std::vector< const FastaSequence* > rows;
+
+		for ( const auto& sequence : file )
+		{
+			rows.push_back( &sequence );
+		}
+
+		if ( not _assign( rows ) )
+		{
+			throw std::invalid_argument( "FastaAlignment::assign: sequences differ in length" );
+		}
 	}
 
 	/**
-	 * Retrieve the list of identifiers present within the container.
-	 * @return A const reference to the vector of identifiers present.
+	 * Character access.
+	 * @param row The row of the character.
+	 * @param column The column of the character.
+	 * @return The character is returned.
+	 * @throw std::out_of_range is thrown if the row or the column is out of range.
 	 */
-	const std::set< std::string >& getIdentifiers() const
+	char at(
+		size_t row,
+		size_t column ) const
 	{
-		return mIdentifiersSet;
+		if ( ( row >= mRowCount ) or ( column >= mColumnCount ) )
+		{
+			throw std::out_of_range( "FastaAlignment::at: position is out of range" );
+		}
+
+		return mColumns[ column * mRowCount + row ];
 	}
 
 	/**
-	 * Check for the presence of an identifier in the container.
-	 * @param identifier Const reference to the identifier to check for.
-	 * @return True is returned if the identifier is present.
+	 * Get the characters of a column, one per row.
+	 * @param column The column to view.
+	 * @return A view of the contiguous characters of the column, valid while the alignment is unchanged.
+	 * @throw std::out_of_range is thrown if the column is out of range.
 	 */
-	bool hasIdentifier(
-		const std::string& identifier ) const
+	FastaStringView column(
+		size_t column ) const
 	{
-		return mIdentifiersSet.end() != mIdentifiersSet.find( identifier );
+		if ( column >= mColumnCount )
+		{
+			throw std::out_of_range( "FastaAlignment::column: column is out of range" );
+		}
+
+		return FastaStringView( mColumns.data() + column * mRowCount, mRowCount );
 	}
 
 	/**
-	 * Returns true if the file is a bare sequence.
-	 * @return True is returned if the file is a bare sequence.
+	 * Get the number of columns, the length of every row.
+	 * @return The number of columns is returned.
 	 */
-	bool isBareSequence() const
+	size_t columnCount() const
 	{
-		return mIsBareSequence;
+		return mColumnCount;
 	}
 
 	/**
-	 * Copy assignment operator.
-	 * @param other Const reference to the FastaFile to copy to this instance.
-	 * @return Reference to this FastaFile instance is returned.
+	 * Get the consensus of the alignment: the consensus residue of every column; see ColumnProfile.
+	 * @param threadCount The number of threads to profile with; zero selects one per hardware thread. [default: 1]
+	 * @return The consensus sequence, a character per column, is returned.
 	 */
-	FastaFile& operator=(
-		const FastaFile& other )
+	std::string consensus(
+		size_t threadCount = 1 ) const
 	{
-		if ( this != &other )
+		const std::vector< ColumnProfile > columnProfiles = this->profiles( threadCount );
+		std::string sequence( mColumnCount, '-' );
+
+		for ( size_t column( 0 ); column < mColumnCount; ++column )
 		{
-			_copyAssign( other );
+			sequence[ column ] = columnProfiles[ column ].consensus;
 		}
 
-		return *this;
+		return sequence;
 	}
 
 	/**
-	 * Move assignment operator.
-	 * @param other R-Value to the FastaFile to move to this instance.
-	 * @return Reference to this FastaFile instance is returned.
+	 * Get the identifier of a row.
+	 * @param row The row of the identifier.
+	 * @return Const reference to the identifier is returned.
+	 * @throw std::out_of_range is thrown if the row is out of range.
 	 */
-	FastaFile& operator=(
-		FastaFile&& other )
+	const std::string& identifier(
+		size_t row ) const
 	{
-		if ( this != &other )
-		{
-			_moveAssign( std::move( other ) );
-		}
+		return mIdentifiers.at( row );
+	}
 
-		return *this;
+	/**
+	 * Profile a column of the alignment.
+	 * @param column The column to profile.
+	 * @return The profile of the column is returned.
+	 * @throw std::out_of_range is thrown if the column is out of range.
+	 */
+	ColumnProfile profile(
+		size_t column ) const
+	{
+		const FastaStringView characters = this->column( column );
+
+		return _profile( characters.data(), characters.length() );
 	}
 
 	/**
-	 * Read in a FastA file into this FastaFile instance. If {@param allowDuplicates} is set
-	 * to false and there are duplicates present in the file, then only the first sequence is selected.
-	 * @param filename The name of the file to load into this instance.
-	 * @param allowDuplicates Flag to allow or disallow duplicate identifiers in the source file. [default: true]
-	 * @return Zero is returned upon success, else an error code is returned.
+	 * Profile every column of the alignment, spreading the columns across the threads.
+	 * @param threadCount The number of threads to profile with; zero selects one per hardware thread. [default: 1]
+	 * @return The profile of each column is returned, in column order.
 	 */
-	int readFile(
-		const std::string& filename,
-		bool allowDuplicates = true )
+	std::vector< ColumnProfile > profiles(
+		size_t threadCount = 1 ) const
 	{
-		std::string line, sequenceString;
-		std::ifstream inputFile;
-		FastaSequence sequence;
+		const size_t columnsPerTask( 256 );
+		std::vector< ColumnProfile > columnProfiles( mColumnCount );
+		std::atomic< size_t > nextColumn( 0 );
+		std::vector< std::thread > threads;
 
-		inputFile.open( filename, std::ios::in );
+		threadCount = ( 0 == threadCount ) ? std::max( std::thread::hardware_concurrency(), 1u ) : threadCount;
 
-		while ( std::getline( inputFile, line ) )
+		auto worker = [ & ]()
 		{
-			if ( '>' == line[ 0 ] )
+			for ( size_t first = nextColumn.fetch_add( columnsPerTask ); first < mColumnCount; first = nextColumn.fetch_add( columnsPerTask ) )
 			{
-				if ( 0 < sequence.identifier().length() )
+				for ( size_t column( first ); column < std::min( first + columnsPerTask, mColumnCount ); ++column )
 				{
-					sequence.setSequence( sequenceString );
-					mIdentifiersSet.insert( sequence.identifier() );
-					mIdentifierSequenceMap[ sequence.identifier() ].push_back( sequence );
+					columnProfiles[ column ] = _profile( mColumns.data() + column * mRowCount, mRowCount );
 				}
-
-				sequence.setIdentifier( line );
-				sequenceString.clear();
-			}
-			else
-			{
-				sequenceString.append( line );
 			}
-		}
+		};
 
-		sequence.setSequence( sequenceString );
-		mIdentifiersSet.insert( sequence.identifier() );
-		mIdentifierSequenceMap[ sequence.identifier() ].push_back( sequence );
+		for ( size_t thread( 1 ); thread < std::min( threadCount, ( mColumnCount + columnsPerTask - 1 ) / columnsPerTask ); ++thread )
+		{
+			threads.emplace_back( worker );
+		}
 
-		inputFile.close();
+		worker();
 
-		this->allowDuplicateIdentifiers( allowDuplicates );
+		for ( auto& thread : threads )
+		{
+			thread.join();
+		}
 
-		return 0;
+		return columnProfiles;
 	}
 
 	/**
-	 * Write the contents of this container out to file.
-	 * @param filename Name of the file to write to.
-	 * @param lineLength Length of each sequence line. If {@param lineLength} is zero, then
-	 *                   the entire sequence will be on a single line. [default: 80]
-	 * @return Return zero upon success, else an error code is returned.
+	 * Read an aligned FastA file, such as one written by MAFFT, MUSCLE or Clustal Omega, replacing
+	 * the current rows. The rows are kept in file order, repeated identifiers included. Gzip and
+	 * BGZF compressed files are inflated as they are read.
+	 * @param filename The name of the file to read.
+	 * @return Zero is returned upon success, else an errno value is returned.
+	 *         EINVAL is returned if the sequences differ in length; the alignment is left empty.
 	 */
-	int writeFile(
-		const std::string& filename,
-		size_t lineLength = 80 ) const
+	int readFile(
+		const std::string& filename )
 	{
-		std::ofstream outputFile;
-		outputFile.open( filename, std::ios::out | std::ios::trunc );
+		FastaReader reader;
+		std::vector< FastaSequence > sequences;
+		std::vector< const FastaSequence* > rows;
+		int errorCode = reader.open( filename );
 
-		if ( 0 == lineLength )
+		if ( 0 == errorCode )
 		{
-			lineLength = static_cast< size_t >( -1 );
+			sequences.emplace_back();
+
+			while ( reader.read( sequences.back() ) )
+			{
+				sequences.emplace_back();
+			}
+
+			sequences.pop_back();
+			errorCode = reader.error();
 		}
 
-		for ( const auto& sequenceVector : mIdentifierSequenceMap )
+		if ( 0 != errorCode )
 		{
-			for ( const auto& sequence : sequenceVector.second )
-			{
-				outputFile << ">" << sequence.identifier() << std::endl;
+			_assign( rows );
+			return errorCode;
+		}
 
-				for ( size_t offset( 0 ); offset < sequence.length(); offset += lineLength )
-				{
-					outputFile << sequence.sequence().substr( offset, lineLength ) << std::endl;
-				}
-			}
+		for ( const auto& sequence : sequences )
+		{
+			rows.push_back( &sequence );
 		}
 
-		outputFile.close();
+		return _assign( rows ) ? 0 : EINVAL;
+	}
 
-		return 0;
+	/**
+	 * Get a row of the alignment, gathering its characters from the columns.
+	 * @param row The row to get.
+	 * @return The row, with its identifier, is returned.
+	 * @throw std::out_of_range is thrown if the row is out of range.
+	 */
+	FastaSequence row(
+		size_t row ) const
+	{
+		const std::string& identifier = this->identifier( row );
+		std::string sequence( mColumnCount, '-' );
+
+		for ( size_t column( 0 ); column < mColumnCount; ++column )
+		{
+			sequence[ column ] = mColumns[ column * mRowCount + row ];
+		}
+
+		return FastaSequence( identifier, sequence );
+	}
+
+	/**
+	 * Get the number of rows, the number of aligned sequences.
+	 * @return The number of rows is returned.
+	 */
+	size_t rowCount() const
+	{
+		return mRowCount;
 	}
 };
@@ -0,0 +1,595 @@
+/**
+ * Copyright ©2022. Brent Weichel. All Rights Reserved.
+ * Permission to use, copy, modify, and/or distribute this software, in whole
+ * or part by any means, without express prior written agreement is prohibited.
+ */
+
+/**
+ * Benchmarks of the parse, normalize, lookup and write paths of Fasta.hpp on synthetic
+ * inputs shaped like real data: one large chromosome, many short reads and a protein
+ * database with long headers. Each benchmark runs in a child process of its own, so the
+ * peak RSS reported is that of the benchmark alone.
+ *
+ * Build and run from this directory:
+ *   g++ -std=c++14 -O3 -march=native -pthread -I.. fasta_benchmark.cpp -o fasta_benchmark
+ *   ./fasta_benchmark [--scale=<factor>] [--repetitions=<count>] [--filter=<substring>] [--directory=<path>]
+ * Add -DFASTA_ENABLE_ZLIB and -lz to build with compressed input support.
+ *
+ * --scale multiplies the size of every input (default 1: a 100Mbp chromosome, 1M reads of
+ * 150bp and 200k proteins); --repetitions runs each benchmark several times and reports the
+ * fastest run; --filter runs only the benchmarks whose name contains the substring; and
+ * --directory is where the input files are written (default: the working directory).
+ */
+#include "Fasta.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+/**
+ * Measurements of one benchmark run.
+ */
+struct Result
+{
+	double seconds;    // Wall time of the measured section.
+	double bytes;      // Bytes processed by the measured section.
+	double records;    // Records processed by the measured section.
+	double peakRss;    // Peak resident set size of the process in bytes.
+};
+
+/**
+ * A synthetic input, written out as a FastA file.
+ */
+struct Dataset
+{
+	std::string name;     // Name of the dataset.
+	std::string filename; // The FastA file holding the dataset.
+	size_t bytes;         // Size of the file in bytes.
+	size_t records;       // Number of records in the file.
+};
+
+using Benchmark = std::function< void( const Dataset&, Result& ) >;
+
+double now()
+{
+	return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+double peakRss()
+{
+	struct rusage usage;
+	getrusage( RUSAGE_SELF, &usage );
+
+#if defined( __APPLE__ )
+	return static_cast< double >( usage.ru_maxrss );
+#else
+	return static_cast< double >( usage.ru_maxrss ) * 1024.0;
+#endif
+}
+
+// Append a sequence as lines of lineLength characters.
+void appendLines(
+	std::string& output,
+	const std::string& sequence,
+	size_t lineLength )
+{
+	for ( size_t offset( 0 ); offset < sequence.length(); offset += lineLength )
+	{
+		output.append( sequence, offset, lineLength );
+		output.push_back( '\n' );
+	}
+}
+
+// Random nucleotides with runs of N and soft-masked (lower case) stretches, as in assemblies.
+std::string randomNucleotides(
+	std::mt19937_64& generator,
+	size_t length,
+	bool isMasked )
+{
+	std::string sequence( length, 'A' );
+	size_t offset( 0 );
+
+	while ( offset < length )
+	{
+		const size_t runLength = std::min( length - offset, static_cast< size_t >( 1000 + generator() % 20000 ) );
+		const unsigned kind = isMasked ? generator() % 20 : 0;
+
+		for ( size_t index( offset ); index < offset + runLength; ++index )
+		{
+			sequence[ index ] = ( 0 == kind ) ? "ACGT"[ generator() & 3 ]
+				: ( ( 1 == kind ) ? 'N' : ( ( kind < 8 ) ? "acgt"[ generator() & 3 ] : "ACGT"[ generator() & 3 ] ) );
+		}
+
+		offset += runLength;
+	}
+
+	return sequence;
+}
+
+bool writeDataset(
+	Dataset& dataset,
+	const std::string& contents,
+	size_t records )
+{
+	FILE* file = std::fopen( dataset.filename.c_str(), "wb" );
+
+	if ( nullptr == file )
+	{
+		return false;
+	}
+
+	const bool isWritten = contents.length() == std::fwrite( contents.data(), 1, contents.length(), file );
+
+	dataset.bytes = contents.length();
+	dataset.records = records;
+
+	return ( 0 == std::fclose( file ) ) and isWritten;
+}
+
+bool makeChromosome(
+	Dataset& dataset,
+	double scale )
+{
+	std::mt19937_64 generator( 1 );
+	std::string contents( ">chr1 synthetic chromosome\n" );
+
+	appendLines( contents, randomNucleotides( generator, static_cast< size_t >( 100e6 * scale ), true ), 60 );
+
+	return writeDataset( dataset, contents, 1 );
+}
+
+bool makeReads(
+	Dataset& dataset,
+	double scale )
+{
+	std::mt19937_64 generator( 2 );
+	const size_t readCount = static_cast< size_t >( 1e6 * scale );
+	std::string contents;
+
+	contents.reserve( readCount * 180 );
+
+	for ( size_t read( 0 ); read < readCount; ++read )
+	{
+		contents += ">SRR0000001." + std::to_string( read + 1 ) + " " + std::to_string( read + 1 ) + "/1\n";
+		appendLines( contents, randomNucleotides( generator, 150, false ), 150 );
+	}
+
+	return writeDataset( dataset, contents, readCount );
+}
+
+bool makeProteins(
+	Dataset& dataset,
+	double scale )
+{
+	static const char aminoAcids[] = "ACDEFGHIKLMNPQRSTVWY";
+	std::mt19937_64 generator( 3 );
+	const size_t proteinCount = static_cast< size_t >( 2e5 * scale );
+	std::string contents;
+	std::string sequence;
+
+	for ( size_t protein( 0 ); protein < proteinCount; ++protein )
+	{
+		const std::string accession = "P" + std::to_string( 10000 + protein );
+
+		contents += ">sp|" + accession + "|PROT" + std::to_string( protein ) + "_HUMAN Uncharacterized protein "
+			+ std::to_string( protein ) + " involved in synthetic benchmark data OS=Homo sapiens OX=9606 GN=GENE"
+			+ std::to_string( protein ) + " PE=1 SV=" + std::to_string( 1 + protein % 3 ) + "\n";
+		sequence.resize( 50 + generator() % 700 );
+
+		for ( char& aminoAcid : sequence )
+		{
+			aminoAcid = aminoAcids[ generator() % 20 ];
+		}
+
+		appendLines( contents, sequence, 60 );
+	}
+
+	return writeDataset( dataset, contents, proteinCount );
+}
+
+// Load the dataset, outside the measured section.
+void load(
+	const Dataset& dataset,
+	FastaFile& fastaFile )
+{
+	if ( 0 != fastaFile.readFile( dataset.filename ) )
+	{
+		std::fprintf( stderr, "Failed to read %s\n", dataset.filename.c_str() );
+		std::exit( EXIT_FAILURE );
+	}
+}
+
+// The raw header lines and sequence lines of every record of the dataset.
+void loadRawRecords(
+	const Dataset& dataset,
+	std::vector< std::pair< std::string, std::string > >& records )
+{
+	std::ifstream inputFile( dataset.filename, std::ios::in | std::ios::binary );
+	std::string line;
+
+	while ( std::getline( inputFile, line ) )
+	{
+		if ( '>' == line[ 0 ] )
+		{
+			records.emplace_back( line, std::string() );
+		}
+		else if ( not records.empty() )
+		{
+			records.back().second += line + '\n';
+		}
+	}
+}
+
+void benchmarkReadFile(
+	const Dataset& dataset,
+	Result& result )
+{
+	FastaFile fastaFile;
+	const double start = now();
+
+	if ( 0 != fastaFile.readFile( dataset.filename ) )
+	{
+		std::exit( EXIT_FAILURE );
+	}
+
+	result.seconds = now() - start;
+	result.bytes = dataset.bytes;
+	result.records = dataset.records;
+}
+
+void benchmarkReadFileThreaded(
+	const Dataset& dataset,
+	Result& result )
+{
+	FastaFile fastaFile;
+	const double start = now();
+
+	if ( 0 != fastaFile.readFile( dataset.filename, true, 0 ) )
+	{
+		std::exit( EXIT_FAILURE );
+	}
+
+	result.seconds = now() - start;
+	result.bytes = dataset.bytes;
+	result.records = dataset.records;
+}
+
+void benchmarkMapFile(
+	const Dataset& dataset,
+	Result& result )
+{
+	FastaFile fastaFile;
+	const double start = now();
+
+	if ( 0 != fastaFile.mapFile( dataset.filename ) )
+	{
+		std::exit( EXIT_FAILURE );
+	}
+
+	result.seconds = now() - start;
+	result.bytes = dataset.bytes;
+	result.records = dataset.records;
+}
+
+void benchmarkReader(
+	const Dataset& dataset,
+	Result& result )
+{
+	FastaReader reader;
+	FastaSequence sequence;
+	size_t records( 0 );
+	const double start = now();
+
+	if ( 0 != reader.open( dataset.filename ) )
+	{
+		std::exit( EXIT_FAILURE );
+	}
+
+	while ( reader.read( sequence ) )
+	{
+		++records;
+	}
+
+	result.seconds = now() - start;
+	result.bytes = dataset.bytes;
+	result.records = records;
+}
+
+void benchmarkWriteFile(
+	const Dataset& dataset,
+	Result& result )
+{
+	const std::string filename = dataset.filename + ".out";
+	FastaFile fastaFile;
+
+	load( dataset, fastaFile );
+
+	const double start = now();
+
+	if ( 0 != fastaFile.writeFile( filename, 60 ) )
+	{
+		std::exit( EXIT_FAILURE );
+	}
+
+	result.seconds = now() - start;
+	result.bytes = dataset.bytes;
+	result.records = dataset.records;
+	std::remove( filename.c_str() );
+}
+
+void benchmarkNormalizeSequence(
+	const Dataset& dataset,
+	Result& result )
+{
+	std::vector< std::pair< std::string, std::string > > records;
+	FastaSequence sequence;
+	double bytes( 0 );
+
+	loadRawRecords( dataset, records );
+
+	const double start = now();
+
+	for ( const auto& record : records )
+	{
+		sequence.setSequence( record.second );
+		bytes += record.second.length();
+	}
+
+	result.seconds = now() - start;
+	result.bytes = bytes;
+	result.records = records.size();
+}
+
+void benchmarkNormalizeIdentifier(
+	const Dataset& dataset,
+	Result& result )
+{
+	std::vector< std::pair< std::string, std::string > > records;
+	FastaSequence sequence;
+	double bytes( 0 );
+
+	loadRawRecords( dataset, records );
+
+	const double start = now();
+
+	for ( const auto& record : records )
+	{
+		sequence.setIdentifier( record.first );
+		bytes += record.first.length();
+	}
+
+	result.seconds = now() - start;
+	result.bytes = bytes;
+	result.records = records.size();
+}
+
+void benchmarkLookup(
+	const Dataset& dataset,
+	Result& result )
+{
+	FastaFile fastaFile;
+	std::vector< std::string > identifiers;
+	std::mt19937_64 generator( 4 );
+	size_t found( 0 );
+
+	load( dataset, fastaFile );
+
+	// Half hits in random order and half misses.
+	for ( const auto& sequence : fastaFile )
+	{
+		identifiers.push_back( sequence.identifier() );
+		identifiers.push_back( sequence.identifier() + "#" );
+	}
+
+	std::shuffle( identifiers.begin(), identifiers.end(), generator );
+
+	const double start = now();
+
+	for ( const auto& identifier : identifiers )
+	{
+		if ( fastaFile.hasIdentifier( identifier ) )
+		{
+			found += fastaFile.at( identifier ).size();
+		}
+	}
+
+	result.seconds = now() - start;
+	result.bytes = 0;
+	result.records = identifiers.size();
+
+	if ( found != dataset.records )
+	{
+		std::exit( EXIT_FAILURE );
+	}
+}
+
+void benchmarkIterate(
+	const Dataset& dataset,
+	Result& result )
+{
+	FastaFile fastaFile;
+	size_t length( 0 );
+	size_t records( 0 );
+
+	load( dataset, fastaFile );
+
+	const double start = now();
+
+	for ( auto iterator = fastaFile.cbegin(); iterator != fastaFile.cend(); ++iterator )
+	{
+		length += iterator->length();
+		++records;
+	}
+
+	result.seconds = now() - start;
+	result.bytes = length;
+	result.records = records;
+}
+
+// Run the benchmark in a child process, returning the fastest of the repetitions.
+bool run(
+	const Benchmark& benchmark,
+	const Dataset& dataset,
+	size_t repetitions,
+	Result& result )
+{
+	result.seconds = -1;
+
+	for ( size_t repetition( 0 ); repetition < repetitions; ++repetition )
+	{
+		int pipeDescriptors[ 2 ];
+		Result childResult = {};
+
+		if ( 0 != pipe( pipeDescriptors ) )
+		{
+			return false;
+		}
+
+		const pid_t child = fork();
+
+		if ( 0 == child )
+		{
+			close( pipeDescriptors[ 0 ] );
+			benchmark( dataset, childResult );
+			childResult.peakRss = peakRss();
+			const bool isWritten = static_cast< ssize_t >( sizeof( childResult ) )
+				== write( pipeDescriptors[ 1 ], &childResult, sizeof( childResult ) );
+			_exit( isWritten ? EXIT_SUCCESS : EXIT_FAILURE );
+		}
+
+		close( pipeDescriptors[ 1 ] );
+
+		const bool isRead = ( 0 < child )
+			and ( static_cast< ssize_t >( sizeof( childResult ) ) == read( pipeDescriptors[ 0 ], &childResult, sizeof( childResult ) ) );
+		int status( 0 );
+
+		close( pipeDescriptors[ 0 ] );
+
+		if ( ( 0 >= child ) or ( child != waitpid( child, &status, 0 ) ) or not isRead )
+		{
+			return false;
+		}
+
+		if ( ( 0 > result.seconds ) or ( childResult.seconds < result.seconds ) )
+		{
+			result = childResult;
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+int main(
+	int argc,
+	char** argv )
+{
+	double scale( 1 );
+	size_t repetitions( 1 );
+	std::string filter;
+	std::string directory( "." );
+
+	for ( int argument( 1 ); argument < argc; ++argument )
+	{
+		const std::string option( argv[ argument ] );
+		const size_t equals = option.find( '=' );
+		const std::string value = ( std::string::npos == equals ) ? std::string() : option.substr( equals + 1 );
+
+		if ( 0 == option.compare( 0, equals, "--scale" ) )
+		{
+			scale = std::atof( value.c_str() );
+		}
+		else if ( 0 == option.compare( 0, equals, "--repetitions" ) )
+		{
+			repetitions = std::max( std::strtoul( value.c_str(), nullptr, 10 ), 1ul );
+		}
+		else if ( 0 == option.compare( 0, equals, "--filter" ) )
+		{
+			filter = value;
+		}
+		else if ( 0 == option.compare( 0, equals, "--directory" ) )
+		{
+			directory = value;
+		}
+		else
+		{
+			std::fprintf( stderr, "usage: %s [--scale=<factor>] [--repetitions=<count>] [--filter=<substring>] [--directory=<path>]\n", argv[ 0 ] );
+			return EXIT_FAILURE;
+		}
+	}
+
+	const std::vector< std::pair< std::string, std::function< bool( Dataset&, double ) > > > datasetMakers = {
+		{ "chromosome", makeChromosome },
+		{ "reads", makeReads },
+		{ "proteins", makeProteins } };
+
+	const std::vector< std::pair< std::string, Benchmark > > benchmarks = {
+		{ "readFile", benchmarkReadFile },
+		{ "readFile/threads", benchmarkReadFileThreaded },
+		{ "mapFile", benchmarkMapFile },
+		{ "FastaReader", benchmarkReader },
+		{ "writeFile", benchmarkWriteFile },
+		{ "normalizeSequence", benchmarkNormalizeSequence },
+		{ "normalizeIdentifier", benchmarkNormalizeIdentifier },
+		{ "at/hasIdentifier", benchmarkLookup },
+		{ "iterate", benchmarkIterate } };
+
+	static const char* const levelNames[] = { "scalar", "sse2", "ssse3", "avx2", "neon" };
+
+	std::printf( "kernels: %s, hardware threads: %u\n",
+		levelNames[ static_cast< int >( FastaKernels::level() ) ], std::thread::hardware_concurrency() );
+	std::printf( "%-32s %10s %12s %14s %12s\n", "benchmark", "seconds", "MB/s", "records/s", "peak RSS MB" );
+
+	for ( const auto& datasetMaker : datasetMakers )
+	{
+		Dataset dataset;
+		bool isMade( false );
+
+		dataset.name = datasetMaker.first;
+		dataset.filename = directory + "/fasta_benchmark_" + dataset.name + ".fa";
+
+		for ( const auto& benchmark : benchmarks )
+		{
+			const std::string name = dataset.name + "/" + benchmark.first;
+			Result result = {};
+
+			if ( std::string::npos == name.find( filter ) )
+			{
+				continue;
+			}
+
+			if ( not isMade and not ( isMade = datasetMaker.second( dataset, scale ) ) )
+			{
+				std::fprintf( stderr, "Failed to write %s\n", dataset.filename.c_str() );
+				return EXIT_FAILURE;
+			}
+
+			if ( not run( benchmark.second, dataset, repetitions, result ) )
+			{
+				std::fprintf( stderr, "%s failed\n", name.c_str() );
+				return EXIT_FAILURE;
+			}
+
+			std::printf( "%-32s %10.4f %12.1f %14.0f %12.1f\n", name.c_str(), result.seconds,
+				result.bytes / result.seconds / 1e6, result.records / result.seconds, result.peakRss / 1e6 );
+			std::fflush( stdout );
+		}
+
+		if ( isMade )
+		{
+			std::remove( dataset.filename.c_str() );
+		}
+	}
+
+	return EXIT_SUCCESS;
+}